@@ -0,0 +1,100 @@
+// This file is part of the VroomJs library.
+//
+// Author:
+//     Federico Di Gregorio <fog@initd.org>
+//
+// Copyright (c) 2013 
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+using System;
+using NUnit.Framework;
+
+namespace VroomJs.Tests
+{
+    // Results built while a managed callback calls back into the same
+    // context: each call must hand out memory of its own.
+    [TestFixture]
+    public class Arenas
+    {
+        JsEngine js;
+        JsContext context;
+
+        [SetUp]
+        public void Setup()
+        {
+            js = new JsEngine();
+            context = js.CreateContext();
+        }
+
+        [TearDown]
+        public void Teardown()
+        {
+            context.Dispose();
+            js.Dispose();
+        }
+
+        [Test]
+        public void SetVariableErrorFromCallback()
+        {
+            string message = null;
+            context.SetVariable("host", new Callback(() => {
+                try {
+                    context.SetVariable(-1, 42);
+                } catch (JsException e) {
+                    message = e.Message;
+                }
+            }));
+            object r = context.Execute("var s = ['a', 'b'].join('-'); host.Run(); [s, s + '!']");
+            Assert.That(message, Is.EqualTo("unknown name atom"));
+            Assert.That(r, Is.AssignableTo<object[]>());
+            var a = (object[])r;
+            Assert.That(a[0], Is.EqualTo("a-b"));
+            Assert.That(a[1], Is.EqualTo("a-b!"));
+        }
+
+        [Test]
+        public void GetVariableFromCallback()
+        {
+            object inner = null;
+            context.Execute("var inner = ['x', 'y', 'z']");
+            context.SetVariable("host", new Callback(() => {
+                inner = context.GetVariable("inner");
+            }));
+            object outer = context.Execute("host.Run(); ['a', 'b']");
+            Assert.That(inner, Is.EqualTo(new object[] { "x", "y", "z" }));
+            Assert.That(outer, Is.EqualTo(new object[] { "a", "b" }));
+        }
+    }
+
+    public class Callback
+    {
+        readonly Action _action;
+
+        public Callback(Action action)
+        {
+            _action = action;
+        }
+
+        public void Run()
+        {
+            _action();
+        }
+    }
+}
@@ -0,0 +1,111 @@
+// This file is part of the VroomJs library.
+//
+// Author:
+//     Federico Di Gregorio <fog@initd.org>
+//
+// Copyright (c) 2013 
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+using System;
+using NUnit.Framework;
+
+namespace VroomJs.Tests
+{
+    [TestFixture]
+    public class Atoms
+    {
+        JsEngine js;
+        JsContext context;
+
+        [SetUp]
+        public void Setup()
+        {
+            js = new JsEngine();
+            context = js.CreateContext();
+        }
+
+        [TearDown]
+        public void Teardown()
+        {
+            context.Dispose();
+            js.Dispose();
+        }
+
+        [Test]
+        public void InternNameIsStable()
+        {
+            int a = js.InternName("price");
+            Assert.That(js.InternName("price"), Is.EqualTo(a));
+            Assert.That(js.InternName("amount"), Is.Not.EqualTo(a));
+        }
+
+        [Test]
+        public void AtomsWorkInEveryContext()
+        {
+            int x = js.InternName("x");
+            using (JsContext other = js.CreateContext()) {
+                context.SetVariable(x, 1);
+                other.SetVariable(x, 2);
+                Assert.That(context.GetVariable("x"), Is.EqualTo(1));
+                Assert.That(other.GetVariable(x), Is.EqualTo(2));
+            }
+        }
+
+        [Test]
+        public void PropertyValues()
+        {
+            int a = js.InternName("a");
+            int b = js.InternName("b");
+            var obj = (JsObject)context.Execute("({ a: 1, b: 'two', f: function (x) { return this.a + x; } })");
+
+            Assert.That(context.GetPropertyValue(obj, a), Is.EqualTo(1));
+            context.SetPropertyValue(obj, a, 10);
+            Assert.That(context.GetPropertyValues(obj, new[] { a, b }), Is.EqualTo(new object[] { 10, "two" }));
+
+            context.SetPropertyValues(obj, new[] { a, b }, new object[] { 20, "three" });
+            Assert.That(context.GetPropertyValue(obj, b), Is.EqualTo("three"));
+            Assert.That(context.InvokeProperty(obj, js.InternName("f"), new object[] { 2 }), Is.EqualTo(22));
+        }
+
+        [Test]
+        public void NameWithLoneSurrogate()
+        {
+            int atom = js.InternName("a\uD800");
+            context.SetVariable(atom, 5);
+            Assert.That(context.GetVariable("a\uD800"), Is.EqualTo(5));
+        }
+
+        [Test]
+        [ExpectedException(typeof(JsException))]
+        public void UnknownAtom()
+        {
+            context.GetVariable(12345);
+        }
+
+        [Test]
+        public void UnknownAtomInBatch()
+        {
+            int a = js.InternName("a");
+            var obj = (JsObject)context.Execute("({ a: 1 })");
+            var e = Assert.Throws<JsException>(() => context.GetPropertyValues(obj, new[] { a, -1 }));
+            Assert.That(e.Message, Is.EqualTo("unknown name atom"));
+        }
+    }
+}
@@ -0,0 +1,122 @@
+// This file is part of the VroomJs library.
+//
+// Author:
+//     Federico Di Gregorio <fog@initd.org>
+//
+// Copyright (c) 2013 
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+using System;
+using NUnit.Framework;
+
+namespace VroomJs.Tests
+{
+    [TestFixture]
+    public class Buffers
+    {
+        JsEngine js;
+        JsContext context;
+
+        [SetUp]
+        public void Setup()
+        {
+            js = new JsEngine();
+            context = js.CreateContext();
+        }
+
+        [TearDown]
+        public void Teardown()
+        {
+            if (!context.IsDisposed)
+                context.Dispose();
+            js.Dispose();
+        }
+
+        [Test]
+        public void BareArraysAreManaged()
+        {
+            var data = new int[] { 1, 2, 3 };
+            context.SetVariable("data", data);
+            Assert.That(context.Execute("Array.isArray(data)"), Is.EqualTo(false));
+            Assert.That(context.Execute("data.Length"), Is.EqualTo(3));
+            context.Execute("data[0] = 10");
+            Assert.That(data[0], Is.EqualTo(10));
+            Assert.That(context.Execute("data"), Is.SameAs(data));
+            Assert.That(context.GetStats().PinnedBuffers, Is.EqualTo(0));
+        }
+
+        [Test]
+        public void WritesAreShared()
+        {
+            var data = new double[] { 1.5, 2.5, 3.5 };
+            context.SetVariable("data", new JsBuffer(data));
+            Assert.That(context.GetStats().PinnedBuffers, Is.EqualTo(1));
+            Assert.That(context.Execute("data.length"), Is.EqualTo(3));
+
+            context.Execute("data[0] = 10");
+            Assert.That(data[0], Is.EqualTo(10.0));
+
+            data[1] = 20;
+            Assert.That(context.Execute("data[1]"), Is.EqualTo(20));
+        }
+
+        [Test]
+        public void ComesBackAsTheSameArray()
+        {
+            var data = new byte[] { 1, 2, 3 };
+            context.SetVariable("data", new JsBuffer(data));
+            Assert.That(context.Execute("data"), Is.SameAs(data));
+        }
+
+        [Test]
+        public void PinnedOnce()
+        {
+            var data = new float[16];
+            context.SetVariable("a", new JsBuffer(data));
+            context.SetVariable("b", new JsBuffer(data));
+            Assert.That(context.GetStats().PinnedBuffers, Is.EqualTo(1));
+        }
+
+        [Test]
+        public void ReleasedWhenCollected()
+        {
+            context.SetVariable("data", new JsBuffer(new int[1024]));
+            context.Execute("data = null");
+            for (int i = 0; i < 10 && context.GetStats().PinnedBuffers > 0; i++)
+                context.Flush();
+            Assert.That(context.GetStats().PinnedBuffers, Is.EqualTo(0));
+        }
+
+        [Test]
+        public void ReleasedOnDispose()
+        {
+            context.SetVariable("data", new JsBuffer(new int[1024]));
+            context.Dispose();
+            Assert.That(context.GetStats().PinnedBuffers, Is.EqualTo(0));
+        }
+
+        [Test]
+        [ExpectedException(typeof(ArgumentException))]
+        public void OnlyNumbers()
+        {
+            new JsBuffer(new string[1]);
+        }
+    }
+}
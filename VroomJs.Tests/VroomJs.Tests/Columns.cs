@@ -0,0 +1,116 @@
+// This file is part of the VroomJs library.
+//
+// Author:
+//     Federico Di Gregorio <fog@initd.org>
+//
+// Copyright (c) 2013 
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+using System;
+using NUnit.Framework;
+
+namespace VroomJs.Tests
+{
+    [TestFixture]
+    public class Columns
+    {
+        const string Records = "[{ id: 1, name: 'a', score: 0.5 }, { id: 2, name: 'b', score: 1.5 }]";
+
+        JsEngine js;
+        JsContext context;
+
+        [SetUp]
+        public void Setup()
+        {
+            js = new JsEngine();
+            context = js.CreateContext();
+        }
+
+        [TearDown]
+        public void Teardown()
+        {
+            context.Dispose();
+            js.Dispose();
+        }
+
+        [Test]
+        public void DeclaredKeys()
+        {
+            var columns = (JsColumns)context.ExecuteColumns(Records, new[] { "id", "name", "score" });
+            Assert.That(columns.Count, Is.EqualTo(2));
+            Assert.That(columns.Names, Is.EqualTo(new[] { "id", "name", "score" }));
+            Assert.That(columns.GetColumn("id"), Is.EqualTo(new[] { 1, 2 }));
+            Assert.That(columns.GetColumn("name"), Is.EqualTo(new object[] { "a", "b" }));
+            Assert.That(columns.GetColumn("score"), Is.EqualTo(new[] { 0.5, 1.5 }));
+            Assert.That(columns[1, "name"], Is.EqualTo("b"));
+        }
+
+        [Test]
+        public void MissingKeyIsNull()
+        {
+            var columns = (JsColumns)context.ExecuteColumns(Records, new[] { "id", "city" });
+            Assert.That(columns.GetColumn("city"), Is.EqualTo(new object[] { null, null }));
+        }
+
+        [Test]
+        public void NotRecords()
+        {
+            Assert.That(context.ExecuteColumns("[1, 2]", new[] { "id" }), Is.EqualTo(new object[] { 1, 2 }));
+            Assert.That(context.ExecuteColumns("'x'", new[] { "id" }), Is.EqualTo("x"));
+        }
+
+        [Test]
+        public void Modes()
+        {
+            Assert.That(context.ExecuteColumns(Records, new[] { "id" }, JsResultMode.Discard), Is.Null);
+            Assert.That(context.ExecuteColumns(Records, new[] { "id" }, JsResultMode.Full), Is.InstanceOf<JsColumns>());
+            using (var h = (JsHandle)context.ExecuteColumns(Records, new[] { "id" }, JsResultMode.Handle))
+                Assert.That(h.Length, Is.EqualTo(2));
+        }
+
+        [Test]
+        [ExpectedException(typeof(JsException))]
+        public void PolicyNodeLimit()
+        {
+            JsMarshalPolicy policy = JsMarshalPolicy.Default;
+            policy.MaxNodes = 4;
+            context.ExecuteColumns(Records, new[] { "id", "name", "score" }, policy);
+        }
+
+        [Test]
+        [ExpectedException(typeof(JsException))]
+        public void PolicyStringLimitOnKeys()
+        {
+            JsMarshalPolicy policy = JsMarshalPolicy.Default;
+            policy.MaxStringLength = 8;
+            context.ExecuteColumns("[{ aVeryLongKeyName: 1 }]", new[] { "aVeryLongKeyName" }, policy);
+        }
+
+        [Test]
+        public void ColumnarResults()
+        {
+            JsMarshalPolicy policy = JsMarshalPolicy.Default;
+            policy.MarshalType = JsObjectMarshalType.Dictionary;
+            policy.Flags |= JsMarshalFlags.ColumnarResults;
+            var columns = (JsColumns)context.Execute(Records, policy);
+            Assert.That(columns.Names, Is.EqualTo(new[] { "id", "name", "score" }));
+        }
+    }
+}
@@ -0,0 +1,123 @@
+// This file is part of the VroomJs library.
+//
+// Author:
+//     Federico Di Gregorio <fog@initd.org>
+//
+// Copyright (c) 2013 
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+using System;
+using NUnit.Framework;
+
+namespace VroomJs.Tests
+{
+    [TestFixture]
+    public class ContextReset
+    {
+        JsEngine js;
+        JsContext context;
+
+        [SetUp]
+        public void Setup()
+        {
+            js = new JsEngine();
+            context = js.CreateContext();
+        }
+
+        [TearDown]
+        public void Teardown()
+        {
+            context.Dispose();
+            js.Dispose();
+        }
+
+        [Test]
+        public void FirstResetCapturesBaseline()
+        {
+            Assert.That(context.Reset(), Is.False);
+        }
+
+        [Test]
+        public void GlobalsAreDropped()
+        {
+            context.Reset();
+            context.Execute("var a = 1; function f() {} b = 2; this.c = 3");
+            context.SetVariable("d", 4);
+            Assert.That(context.Reset(), Is.True);
+            Assert.That(context.Execute("typeof a + typeof f + typeof b + typeof c + typeof d"),
+                Is.EqualTo("undefinedundefinedundefinedundefinedundefined"));
+        }
+
+        [Test]
+        public void PatchedBuiltinStartsOver()
+        {
+            context.Reset();
+            context.Execute("Array.prototype.leak = function () { return 1; }");
+            Assert.That(context.Reset(), Is.False);
+            Assert.That(context.Execute("typeof [].leak"), Is.EqualTo("undefined"));
+        }
+
+        [Test]
+        public void ReplacedBuiltinStartsOver()
+        {
+            context.Reset();
+            context.Execute("JSON.stringify = function () { return 'x'; }");
+            Assert.That(context.Reset(), Is.False);
+            Assert.That(context.Execute("JSON.stringify(1)"), Is.EqualTo("1"));
+        }
+
+        [Test]
+        public void ExpandoOnBuiltinMethodStartsOver()
+        {
+            context.Reset();
+            context.Execute("Array.prototype.push.x = 1");
+            Assert.That(context.Execute("Array.prototype.push.x"), Is.EqualTo(1));
+            Assert.That(context.Reset(), Is.False);
+            Assert.That(context.Execute("typeof Array.prototype.push.x"), Is.EqualTo("undefined"));
+        }
+
+        [Test]
+        public void RecycledBuiltinsMatchFresh()
+        {
+            const string builtins =
+                "[Array.prototype.map, Array.prototype.push, Object.keys, JSON.stringify, Math.max, String.prototype.slice, Array, Object]" +
+                ".map(function (f) { return Object.isExtensible(f) + ':' + Object.getOwnPropertyNames(f).sort().join(','); }).join(';')";
+
+            object fresh;
+            using (JsContext other = js.CreateContext())
+                fresh = other.Execute(builtins);
+
+            context.Reset();
+            context.Execute("var a = 1");
+            Assert.That(context.Reset(), Is.True);
+            Assert.That(context.Execute(builtins), Is.EqualTo(fresh));
+        }
+
+        [Test]
+        public void ManyResets()
+        {
+            for (int i = 0; i < 10; i++) {
+                context.Reset();
+                context.Execute("var n = " + i);
+                Assert.That(context.Execute("n"), Is.EqualTo(i));
+            }
+        }
+    }
+}
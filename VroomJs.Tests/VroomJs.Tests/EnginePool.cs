@@ -0,0 +1,106 @@
+// This file is part of the VroomJs library.
+//
+// Author:
+//     Federico Di Gregorio <fog@initd.org>
+//
+// Copyright (c) 2013 
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+using System;
+using NUnit.Framework;
+
+namespace VroomJs.Tests
+{
+    [TestFixture]
+    public class EnginePool
+    {
+        JsEnginePool pool;
+
+        [SetUp]
+        public void Setup()
+        {
+            pool = new JsEnginePool(1, 2);
+        }
+
+        [TearDown]
+        public void Teardown()
+        {
+            pool.Dispose();
+        }
+
+        [Test]
+        public void AcquireAndRelease()
+        {
+            using (JsEngine js = pool.Acquire()) {
+                Assert.That(pool.GetStats().Leased, Is.EqualTo(1));
+                using (JsContext context = js.CreateContext())
+                    Assert.That(context.Execute("1 + 1"), Is.EqualTo(2));
+            }
+            JsEnginePoolStats stats = pool.GetStats();
+            Assert.That(stats.Leased, Is.EqualTo(0));
+            Assert.That(stats.Recycled, Is.EqualTo(1));
+            Assert.That(stats.Hits + stats.Misses, Is.EqualTo(1));
+        }
+
+        [Test]
+        public void CallbacksInPooledEngine()
+        {
+            // Engines from the pool get the same delegates as new ones.
+            using (JsEngine js = pool.Acquire())
+            using (JsContext context = js.CreateContext()) {
+                context.SetVariable("o", new TestClass { Int32Property = 3 });
+                Assert.That(context.Execute("o.Int32Property"), Is.EqualTo(3));
+                Assert.That(context.Execute("o.Method1(1, 'x').Int32Property"), Is.EqualTo(4));
+                Assert.That(context.Execute("[1, 2].length"), Is.EqualTo(2));
+            }
+        }
+
+        [Test]
+        public void NothingLeftFromThePreviousLease()
+        {
+            using (JsEngine js = pool.Acquire())
+            using (JsContext context = js.CreateContext())
+                context.Execute("var leftover = 1");
+
+            using (JsEngine js = pool.Acquire())
+            using (JsContext context = js.CreateContext())
+                Assert.That(context.Execute("typeof leftover"), Is.EqualTo("undefined"));
+        }
+
+        [Test]
+        public void ContextsDisposedWithTheEngine()
+        {
+            JsEngine js = pool.Acquire();
+            JsContext context = js.CreateContext();
+            context.Execute("var a = 1");
+            js.Dispose();
+            Assert.That(pool.GetStats().Recycled, Is.EqualTo(1));
+        }
+
+        [Test]
+        [ExpectedException(typeof(ObjectDisposedException))]
+        public void AcquireFromDisposedPool()
+        {
+            var other = new JsEnginePool(0, 1);
+            other.Dispose();
+            other.Acquire();
+        }
+    }
+}
@@ -0,0 +1,116 @@
+// This file is part of the VroomJs library.
+//
+// Author:
+//     Federico Di Gregorio <fog@initd.org>
+//
+// Copyright (c) 2013 
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+using System;
+using System.Collections.Generic;
+using NUnit.Framework;
+
+namespace VroomJs.Tests
+{
+    [TestFixture]
+    public class FlatResults
+    {
+        JsEngine js;
+        JsContext context;
+        JsMarshalPolicy flat;
+
+        [SetUp]
+        public void Setup()
+        {
+            js = new JsEngine();
+            context = js.CreateContext();
+            flat = JsMarshalPolicy.Default;
+            flat.MarshalType = JsObjectMarshalType.Dictionary;
+            flat.Flags |= JsMarshalFlags.FlatResults;
+        }
+
+        [TearDown]
+        public void Teardown()
+        {
+            JsEngine.FlatResults = false;
+            context.Dispose();
+            js.Dispose();
+        }
+
+        [Test]
+        public void Primitives()
+        {
+            Assert.That(context.Execute("42", flat), Is.EqualTo(42));
+            Assert.That(context.Execute("'text'", flat), Is.EqualTo("text"));
+            Assert.That(context.Execute("null", flat), Is.Null);
+        }
+
+        [Test]
+        public void Arrays()
+        {
+            object res = context.Execute("[1, 2.5, 'three', true, null, [4, ['five']]]", flat);
+            Assert.That(res, Is.EqualTo(new object[] { 1, 2.5, "three", true, null, new object[] { 4, new object[] { "five" } } }));
+        }
+
+        [Test]
+        public void Objects()
+        {
+            var res = (Dictionary<string, object>)context.Execute("({ a: 1, b: 'two', c: { d: [3] } })", flat);
+            Assert.That(res.Count, Is.EqualTo(3));
+            Assert.That(res["a"], Is.EqualTo(1));
+            Assert.That(res["b"], Is.EqualTo("two"));
+            var c = (Dictionary<string, object>)res["c"];
+            Assert.That(c["d"], Is.EqualTo(new object[] { 3 }));
+        }
+
+        [Test]
+        public void SameAsTheTree()
+        {
+            string code = "var r = []; for (var i = 0; i < 100; i++) r.push([i, 'item ' + i, i / 2]); r";
+            JsMarshalPolicy tree = flat;
+            tree.Flags &= ~JsMarshalFlags.FlatResults;
+            Assert.That(context.Execute(code, flat), Is.EqualTo(context.Execute(code, tree)));
+        }
+
+        [Test]
+        public void WithPackedArrays()
+        {
+            flat.Flags |= JsMarshalFlags.PackedArrays;
+            object[] res = (object[])context.Execute("[[1, 2], [0.5], ['a']]", flat);
+            Assert.That(res[0], Is.EqualTo(new int[] { 1, 2 }));
+            Assert.That(res[1], Is.EqualTo(new double[] { 0.5 }));
+            Assert.That(res[2], Is.EqualTo(new object[] { "a" }));
+        }
+
+        [Test]
+        public void Engine()
+        {
+            JsEngine.FlatResults = true;
+            Assert.That(context.Execute("[1, ['two']]"), Is.EqualTo(new object[] { 1, new object[] { "two" } }));
+        }
+
+        [Test]
+        [ExpectedException(typeof(JsException))]
+        public void Errors()
+        {
+            context.Execute("[1, (function () { throw new Error('no') })()]", flat);
+        }
+    }
+}
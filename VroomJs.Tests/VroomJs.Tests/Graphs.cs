@@ -0,0 +1,105 @@
+// This file is part of the VroomJs library.
+//
+// Author:
+//     Federico Di Gregorio <fog@initd.org>
+//
+// Copyright (c) 2013 
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+using System;
+using NUnit.Framework;
+
+namespace VroomJs.Tests
+{
+    [TestFixture]
+    public class Graphs
+    {
+        JsEngine js;
+        JsContext context;
+
+        [SetUp]
+        public void Setup()
+        {
+            js = new JsEngine();
+            context = js.CreateContext();
+        }
+
+        [TearDown]
+        public void Teardown()
+        {
+            context.Dispose();
+            js.Dispose();
+        }
+
+        [Test]
+        public void Cycle()
+        {
+            var a = (object[])context.Execute("var a = [1]; a.push(a); a");
+            Assert.That(a[0], Is.EqualTo(1));
+            Assert.That(a[1], Is.SameAs(a));
+        }
+
+        [Test]
+        public void SharedCopiedByDefault()
+        {
+            var r = (object[])context.Execute("var o = [1, 2]; [o, o]");
+            Assert.That(r[0], Is.EqualTo(r[1]));
+            Assert.That(r[0], Is.Not.SameAs(r[1]));
+        }
+
+        [Test]
+        public void SharedObjects()
+        {
+            JsMarshalPolicy policy = JsMarshalPolicy.Default;
+            policy.Flags |= JsMarshalFlags.SharedObjects;
+            var r = (object[])context.Execute("var o = [1, 2]; [o, o, [o]]", policy);
+            Assert.That(r[0], Is.EqualTo(new object[] { 1, 2 }));
+            Assert.That(r[1], Is.SameAs(r[0]));
+            Assert.That(((object[])r[2])[0], Is.SameAs(r[0]));
+        }
+
+        [Test]
+        [ExpectedException(typeof(JsException))]
+        public void MaxDepth()
+        {
+            JsMarshalPolicy policy = JsMarshalPolicy.Default;
+            policy.MaxDepth = 2;
+            context.Execute("[[[[1]]]]", policy);
+        }
+
+        [Test]
+        [ExpectedException(typeof(JsException))]
+        public void MaxNodes()
+        {
+            JsMarshalPolicy policy = JsMarshalPolicy.Default;
+            policy.MaxNodes = 10;
+            context.Execute("var a = []; for (var i = 0; i < 100; i++) a.push(i); a", policy);
+        }
+
+        [Test]
+        public void WithinLimits()
+        {
+            JsMarshalPolicy policy = JsMarshalPolicy.Default;
+            policy.MaxDepth = 4;
+            policy.MaxNodes = 10;
+            Assert.That(context.Execute("[[1], [2, 3]]", policy), Is.EqualTo(new object[] { new object[] { 1 }, new object[] { 2, 3 } }));
+        }
+    }
+}
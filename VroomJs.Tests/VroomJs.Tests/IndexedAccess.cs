@@ -0,0 +1,123 @@
+// This file is part of the VroomJs library.
+//
+// Author:
+//     Federico Di Gregorio <fog@initd.org>
+//
+// Copyright (c) 2013 
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+using System;
+using System.Collections;
+using System.Collections.Generic;
+using NUnit.Framework;
+
+namespace VroomJs.Tests
+{
+    [TestFixture]
+    public class IndexedAccess
+    {
+        JsEngine js;
+        JsContext context;
+
+        [SetUp]
+        public void Setup()
+        {
+            js = new JsEngine();
+            context = js.CreateContext();
+        }
+
+        [TearDown]
+        public void Teardown()
+        {
+            context.Dispose();
+            js.Dispose();
+        }
+
+        [Test]
+        public void Read()
+        {
+            context.SetVariable("list", new List<string> { "a", "b", "c" });
+            Assert.That(context.Execute("list[0] + list[2]"), Is.EqualTo("ac"));
+            Assert.That(context.Execute("list.length"), Is.EqualTo(3));
+        }
+
+        [Test]
+        public void Loop()
+        {
+            context.SetVariable("list", new List<int> { 1, 2, 3, 4 });
+            Assert.That(context.Execute("var s = 0; for (var i = 0; i < list.length; i++) s += list[i]; s"), Is.EqualTo(10));
+        }
+
+        [Test]
+        public void WriteConvertsToElementType()
+        {
+            var list = new List<long> { 1, 2 };
+            context.SetVariable("list", list);
+            context.Execute("list[1] = 20");
+            Assert.That(list[1], Is.EqualTo(20L));
+        }
+
+        [Test]
+        public void WriteOnePastTheEndAppends()
+        {
+            var list = new ArrayList { "a" };
+            context.SetVariable("list", list);
+            context.Execute("list[1] = 'b'");
+            Assert.That(list.Count, Is.EqualTo(2));
+            Assert.That(list[1], Is.EqualTo("b"));
+        }
+
+        [Test]
+        public void OutOfRangeIsUndefined()
+        {
+            context.SetVariable("list", new List<int> { 1 });
+            Assert.That(context.Execute("typeof list[5]"), Is.EqualTo("undefined"));
+        }
+
+        [Test]
+        public void Enumerate()
+        {
+            context.SetVariable("list", new List<string> { "x", "y" });
+            // Members come along, the indexes must be there too.
+            Assert.That(context.Execute("var k = []; for (var i in list) k.push(i); k.indexOf('0') >= 0 && k.indexOf('1') >= 0"), Is.EqualTo(true));
+        }
+
+        [Test]
+        public void DictionaryWithNumericKeys()
+        {
+            var dict = new Dictionary<string, object> { { "1", "one" } };
+            context.SetVariable("dict", dict);
+            Assert.That(context.Execute("dict[1]"), Is.EqualTo("one"));
+            Assert.That(context.Execute("dict['1']"), Is.EqualTo("one"));
+
+            context.Execute("dict[2] = 'two'");
+            Assert.That(dict["2"], Is.EqualTo("two"));
+            Assert.That(context.Execute("dict[2]"), Is.EqualTo("two"));
+        }
+
+        [Test]
+        public void RegisteredTypeCollection()
+        {
+            js.RegisterType(typeof(List<int>));
+            context.SetVariable("list", new List<int> { 5, 6 });
+            Assert.That(context.Execute("list[1] + list.count"), Is.EqualTo(8));
+        }
+    }
+}
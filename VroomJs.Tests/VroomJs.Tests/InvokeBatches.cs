@@ -0,0 +1,106 @@
+// This file is part of the VroomJs library.
+//
+// Author:
+//     Federico Di Gregorio <fog@initd.org>
+//
+// Copyright (c) 2013 
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+using System;
+using NUnit.Framework;
+
+namespace VroomJs.Tests
+{
+    [TestFixture]
+    public class InvokeBatches
+    {
+        JsEngine js;
+        JsContext context;
+
+        [SetUp]
+        public void Setup()
+        {
+            js = new JsEngine();
+            context = js.CreateContext();
+        }
+
+        [TearDown]
+        public void Teardown()
+        {
+            context.Dispose();
+            js.Dispose();
+        }
+
+        [Test]
+        public void OneResultPerCall()
+        {
+            using (var add = (JsFunction)context.Execute("(function (a, b) { return a + b; })")) {
+                object[] results = add.InvokeBatch(new[] {
+                    new object[] { 1, 2 },
+                    new object[] { "a", "b" },
+                    new object[] { 3 }
+                });
+                Assert.That(results.Length, Is.EqualTo(3));
+                Assert.That(results[0], Is.EqualTo(3));
+                Assert.That(results[1], Is.EqualTo("ab"));
+                Assert.That(results[2], Is.EqualTo(double.NaN));
+            }
+        }
+
+        [Test]
+        public void ThrowingCallKeepsItsError()
+        {
+            using (var f = (JsFunction)context.Execute("(function (x) { if (x < 0) throw new Error('negative'); return x; })")) {
+                object[] results = f.InvokeBatch(new[] {
+                    new object[] { 1 },
+                    new object[] { -1 },
+                    new object[] { 2 }
+                });
+                Assert.That(results[0], Is.EqualTo(1));
+                Assert.That(results[1], Is.InstanceOf<JsException>());
+                Assert.That(results[2], Is.EqualTo(2));
+            }
+        }
+
+        [Test]
+        public void Empty()
+        {
+            using (var f = (JsFunction)context.Execute("(function () { return 1; })"))
+                Assert.That(f.InvokeBatch(new object[0][]), Is.Empty);
+        }
+
+        [Test]
+        public void CallsRunInOrder()
+        {
+            using (var f = (JsFunction)context.Execute("var log = []; (function (x) { log.push(x); return log.length; })")) {
+                f.InvokeBatch(new[] { new object[] { "a" }, new object[] { "b" }, new object[] { "c" } });
+                Assert.That(context.Execute("log.join('')"), Is.EqualTo("abc"));
+            }
+        }
+
+        [Test]
+        [ExpectedException(typeof(ArgumentNullException))]
+        public void NullArgsets()
+        {
+            using (var f = (JsFunction)context.Execute("(function () {})"))
+                f.InvokeBatch(null);
+        }
+    }
+}
@@ -0,0 +1,139 @@
+// This file is part of the VroomJs library.
+//
+// Author:
+//     Federico Di Gregorio <fog@initd.org>
+//
+// Copyright (c) 2013 
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+using System;
+using System.Text;
+using NUnit.Framework;
+
+namespace VroomJs.Tests
+{
+    [TestFixture]
+    public class Json
+    {
+        JsEngine js;
+        JsContext context;
+
+        [SetUp]
+        public void Setup()
+        {
+            js = new JsEngine();
+            context = js.CreateContext();
+        }
+
+        [TearDown]
+        public void Teardown()
+        {
+            context.Dispose();
+            js.Dispose();
+        }
+
+        [Test]
+        public void GetVariable()
+        {
+            context.Execute("var data = { a: [1, 2], b: 'text', c: null }");
+            Assert.That(context.GetVariableJson("data"), Is.EqualTo("{\"a\":[1,2],\"b\":\"text\",\"c\":null}"));
+        }
+
+        [Test]
+        public void NoJsonForm()
+        {
+            Assert.That(context.GetVariableJson("missing"), Is.Null);
+            context.Execute("var f = function () {}");
+            Assert.That(context.GetVariableJson("f"), Is.Null);
+        }
+
+        [Test]
+        public void SetVariable()
+        {
+            context.SetVariableJson("data", "{\"a\":[1,2],\"b\":\"text\"}");
+            Assert.That(context.Execute("data.a[1] + data.b"), Is.EqualTo("2text"));
+        }
+
+        [Test]
+        public void Utf8()
+        {
+            context.SetVariableJson("s", Encoding.UTF8.GetBytes("\"caffè €\""));
+            Assert.That(context.Execute("s"), Is.EqualTo("caffè €"));
+            Assert.That(context.GetVariableJson("s"), Is.EqualTo("\"caffè €\""));
+        }
+
+        [Test]
+        public void RoundTrip()
+        {
+            string json = "[{\"x\":1,\"y\":2.5},{\"x\":-3,\"y\":true}]";
+            context.SetVariableJson("data", json);
+            Assert.That(context.GetVariableJson("data"), Is.EqualTo(json));
+        }
+
+        [Test]
+        [ExpectedException(typeof(JsException))]
+        public void InvalidJson()
+        {
+            context.SetVariableJson("data", "{ a: 1 }");
+        }
+
+        [Test]
+        public void Invoke()
+        {
+            using (var f = (JsFunction)context.Execute("(function (a, b) { return { sum: a.x + b } })")) {
+                Assert.That(f.InvokeJson("[{\"x\":1},2]"), Is.EqualTo("{\"sum\":3}"));
+            }
+        }
+
+        [Test]
+        public void InvokeWithoutArguments()
+        {
+            using (var f = (JsFunction)context.Execute("(function () { return [arguments.length] })")) {
+                Assert.That(f.InvokeJson(null), Is.EqualTo("[0]"));
+            }
+        }
+
+        [Test]
+        [ExpectedException(typeof(JsException))]
+        public void InvokeNeedsAnArray()
+        {
+            using (var f = (JsFunction)context.Execute("(function (a) { return a })")) {
+                f.InvokeJson("{\"a\":1}");
+            }
+        }
+
+        [Test]
+        [ExpectedException(typeof(JsException))]
+        public void InvokeThrows()
+        {
+            using (var f = (JsFunction)context.Execute("(function () { throw new Error('no') })")) {
+                f.InvokeJson("[]");
+            }
+        }
+
+        [Test]
+        public void AfterReset()
+        {
+            context.Reset();
+            context.SetVariableJson("data", "[1]");
+            Assert.That(context.GetVariableJson("data"), Is.EqualTo("[1]"));
+        }
+    }
+}
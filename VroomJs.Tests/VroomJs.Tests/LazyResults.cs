@@ -0,0 +1,93 @@
+// This file is part of the VroomJs library.
+//
+// Author:
+//     Federico Di Gregorio <fog@initd.org>
+//
+// Copyright (c) 2013 
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+using System;
+using NUnit.Framework;
+
+namespace VroomJs.Tests
+{
+    [TestFixture]
+    public class LazyResults
+    {
+        JsEngine js;
+        JsContext context;
+
+        [SetUp]
+        public void Setup()
+        {
+            js = new JsEngine();
+            context = js.CreateContext();
+        }
+
+        [TearDown]
+        public void Teardown()
+        {
+            context.Dispose();
+            js.Dispose();
+        }
+
+        [Test]
+        public void SmallResultsInFull()
+        {
+            Assert.That(context.Execute("[1, 2, 3]", JsResultMode.Lazy), Is.EqualTo(new object[] { 1, 2, 3 }));
+            Assert.That(context.Execute("'abc'", JsResultMode.Lazy), Is.EqualTo("abc"));
+        }
+
+        [Test]
+        public void LargeArray()
+        {
+            var h = (JsHandle)context.Execute("var a = []; for (var i = 0; i < 100000; i++) a.push(i); a", JsResultMode.Lazy);
+            using (h) {
+                Assert.That(h.Length, Is.EqualTo(100000));
+                Assert.That(h.GetRange(10, 3), Is.EqualTo(new object[] { 10, 11, 12 }));
+                Assert.That(h.GetRange(99998, 10).Length, Is.EqualTo(2));
+
+                context.Execute("a.push(-1)");
+                Assert.That(h.GetArrayLength(), Is.EqualTo(100001));
+                Assert.That(((object[])h.Convert()).Length, Is.EqualTo(100001));
+            }
+        }
+
+        [Test]
+        public void LargeString()
+        {
+            var h = (JsHandle)context.Execute("new Array(70001).join('x') + 'yz'", JsResultMode.Lazy);
+            using (h) {
+                Assert.That(h.Length, Is.EqualTo(70002));
+                Assert.That(h.Read(69999, 10), Is.EqualTo("xyz"));
+                Assert.That(h.Read(70002, 10), Is.EqualTo(""));
+                Assert.That(((string)h.Convert()).Length, Is.EqualTo(70002));
+            }
+        }
+
+        [Test]
+        [ExpectedException(typeof(JsException))]
+        public void StringIsntAnArray()
+        {
+            using (var h = (JsHandle)context.Execute("new Array(70001).join('x')", JsResultMode.Lazy))
+                h.GetArrayLength();
+        }
+    }
+}
@@ -0,0 +1,117 @@
+// This file is part of the VroomJs library.
+//
+// Author:
+//     Federico Di Gregorio <fog@initd.org>
+//
+// Copyright (c) 2013 
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+using System;
+using NUnit.Framework;
+
+namespace VroomJs.Tests
+{
+    [TestFixture]
+    public class MemberCache
+    {
+        JsEngine js;
+        JsContext context;
+
+        [SetUp]
+        public void Setup()
+        {
+            js = new JsEngine();
+            context = js.CreateContext();
+        }
+
+        [TearDown]
+        public void Teardown()
+        {
+            context.Dispose();
+            js.Dispose();
+        }
+
+        static void AssertNotFound(JsException e, string name)
+        {
+            Assert.That(e.InnerException, Is.InstanceOf<InvalidOperationException>());
+            Assert.That(e.InnerException.Message, Is.StringContaining(typeof(TestClass).ToString()));
+            Assert.That(e.InnerException.Message, Is.StringContaining(name));
+        }
+
+        [Test]
+        public void MissingPropertyThrows()
+        {
+            context.SetVariable("o", new TestClass());
+            AssertNotFound(Assert.Throws<JsException>(() => context.Execute("o.nothing")), "nothing");
+        }
+
+        [Test]
+        public void MissingPropertyFromCache()
+        {
+            context.SetVariable("a", new TestClass());
+            context.SetVariable("b", new TestClass());
+            Assert.Throws<JsException>(() => context.Execute("a.nothing"));
+
+            long hits = context.GetStats().MemberCacheHits;
+            AssertNotFound(Assert.Throws<JsException>(() => context.Execute("b.nothing")), "nothing");
+            Assert.That(context.GetStats().MemberCacheHits, Is.GreaterThan(hits));
+        }
+
+        [Test]
+        public void CaughtInScript()
+        {
+            context.SetVariable("o", new TestClass());
+            Assert.That(context.Execute("try { o.nothing; 'no' } catch (e) { 'yes' }"), Is.EqualTo("yes"));
+            Assert.That(context.Execute("try { o.nothing; 'no' } catch (e) { 'yes' }"), Is.EqualTo("yes"));
+        }
+
+        [Test]
+        public void PresentProperty()
+        {
+            context.SetVariable("o", new TestClass { Int32Property = 3 });
+            Assert.That(context.Execute("o.int32Property + o.Int32Property"), Is.EqualTo(6));
+        }
+
+        [Test]
+        public void TypeKeysFromManyThreads()
+        {
+            var threads = new System.Threading.Thread[4];
+            Exception error = null;
+            for (int i = 0; i < threads.Length; i++) {
+                threads[i] = new System.Threading.Thread(() => {
+                    try {
+                        using (JsContext c = js.CreateContext()) {
+                            for (int j = 0; j < 100; j++) {
+                                c.SetVariable("o", new TestClass { Int32Property = j });
+                                c.Execute("o.Int32Property");
+                            }
+                        }
+                    } catch (Exception e) {
+                        error = e;
+                    }
+                });
+                threads[i].Start();
+            }
+            foreach (var t in threads)
+                t.Join();
+            Assert.That(error, Is.Null);
+        }
+    }
+}
@@ -0,0 +1,115 @@
+// This file is part of the VroomJs library.
+//
+// Author:
+//     Federico Di Gregorio <fog@initd.org>
+//
+// Copyright (c) 2013 
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+using System;
+using NUnit.Framework;
+
+namespace VroomJs.Tests
+{
+    [TestFixture]
+    public class PackedArrays
+    {
+        JsEngine js;
+        JsContext context;
+
+        [SetUp]
+        public void Setup()
+        {
+            js = new JsEngine();
+            context = js.CreateContext();
+            JsEngine.PackedArrays = true;
+        }
+
+        [TearDown]
+        public void Teardown()
+        {
+            JsEngine.PackedArrays = false;
+            context.Dispose();
+            js.Dispose();
+        }
+
+        [Test]
+        public void Integers()
+        {
+            object res = context.Execute("[1, 2, -3]");
+            Assert.That(res, Is.InstanceOf<int[]>());
+            Assert.That(res, Is.EqualTo(new int[] { 1, 2, -3 }));
+        }
+
+        [Test]
+        public void WidenedToDoubles()
+        {
+            object res = context.Execute("[1, 2, 3.5, 4]");
+            Assert.That(res, Is.InstanceOf<double[]>());
+            Assert.That(res, Is.EqualTo(new double[] { 1, 2, 3.5, 4 }));
+        }
+
+        [Test]
+        public void LargerThanInt32()
+        {
+            object res = context.Execute("[1, 4294967296]");
+            Assert.That(res, Is.EqualTo(new double[] { 1, 4294967296.0 }));
+        }
+
+        [Test]
+        public void MixedArraysAreNotPacked()
+        {
+            object res = context.Execute("[1, 'two', 3]");
+            Assert.That(res, Is.InstanceOf<object[]>());
+            Assert.That(res, Is.EqualTo(new object[] { 1, "two", 3 }));
+        }
+
+        [Test]
+        public void EmptyArraysAreNotPacked()
+        {
+            Assert.That(context.Execute("[]"), Is.InstanceOf<object[]>());
+        }
+
+        [Test]
+        public void Nested()
+        {
+            object[] res = (object[])context.Execute("[[1, 2], ['a']]");
+            Assert.That(res[0], Is.EqualTo(new int[] { 1, 2 }));
+            Assert.That(res[1], Is.EqualTo(new object[] { "a" }));
+        }
+
+        [Test]
+        public void OffByDefault()
+        {
+            JsEngine.PackedArrays = false;
+            Assert.That(context.Execute("[1, 2, 3]"), Is.EqualTo(new object[] { 1, 2, 3 }));
+        }
+
+        [Test]
+        public void PerCall()
+        {
+            JsEngine.PackedArrays = false;
+            JsMarshalPolicy policy = JsMarshalPolicy.Default;
+            policy.Flags |= JsMarshalFlags.PackedArrays;
+            Assert.That(context.Execute("[1, 2, 3]", policy), Is.InstanceOf<int[]>());
+            Assert.That(context.Execute("[1, 2, 3]"), Is.InstanceOf<object[]>());
+        }
+    }
+}
@@ -0,0 +1,152 @@
+// This file is part of the VroomJs library.
+//
+// Author:
+//     Federico Di Gregorio <fog@initd.org>
+//
+// Copyright (c) 2013 
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+using System;
+using System.Collections.Generic;
+using NUnit.Framework;
+
+namespace VroomJs.Tests
+{
+    [TestFixture]
+    public class Policies
+    {
+        JsEngine js;
+        JsContext context;
+
+        [SetUp]
+        public void Setup()
+        {
+            js = new JsEngine();
+            context = js.CreateContext();
+        }
+
+        [TearDown]
+        public void Teardown()
+        {
+            JsEngine.MaxStringLength = 0;
+            context.Dispose();
+            js.Dispose();
+        }
+
+        [Test]
+        public void NoneByDefault()
+        {
+            Assert.That(context.Policy, Is.Null);
+        }
+
+        [Test]
+        public void ContextPolicy()
+        {
+            JsMarshalPolicy policy = JsMarshalPolicy.Default;
+            policy.MarshalType = JsObjectMarshalType.Dictionary;
+            policy.Flags |= JsMarshalFlags.PackedArrays;
+            context.Policy = policy;
+
+            Assert.That(context.Execute("[1, 2]"), Is.InstanceOf<int[]>());
+            Assert.That(context.Execute("({ a: 1 })"), Is.InstanceOf<Dictionary<string, object>>());
+        }
+
+        [Test]
+        public void OnlyThisContext()
+        {
+            JsMarshalPolicy policy = JsMarshalPolicy.Default;
+            policy.Flags |= JsMarshalFlags.PackedArrays;
+            context.Policy = policy;
+
+            using (JsContext other = js.CreateContext()) {
+                Assert.That(other.Execute("[1, 2]"), Is.InstanceOf<object[]>());
+            }
+        }
+
+        [Test]
+        public void PerCallWins()
+        {
+            JsMarshalPolicy policy = JsMarshalPolicy.Default;
+            policy.Flags |= JsMarshalFlags.PackedArrays;
+            context.Policy = policy;
+
+            Assert.That(context.Execute("[1, 2]", JsMarshalPolicy.Default), Is.InstanceOf<object[]>());
+            Assert.That(context.Execute("[1, 2]"), Is.InstanceOf<int[]>());
+        }
+
+        [Test]
+        public void BackToTheDefaults()
+        {
+            JsMarshalPolicy policy = JsMarshalPolicy.Default;
+            policy.Flags |= JsMarshalFlags.PackedArrays;
+            context.Policy = policy;
+            context.Policy = null;
+            Assert.That(context.Execute("[1, 2]"), Is.InstanceOf<object[]>());
+        }
+
+        [Test]
+        public void ResetClearsIt()
+        {
+            JsMarshalPolicy policy = JsMarshalPolicy.Default;
+            policy.Flags |= JsMarshalFlags.PackedArrays;
+            context.Policy = policy;
+            context.Reset();
+            Assert.That(context.Policy, Is.Null);
+            Assert.That(context.Execute("[1, 2]"), Is.InstanceOf<object[]>());
+        }
+
+        [Test]
+        [ExpectedException(typeof(JsException))]
+        public void MaxStringLength()
+        {
+            JsMarshalPolicy policy = JsMarshalPolicy.Default;
+            policy.MaxStringLength = 8;
+            context.Policy = policy;
+            context.Execute("['short', 'a bit too long']");
+        }
+
+        [Test]
+        public void WithinMaxStringLength()
+        {
+            JsMarshalPolicy policy = JsMarshalPolicy.Default;
+            policy.MaxStringLength = 8;
+            Assert.That(context.Execute("'12345678'", policy), Is.EqualTo("12345678"));
+        }
+
+        [Test]
+        [ExpectedException(typeof(JsException))]
+        public void EngineMaxStringLength()
+        {
+            JsEngine.MaxStringLength = 4;
+            context.Execute("'too long'");
+        }
+
+        [Test]
+        public void PerCallInvoke()
+        {
+            JsMarshalPolicy policy = JsMarshalPolicy.Default;
+            policy.Flags |= JsMarshalFlags.PackedArrays;
+            using (var f = (JsFunction)context.Execute("(function () { return [0.5, 1]; })")) {
+                Assert.That(f.Invoke(new object[0], policy), Is.EqualTo(new double[] { 0.5, 1 }));
+                Assert.That(f.Invoke(new object[0]), Is.EqualTo(new object[] { 0.5, 1 }));
+            }
+        }
+    }
+}
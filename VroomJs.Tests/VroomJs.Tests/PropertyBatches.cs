@@ -0,0 +1,100 @@
+// This file is part of the VroomJs library.
+//
+// Author:
+//     Federico Di Gregorio <fog@initd.org>
+//
+// Copyright (c) 2013 
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+using System;
+using NUnit.Framework;
+
+namespace VroomJs.Tests
+{
+    [TestFixture]
+    public class PropertyBatches
+    {
+        JsEngine js;
+        JsContext context;
+
+        [SetUp]
+        public void Setup()
+        {
+            js = new JsEngine();
+            context = js.CreateContext();
+        }
+
+        [TearDown]
+        public void Teardown()
+        {
+            context.Dispose();
+            js.Dispose();
+        }
+
+        [Test]
+        public void Get()
+        {
+            var obj = (JsObject)context.Execute("({ a: 1, b: 'two', c: [3] })");
+            object[] values = context.GetPropertyValues(obj, new[] { "a", "b", "c", "d" });
+            Assert.That(values[0], Is.EqualTo(1));
+            Assert.That(values[1], Is.EqualTo("two"));
+            Assert.That(values[2], Is.EqualTo(new object[] { 3 }));
+            Assert.That(values[3], Is.Null);
+        }
+
+        [Test]
+        public void Set()
+        {
+            var obj = (JsObject)context.Execute("var o = {}; o");
+            context.SetPropertyValues(obj, new[] { "a", "b" }, new object[] { 1, "two" });
+            Assert.That(context.Execute("o.a + o.b"), Is.EqualTo("1two"));
+        }
+
+        [Test]
+        public void Empty()
+        {
+            var obj = (JsObject)context.Execute("({ a: 1 })");
+            Assert.That(context.GetPropertyValues(obj, new string[0]), Is.Empty);
+        }
+
+        [Test]
+        public void GetterThrows()
+        {
+            var obj = (JsObject)context.Execute("var o = { a: 1 }; o.__defineGetter__('bad', function () { throw new Error('no'); }); o");
+            Assert.Throws<JsException>(() => context.GetPropertyValues(obj, new[] { "a", "bad" }));
+        }
+
+        [Test]
+        public void SetterThrowsOthersStillSet()
+        {
+            var obj = (JsObject)context.Execute("var o = {}; o.__defineSetter__('bad', function () { throw new Error('no'); }); o");
+            Assert.Throws<JsException>(() => context.SetPropertyValues(obj, new[] { "bad", "a" }, new object[] { 1, 2 }));
+            Assert.That(context.Execute("o.a"), Is.EqualTo(2));
+        }
+
+        [Test]
+        [ExpectedException(typeof(ArgumentException))]
+        public void LengthsDiffer()
+        {
+            var obj = (JsObject)context.Execute("({})");
+            context.SetPropertyValues(obj, new[] { "a", "b" }, new object[] { 1 });
+        }
+    }
+}
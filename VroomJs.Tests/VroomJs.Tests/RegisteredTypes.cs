@@ -0,0 +1,122 @@
+// This file is part of the VroomJs library.
+//
+// Author:
+//     Federico Di Gregorio <fog@initd.org>
+//
+// Copyright (c) 2013 
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+using System;
+using NUnit.Framework;
+
+namespace VroomJs.Tests
+{
+    public class Point
+    {
+        public readonly int Id;
+        public double X;
+        public double Y { get; set; }
+
+        public Point(int id)
+        {
+            Id = id;
+        }
+
+        public double Sum()
+        {
+            return X + Y;
+        }
+    }
+
+    [TestFixture]
+    public class RegisteredTypes
+    {
+        JsEngine js;
+        JsContext context;
+
+        [SetUp]
+        public void Setup()
+        {
+            js = new JsEngine();
+            js.RegisterType(typeof(Point));
+            context = js.CreateContext();
+        }
+
+        [TearDown]
+        public void Teardown()
+        {
+            context.Dispose();
+            js.Dispose();
+        }
+
+        [Test]
+        public void Members()
+        {
+            var p = new Point(7) { X = 1, Y = 2 };
+            context.SetVariable("p", p);
+            Assert.That(context.Execute("p.id"), Is.EqualTo(7));
+            Assert.That(context.Execute("p.Id"), Is.EqualTo(7));
+            Assert.That(context.Execute("p.x + p.Y"), Is.EqualTo(3));
+            Assert.That(context.Execute("p.sum()"), Is.EqualTo(3));
+        }
+
+        [Test]
+        public void Set()
+        {
+            var p = new Point(1);
+            context.SetVariable("p", p);
+            context.Execute("p.x = 5; p.y = 6");
+            Assert.That(p.X, Is.EqualTo(5.0));
+            Assert.That(p.Y, Is.EqualTo(6.0));
+        }
+
+        [Test]
+        public void ReadOnlyField()
+        {
+            var p = new Point(1);
+            context.SetVariable("p", p);
+            context.Execute("p.id = 5");
+            Assert.That(p.Id, Is.EqualTo(1));
+        }
+
+        [Test]
+        public void SameTemplateForAll()
+        {
+            context.SetVariable("a", new Point(1) { X = 1 });
+            context.SetVariable("b", new Point(2) { X = 2 });
+            Assert.That(context.Execute("var s = 0; for (var i = 0; i < 100; i++) s += (i % 2 ? a : b).x; s"), Is.EqualTo(150));
+        }
+
+        [Test]
+        public void RegisterTwice()
+        {
+            js.RegisterType(typeof(Point));
+            context.SetVariable("p", new Point(3));
+            Assert.That(context.Execute("p.id"), Is.EqualTo(3));
+        }
+
+        [Test]
+        [ExpectedException(typeof(ArgumentNullException))]
+        public void RegisterNull()
+        {
+            js.RegisterType(null);
+        }
+    }
+}
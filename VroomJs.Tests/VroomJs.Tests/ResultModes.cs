@@ -0,0 +1,110 @@
+// This file is part of the VroomJs library.
+//
+// Author:
+//     Federico Di Gregorio <fog@initd.org>
+//
+// Copyright (c) 2013 
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+using System;
+using NUnit.Framework;
+
+namespace VroomJs.Tests
+{
+    [TestFixture]
+    public class ResultModes
+    {
+        JsEngine js;
+        JsContext context;
+
+        [SetUp]
+        public void Setup()
+        {
+            js = new JsEngine();
+            context = js.CreateContext();
+        }
+
+        [TearDown]
+        public void Teardown()
+        {
+            context.Dispose();
+            js.Dispose();
+        }
+
+        [Test]
+        public void Discard()
+        {
+            Assert.That(context.Execute("var x = 42; [x, x]", JsResultMode.Discard), Is.Null);
+            Assert.That(context.Execute("x"), Is.EqualTo(42));
+        }
+
+        [Test]
+        [ExpectedException(typeof(JsException))]
+        public void DiscardStillThrows()
+        {
+            context.Execute("throw new Error('no')", JsResultMode.Discard);
+        }
+
+        [Test]
+        public void Primitives()
+        {
+            Assert.That(context.Execute("1 + 2", JsResultMode.Primitives), Is.EqualTo(3));
+            Assert.That(context.Execute("'text'", JsResultMode.Primitives), Is.EqualTo("text"));
+            Assert.That(context.Execute("[1, 2]", JsResultMode.Primitives), Is.Null);
+            Assert.That(context.Execute("({ a: 1 })", JsResultMode.Primitives), Is.Null);
+            Assert.That(context.Execute("new Date(0)", JsResultMode.Primitives), Is.InstanceOf<DateTime>());
+        }
+
+        [Test]
+        public void Handle()
+        {
+            Assert.That(context.Execute("42", JsResultMode.Handle), Is.EqualTo(42));
+            var h = (JsHandle)context.Execute("var a = [1, 2, 3]; a", JsResultMode.Handle);
+            using (h) {
+                Assert.That(h.Length, Is.EqualTo(3));
+                context.Execute("a.push(4)");
+                Assert.That(h.Convert(), Is.EqualTo(new object[] { 1, 2, 3, 4 }));
+            }
+        }
+
+        [Test]
+        public void Script()
+        {
+            using (JsScript script = js.CompileScript("[1, 2, 3]")) {
+                Assert.That(context.Execute(script, JsResultMode.Discard), Is.Null);
+                Assert.That(context.Execute(script, JsResultMode.Primitives), Is.Null);
+                Assert.That(context.Execute(script, JsResultMode.Full), Is.EqualTo(new object[] { 1, 2, 3 }));
+            }
+        }
+
+        [Test]
+        public void Invoke()
+        {
+            using (var f = (JsFunction)context.Execute("(function (n) { var r = []; for (var i = 0; i < n; i++) r.push(i); return r; })")) {
+                Assert.That(f.Invoke(new object[] { 3 }, JsResultMode.Discard), Is.Null);
+                Assert.That(f.Invoke(new object[] { 3 }, JsResultMode.Primitives), Is.Null);
+                using (var h = (JsHandle)f.Invoke(new object[] { 3 }, JsResultMode.Handle)) {
+                    Assert.That(h.Convert(), Is.EqualTo(new object[] { 0, 1, 2 }));
+                }
+                Assert.That(f.Invoke(new object[] { 2 }, JsResultMode.Full), Is.EqualTo(new object[] { 0, 1 }));
+            }
+        }
+    }
+}
@@ -0,0 +1,115 @@
+// This file is part of the VroomJs library.
+//
+// Author:
+//     Federico Di Gregorio <fog@initd.org>
+//
+// Copyright (c) 2013 
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+using System;
+using NUnit.Framework;
+
+namespace VroomJs.Tests
+{
+    [TestFixture]
+    public class ScriptCache
+    {
+        JsEngine js;
+        JsContext context;
+
+        [SetUp]
+        public void Setup()
+        {
+            js = new JsEngine();
+            context = js.CreateContext();
+        }
+
+        [TearDown]
+        public void Teardown()
+        {
+            context.Dispose();
+            js.Dispose();
+        }
+
+        [Test]
+        public void SecondRunIsAHit()
+        {
+            context.Execute("var n = (n || 0) + 1; n");
+            Assert.That(context.Execute("var n = (n || 0) + 1; n"), Is.EqualTo(2));
+            JsScriptCacheStats stats = js.GetScriptCacheStats();
+            Assert.That(stats.Misses, Is.EqualTo(1));
+            Assert.That(stats.Hits, Is.EqualTo(1));
+            Assert.That(stats.Entries, Is.EqualTo(1));
+        }
+
+        [Test]
+        public void SharedByContexts()
+        {
+            context.Execute("typeof x");
+            using (JsContext other = js.CreateContext()) {
+                other.Execute("var x = 1");
+                Assert.That(other.Execute("typeof x"), Is.EqualTo("number"));
+            }
+            Assert.That(context.Execute("typeof x"), Is.EqualTo("undefined"));
+            Assert.That(js.GetScriptCacheStats().Hits, Is.EqualTo(2));
+        }
+
+        [Test]
+        public void NameIsPartOfTheKey()
+        {
+            context.Execute("1", "a.js");
+            context.Execute("1", "b.js");
+            Assert.That(js.GetScriptCacheStats().Entries, Is.EqualTo(2));
+        }
+
+        [Test]
+        public void ErrorsAreNotCached()
+        {
+            for (int i = 0; i < 2; i++)
+                Assert.Throws<JsException>(() => context.Execute("a+§"));
+            JsScriptCacheStats stats = js.GetScriptCacheStats();
+            Assert.That(stats.Hits, Is.EqualTo(0));
+            Assert.That(stats.Entries, Is.EqualTo(0));
+        }
+
+        [Test]
+        public void Eviction()
+        {
+            js.SetScriptCacheBudget(64);
+            for (int i = 0; i < 10; i++)
+                context.Execute("'a fairly long script, number " + i + "'");
+            JsScriptCacheStats stats = js.GetScriptCacheStats();
+            Assert.That(stats.Budget, Is.EqualTo(64));
+            Assert.That(stats.Evictions, Is.GreaterThan(0));
+            Assert.That(stats.Size, Is.LessThanOrEqualTo(64));
+        }
+
+        [Test]
+        public void Disabled()
+        {
+            js.SetScriptCacheBudget(0);
+            context.Execute("1");
+            context.Execute("1");
+            JsScriptCacheStats stats = js.GetScriptCacheStats();
+            Assert.That(stats.Hits, Is.EqualTo(0));
+            Assert.That(stats.Entries, Is.EqualTo(0));
+        }
+    }
+}
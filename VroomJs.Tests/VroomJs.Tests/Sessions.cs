@@ -0,0 +1,140 @@
+// This file is part of the VroomJs library.
+//
+// Author:
+//     Federico Di Gregorio <fog@initd.org>
+//
+// Copyright (c) 2013 
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+using System;
+using System.Threading;
+using NUnit.Framework;
+
+namespace VroomJs.Tests
+{
+    [TestFixture]
+    public class Sessions
+    {
+        JsEngine js;
+        JsContext context;
+
+        [SetUp]
+        public void Setup()
+        {
+            js = new JsEngine();
+            context = js.CreateContext();
+        }
+
+        [TearDown]
+        public void Teardown()
+        {
+            if (!context.IsDisposed)
+                context.Dispose();
+            js.Dispose();
+        }
+
+        [Test]
+        public void CallsInSession()
+        {
+            using (context.BeginSession()) {
+                context.SetVariable("a", 1);
+                context.Execute("a += 1");
+                Assert.That(context.GetVariable("a"), Is.EqualTo(2));
+            }
+            Assert.That(context.Execute("a"), Is.EqualTo(2));
+        }
+
+        [Test]
+        public void Nested()
+        {
+            using (context.BeginSession()) {
+                using (context.BeginSession())
+                    context.Execute("var a = 1");
+                Assert.That(context.Execute("a"), Is.EqualTo(1));
+            }
+            Assert.Throws<InvalidOperationException>(() => context.EndSession());
+        }
+
+        [Test]
+        public void EndedByReset()
+        {
+            JsSession session = context.BeginSession();
+            context.Reset();
+            // Nothing left to end, and no harm in trying.
+            session.Dispose();
+            Assert.Throws<InvalidOperationException>(() => context.EndSession());
+            Assert.That(context.Execute("1 + 1"), Is.EqualTo(2));
+        }
+
+        [Test]
+        public void EndedByDispose()
+        {
+            JsSession session = context.BeginSession();
+            context.Dispose();
+            session.Dispose();
+        }
+
+        [Test]
+        public void OtherThreadsWait()
+        {
+            object result = null;
+            var other = new Thread(() => result = context.Execute("typeof a"));
+            using (context.BeginSession()) {
+                context.Execute("var a = 1");
+                other.Start();
+                Assert.That(other.Join(200), Is.False);
+                context.Execute("a = 'x'");
+            }
+            other.Join();
+            Assert.That(result, Is.EqualTo("string"));
+        }
+
+        [Test]
+        public void ResetOrDisposeFromOtherThread()
+        {
+            Exception reset = null, dispose = null;
+            using (context.BeginSession()) {
+                var other = new Thread(() => {
+                    try { context.Reset(); } catch (Exception e) { reset = e; }
+                    try { context.Dispose(); } catch (Exception e) { dispose = e; }
+                });
+                other.Start();
+                other.Join();
+            }
+            Assert.That(reset, Is.InstanceOf<InvalidOperationException>());
+            Assert.That(dispose, Is.InstanceOf<InvalidOperationException>());
+            Assert.That(context.IsDisposed, Is.False);
+        }
+
+        [Test]
+        public void EndOnOtherThread()
+        {
+            Exception error = null;
+            using (context.BeginSession()) {
+                var other = new Thread(() => {
+                    try { context.EndSession(); } catch (Exception e) { error = e; }
+                });
+                other.Start();
+                other.Join();
+            }
+            Assert.That(error, Is.InstanceOf<InvalidOperationException>());
+        }
+    }
+}
@@ -0,0 +1,54 @@
+// This file is part of the VroomJs library.
+//
+// Author:
+//     Federico Di Gregorio <fog@initd.org>
+//
+// Copyright (c) 2013 
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+using System;
+
+namespace VroomJs
+{
+	// Wraps a one-dimensional array of numbers (sbyte, byte, short, ushort,
+	// int, uint, float or double) to hand it to V8 without copying: the array
+	// is pinned and becomes the indexed storage of a JS object, so writes from
+	// either side are seen by the other. The array stays pinned until V8
+	// collects the last object backed by it or the context is disposed. Bare
+	// arrays go over as managed objects, as any other CLR object.
+	public class JsBuffer
+	{
+		readonly Array _array;
+
+		public JsBuffer(Array array)
+		{
+			if (array == null)
+				throw new ArgumentNullException("array");
+			if (array.Rank != 1 || !JsConvert.BufferTypes.ContainsKey(array.GetType().GetElementType()))
+				throw new ArgumentException("only one-dimensional arrays of numbers can be shared", "array");
+
+			_array = array;
+		}
+
+		public Array Array {
+			get { return _array; }
+		}
+	}
+}
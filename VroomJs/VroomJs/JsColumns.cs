@@ -0,0 +1,97 @@
+// This file is part of the VroomJs library.
+//
+// Author:
+//     Federico Di Gregorio <fog@initd.org>
+//
+// Copyright (c) 2013 
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+using System;
+using System.Collections.Generic;
+
+namespace VroomJs
+{
+    // An array of JS objects sharing the same keys, as returned by
+    // JsContext.ExecuteColumns or with JsEngine.ColumnarResults: the keys once
+    // and a column per key, int[] or double[] when it's all numbers and
+    // object[] otherwise.
+    public class JsColumns
+    {
+        readonly string[] _names;
+        readonly Array[] _columns;
+        readonly int _count;
+
+        public JsColumns(string[] names, Array[] columns, int count)
+        {
+            if (names == null)
+                throw new ArgumentNullException("names");
+            if (columns == null)
+                throw new ArgumentNullException("columns");
+            if (names.Length != columns.Length)
+                throw new ArgumentException("a column is needed for each name", "columns");
+
+            _names = names;
+            _columns = columns;
+            _count = count;
+        }
+
+        public string[] Names {
+            get { return _names; }
+        }
+
+        // The number of rows.
+        public int Count {
+            get { return _count; }
+        }
+
+        public Array GetColumn(int index)
+        {
+            return _columns[index];
+        }
+
+        // Null if there is no such key.
+        public Array GetColumn(string name)
+        {
+            int index = Array.IndexOf(_names, name);
+            return index >= 0 ? _columns[index] : null;
+        }
+
+        public object this[int row, string name] {
+            get {
+                Array column = GetColumn(name);
+                if (column == null)
+                    throw new KeyNotFoundException(name);
+                return column.GetValue(row);
+            }
+        }
+
+        // A row as the dictionary it would have been without columns.
+        public Dictionary<string, object> GetRow(int row)
+        {
+            if (row < 0 || row >= _count)
+                throw new ArgumentOutOfRangeException("row");
+
+            var r = new Dictionary<string, object>(_names.Length);
+            for (int i = 0; i < _names.Length; i++)
+                r[_names[i]] = _columns[i].GetValue(row);
+            return r;
+        }
+    }
+}
@@ -16,8 +16,29 @@ namespace VroomJs
 		[DllImport("VroomJsNative")]
 		static extern JsValue jscontext_set_property_value(HandleRef engine, IntPtr ptr, [MarshalAs(UnmanagedType.LPWStr)] string name, JsValue value);
 
+		[DllImport("VroomJsNative")]
+		static extern JsValue jscontext_get_property_values(HandleRef engine, IntPtr ptr, [MarshalAs(UnmanagedType.LPArray, ArraySubType = UnmanagedType.LPWStr)] string[] names, int count);
+
+		[DllImport("VroomJsNative")]
+		static extern JsValue jscontext_set_property_values(HandleRef engine, IntPtr ptr, [MarshalAs(UnmanagedType.LPArray, ArraySubType = UnmanagedType.LPWStr)] string[] names, int count, JsValue values);
+
 		[DllImport("VroomJsNative")]
 		static extern JsValue jscontext_invoke_property(HandleRef engine, IntPtr ptr, [MarshalAs(UnmanagedType.LPWStr)] string name, JsValue args);
+
+		[DllImport("VroomJsNative")]
+		static extern JsValue jscontext_get_property_value_atom(HandleRef engine, IntPtr ptr, int atom);
+
+		[DllImport("VroomJsNative")]
+		static extern JsValue jscontext_set_property_value_atom(HandleRef engine, IntPtr ptr, int atom, JsValue value);
+
+		[DllImport("VroomJsNative")]
+		static extern JsValue jscontext_get_property_values_atoms(HandleRef engine, IntPtr ptr, int[] atoms, int count);
+
+		[DllImport("VroomJsNative")]
+		static extern JsValue jscontext_set_property_values_atoms(HandleRef engine, IntPtr ptr, int[] atoms, int count, JsValue values);
+
+		[DllImport("VroomJsNative")]
+		static extern JsValue jscontext_invoke_property_atom(HandleRef engine, IntPtr ptr, int atom, JsValue args);
 	
 		public IEnumerable<string> GetMemberNames(JsObject obj) 
 		{
@@ -87,6 +108,71 @@ namespace VroomJs
                 throw e;
         }
 
+        // Same as calling GetPropertyValue() for each name, in one trip to
+        // V8. All the properties are read even if one of them throws; the
+        // first exception is rethrown afterwards.
+        public object[] GetPropertyValues(JsObject obj, string[] names)
+        {
+            if (obj == null)
+                throw new ArgumentNullException("obj");
+            if (names == null)
+                throw new ArgumentNullException("names");
+
+            CheckDisposed();
+
+            if (obj.Handle == IntPtr.Zero)
+                throw new JsInteropException("wrapped V8 object is empty (IntPtr is Zero)");
+
+			JsValue v = jscontext_get_property_values(_context, obj.Handle, names, names.Length);
+            object res = _convert.FromJsValue(v);
+            jsvalue_dispose(v);
+
+            Exception e = res as JsException;
+            if (e != null)
+                throw e;
+
+            object[] values = (object[])res;
+            foreach (object value in values) {
+                e = value as JsException;
+                if (e != null)
+                    throw e;
+            }
+            return values;
+        }
+
+        public void SetPropertyValues(JsObject obj, string[] names, object[] values)
+        {
+            if (obj == null)
+                throw new ArgumentNullException("obj");
+            if (names == null)
+                throw new ArgumentNullException("names");
+            if (values == null)
+                throw new ArgumentNullException("values");
+            if (names.Length != values.Length)
+                throw new ArgumentException("names and values differ in length");
+
+            CheckDisposed();
+
+            if (obj.Handle == IntPtr.Zero)
+                throw new JsInteropException("wrapped V8 object is empty (IntPtr is Zero)");
+
+            JsValue a = _convert.ToJsValue(values);
+			JsValue v = jscontext_set_property_values(_context, obj.Handle, names, names.Length, a);
+            object res = _convert.FromJsValue(v);
+            jsvalue_dispose(v);
+            jsvalue_dispose(a);
+
+            Exception e = res as JsException;
+            if (e != null)
+                throw e;
+
+            foreach (object r in (object[])res) {
+                e = r as JsException;
+                if (e != null)
+                    throw e;
+            }
+        }
+
         public object InvokeProperty(JsObject obj, string name, object[] args)
         {
             if (obj == null)
@@ -113,5 +199,136 @@ namespace VroomJs
                 throw e;
             return res;
         }
+
+        // The overloads below take names registered with JsEngine.InternName()
+        // and otherwise behave like the ones taking strings.
+
+        public object GetPropertyValue(JsObject obj, int atom)
+        {
+            if (obj == null)
+                throw new ArgumentNullException("obj");
+
+            CheckDisposed();
+
+            if (obj.Handle == IntPtr.Zero)
+                throw new JsInteropException("wrapped V8 object is empty (IntPtr is Zero)");
+
+			JsValue v = jscontext_get_property_value_atom(_context, obj.Handle, atom);
+            object res = _convert.FromJsValue(v);
+            jsvalue_dispose(v);
+
+            Exception e = res as JsException;
+            if (e != null)
+                throw e;
+            return res;
+        }
+
+        public void SetPropertyValue(JsObject obj, int atom, object value)
+        {
+            if (obj == null)
+                throw new ArgumentNullException("obj");
+
+            CheckDisposed();
+
+            if (obj.Handle == IntPtr.Zero)
+                throw new JsInteropException("wrapped V8 object is empty (IntPtr is Zero)");
+
+            JsValue a = _convert.ToJsValue(value);
+			JsValue v = jscontext_set_property_value_atom(_context, obj.Handle, atom, a);
+            object res = _convert.FromJsValue(v);
+            jsvalue_dispose(v);
+            jsvalue_dispose(a);
+
+            Exception e = res as JsException;
+            if (e != null)
+                throw e;
+        }
+
+        public object[] GetPropertyValues(JsObject obj, int[] atoms)
+        {
+            if (obj == null)
+                throw new ArgumentNullException("obj");
+            if (atoms == null)
+                throw new ArgumentNullException("atoms");
+
+            CheckDisposed();
+
+            if (obj.Handle == IntPtr.Zero)
+                throw new JsInteropException("wrapped V8 object is empty (IntPtr is Zero)");
+
+			JsValue v = jscontext_get_property_values_atoms(_context, obj.Handle, atoms, atoms.Length);
+            object res = _convert.FromJsValue(v);
+            jsvalue_dispose(v);
+
+            Exception e = res as JsException;
+            if (e != null)
+                throw e;
+
+            object[] values = (object[])res;
+            foreach (object value in values) {
+                e = value as JsException;
+                if (e != null)
+                    throw e;
+            }
+            return values;
+        }
+
+        public void SetPropertyValues(JsObject obj, int[] atoms, object[] values)
+        {
+            if (obj == null)
+                throw new ArgumentNullException("obj");
+            if (atoms == null)
+                throw new ArgumentNullException("atoms");
+            if (values == null)
+                throw new ArgumentNullException("values");
+            if (atoms.Length != values.Length)
+                throw new ArgumentException("atoms and values differ in length");
+
+            CheckDisposed();
+
+            if (obj.Handle == IntPtr.Zero)
+                throw new JsInteropException("wrapped V8 object is empty (IntPtr is Zero)");
+
+            JsValue a = _convert.ToJsValue(values);
+			JsValue v = jscontext_set_property_values_atoms(_context, obj.Handle, atoms, atoms.Length, a);
+            object res = _convert.FromJsValue(v);
+            jsvalue_dispose(v);
+            jsvalue_dispose(a);
+
+            Exception e = res as JsException;
+            if (e != null)
+                throw e;
+
+            foreach (object r in (object[])res) {
+                e = r as JsException;
+                if (e != null)
+                    throw e;
+            }
+        }
+
+        public object InvokeProperty(JsObject obj, int atom, object[] args)
+        {
+            if (obj == null)
+                throw new ArgumentNullException("obj");
+
+            CheckDisposed();
+
+            if (obj.Handle == IntPtr.Zero)
+                throw new JsInteropException("wrapped V8 object is empty (IntPtr is Zero)");
+
+            JsValue a = JsValue.Null; // Null value unless we're given args.
+            if (args != null)
+                a = _convert.ToJsValue(args);
+
+			JsValue v = jscontext_invoke_property_atom(_context, obj.Handle, atom, a);
+            object res = _convert.FromJsValue(v);
+            jsvalue_dispose(v);
+            jsvalue_dispose(a);
+
+            Exception e = res as JsException;
+            if (e != null)
+                throw e;
+            return res;
+        }
 	}
 }
@@ -25,10 +25,12 @@
 
 using System;
 using System.Collections;
+using System.Collections.Generic;
 using System.Diagnostics;
 using System.Linq;
 using System.Reflection;
 using System.Runtime.InteropServices;
+using System.Text;
 using System.Timers;
 
 namespace VroomJs
@@ -41,6 +43,15 @@ namespace VroomJs
 		[DllImport("VroomJsNative", CallingConvention = CallingConvention.StdCall)]
 		public static extern void jscontext_dispose(HandleRef engine);
 
+		[DllImport("VroomJsNative", CallingConvention = CallingConvention.StdCall)]
+		static extern int jscontext_reset(HandleRef context);
+
+		[DllImport("VroomJsNative", CallingConvention = CallingConvention.StdCall)]
+		static extern void jscontext_session_begin(HandleRef context);
+
+		[DllImport("VroomJsNative", CallingConvention = CallingConvention.StdCall)]
+		static extern int jscontext_session_end(HandleRef context);
+
 		[DllImport("VroomJsNative", CallingConvention = CallingConvention.StdCall)]
 		static extern void jscontext_force_gc();
 
@@ -50,6 +61,45 @@ namespace VroomJs
 		[DllImport("VroomJsNative", CallingConvention = CallingConvention.StdCall, CharSet = CharSet.Unicode)]
 		static extern JsValue jscontext_execute_script(HandleRef context, HandleRef script);
 
+		[DllImport("VroomJsNative", CallingConvention = CallingConvention.StdCall)]
+		static extern JsValue jscontext_execute_mode(HandleRef context, [MarshalAs(UnmanagedType.LPWStr)] string str, [MarshalAs(UnmanagedType.LPWStr)] string name, JsResultMode mode);
+
+		[DllImport("VroomJsNative", CallingConvention = CallingConvention.StdCall)]
+		static extern JsValue jscontext_execute_script_mode(HandleRef context, HandleRef script, JsResultMode mode);
+
+		[DllImport("VroomJsNative", CallingConvention = CallingConvention.StdCall)]
+		static extern void jscontext_set_policy(HandleRef context, ref JsMarshalPolicy policy);
+
+		[DllImport("VroomJsNative", CallingConvention = CallingConvention.StdCall)]
+		static extern void jscontext_set_policy(HandleRef context, IntPtr policy);
+
+		[DllImport("VroomJsNative", CallingConvention = CallingConvention.StdCall)]
+		static extern JsValue jscontext_execute_policy(HandleRef context, [MarshalAs(UnmanagedType.LPWStr)] string str, [MarshalAs(UnmanagedType.LPWStr)] string name, JsResultMode mode, ref JsMarshalPolicy policy);
+
+		[DllImport("VroomJsNative", CallingConvention = CallingConvention.StdCall)]
+		static extern JsValue jscontext_execute_script_policy(HandleRef context, HandleRef script, JsResultMode mode, ref JsMarshalPolicy policy);
+
+		[DllImport("VroomJsNative", CallingConvention = CallingConvention.StdCall)]
+		static extern JsValue jscontext_convert(HandleRef context, IntPtr ptr);
+
+		[DllImport("VroomJsNative", CallingConvention = CallingConvention.StdCall)]
+		static extern JsValue jscontext_array_length(HandleRef context, IntPtr ptr);
+
+		[DllImport("VroomJsNative", CallingConvention = CallingConvention.StdCall)]
+		static extern JsValue jscontext_array_get_range(HandleRef context, IntPtr ptr, int start, int count);
+
+		[DllImport("VroomJsNative", CallingConvention = CallingConvention.StdCall)]
+		static extern JsValue jscontext_string_read(HandleRef context, IntPtr ptr, int offset, int count);
+
+		[DllImport("VroomJsNative", CallingConvention = CallingConvention.StdCall)]
+		static extern JsValue jscontext_execute_columns(HandleRef context, [MarshalAs(UnmanagedType.LPWStr)] string str, [MarshalAs(UnmanagedType.LPWStr)] string name, [MarshalAs(UnmanagedType.LPArray, ArraySubType = UnmanagedType.LPWStr)] string[] names, int count);
+
+		[DllImport("VroomJsNative", CallingConvention = CallingConvention.StdCall)]
+		static extern JsValue jscontext_execute_columns_policy(HandleRef context, [MarshalAs(UnmanagedType.LPWStr)] string str, [MarshalAs(UnmanagedType.LPWStr)] string name, [MarshalAs(UnmanagedType.LPArray, ArraySubType = UnmanagedType.LPWStr)] string[] names, int count, JsResultMode mode, ref JsMarshalPolicy policy);
+
+		[DllImport("VroomJsNative", CallingConvention = CallingConvention.StdCall)]
+		static extern JsValue jscontext_execute_columns_policy(HandleRef context, [MarshalAs(UnmanagedType.LPWStr)] string str, [MarshalAs(UnmanagedType.LPWStr)] string name, [MarshalAs(UnmanagedType.LPArray, ArraySubType = UnmanagedType.LPWStr)] string[] names, int count, JsResultMode mode, IntPtr policy);
+
 		[DllImport("VroomJsNative", CallingConvention = CallingConvention.StdCall)]
 		static extern JsValue jscontext_get_global(HandleRef engine);
 
@@ -59,6 +109,12 @@ namespace VroomJs
 		[DllImport("VroomJsNative", CallingConvention = CallingConvention.StdCall)]
 		static extern JsValue jscontext_set_variable(HandleRef engine, [MarshalAs(UnmanagedType.LPWStr)] string name, JsValue value);
 
+		[DllImport("VroomJsNative", CallingConvention = CallingConvention.StdCall)]
+		static extern JsValue jscontext_get_variable_atom(HandleRef engine, int atom);
+
+		[DllImport("VroomJsNative", CallingConvention = CallingConvention.StdCall)]
+		static extern JsValue jscontext_set_variable_atom(HandleRef engine, int atom, JsValue value);
+
 		[DllImport("VroomJsNative", CallingConvention = CallingConvention.StdCall)]
 		static internal extern JsValue jsvalue_alloc_string([MarshalAs(UnmanagedType.LPWStr)] string str);
 
@@ -71,6 +127,24 @@ namespace VroomJs
 		[DllImport("VroomJsNative", CallingConvention = CallingConvention.StdCall)]
 		static internal extern JsValue jscontext_invoke(HandleRef engine, IntPtr funcPtr, IntPtr thisPtr, JsValue args);
 
+		[DllImport("VroomJsNative", CallingConvention = CallingConvention.StdCall)]
+		static internal extern JsValue jscontext_invoke_mode(HandleRef engine, IntPtr funcPtr, IntPtr thisPtr, JsValue args, JsResultMode mode);
+
+		[DllImport("VroomJsNative", CallingConvention = CallingConvention.StdCall)]
+		static internal extern JsValue jscontext_invoke_policy(HandleRef engine, IntPtr funcPtr, IntPtr thisPtr, JsValue args, JsResultMode mode, ref JsMarshalPolicy policy);
+
+		[DllImport("VroomJsNative", CallingConvention = CallingConvention.StdCall)]
+		static internal extern JsValue jscontext_invoke_batch(HandleRef engine, IntPtr funcPtr, IntPtr thisPtr, JsValue argsets);
+
+		[DllImport("VroomJsNative", CallingConvention = CallingConvention.StdCall)]
+		static extern JsValue jscontext_get_json(HandleRef engine, [MarshalAs(UnmanagedType.LPWStr)] string name);
+
+		[DllImport("VroomJsNative", CallingConvention = CallingConvention.StdCall)]
+		static extern JsValue jscontext_set_json(HandleRef engine, [MarshalAs(UnmanagedType.LPWStr)] string name, byte[] json, int length);
+
+		[DllImport("VroomJsNative", CallingConvention = CallingConvention.StdCall)]
+		static extern JsValue jscontext_invoke_json(HandleRef engine, IntPtr funcPtr, IntPtr thisPtr, byte[] args, int length);
+
 		private readonly int _id;
 		private readonly JsEngine _engine;
 
@@ -101,13 +175,132 @@ namespace VroomJs
 		
         public JsEngineStats GetStats()
         {
-            return new JsEngineStats {
+            JsEngineStats stats = new JsEngineStats {
                 KeepAliveMaxSlots = _keepalives.MaxSlots,
                 KeepAliveAllocatedSlots = _keepalives.AllocatedSlots,
-                KeepAliveUsedSlots = _keepalives.UsedSlots
+                KeepAliveUsedSlots = _keepalives.UsedSlots,
+                MemberKindCacheHits = _engine.MemberCache.Hits,
+                MemberKindCacheMisses = _engine.MemberCache.Misses
             };
+            _engine.GetMemberCacheStats(stats);
+            lock (_buffers)
+                stats.PinnedBuffers = _buffers.Count;
+            return stats;
         }
 
+		// Gives the context a clean global for its next use, so that it can be
+		// reused instead of disposed and created again. Nothing defined by the
+		// previous scripts survives: if they changed a builtin, instead of only
+		// adding globals, a new V8 context is created and false is returned.
+		// The first call always does that to capture the baseline, which
+		// leaves the builtins untouched.
+		public bool Reset() {
+			CheckDisposed();
+			CheckSessionThread();
+			_policy = null;
+			bool clean = jscontext_reset(_context) != 0;
+			SessionsEnded();
+			return clean;
+		}
+
+		// Keeps V8 locked and the context entered on this thread until the
+		// session is disposed (or EndSession() called), so that many small
+		// calls in a row don't pay for it each time; other threads using the
+		// engine wait meanwhile. Sessions nest and must end on the thread that
+		// began them:
+		//
+		//     using (context.BeginSession()) {
+		//         ...
+		//     }
+		//
+		// Reset() and Dispose() on that thread end them too; on any other
+		// thread they throw while a session is open.
+		public JsSession BeginSession() {
+			CheckDisposed();
+			// Returns with V8 locked for us: nobody else can be in a session.
+			jscontext_session_begin(_context);
+			lock (_sessionLock) {
+				_sessionThread = System.Threading.Thread.CurrentThread.ManagedThreadId;
+				_sessionDepth++;
+				return new JsSession(this, _sessionGeneration);
+			}
+		}
+
+		public void EndSession() {
+			CheckDisposed();
+			if (jscontext_session_end(_context) == 0)
+				throw new InvalidOperationException("no session to end on this thread");
+			lock (_sessionLock) {
+				if (--_sessionDepth == 0) {
+					_sessionThread = 0;
+					_sessionGeneration++;
+				}
+			}
+		}
+
+		// From JsSession.Dispose(): nothing to do if the sessions of that
+		// generation were already ended by Reset() or Dispose().
+		internal void EndSession(int generation) {
+			lock (_sessionLock) {
+				if (_disposed || generation != _sessionGeneration)
+					return;
+			}
+			EndSession();
+		}
+
+		// The thread holding V8 in a session, if any, and how many sessions it
+		// has open. Changed only while V8 is locked, but also read by threads
+		// that haven't locked it, hence _sessionLock.
+		readonly object _sessionLock = new object();
+		int _sessionThread;
+		int _sessionDepth;
+		int _sessionGeneration;
+
+		// Waiting for V8 while another thread keeps it locked in a session
+		// would hang this one for as long as the session lasts, possibly
+		// forever.
+		internal bool SessionOnOtherThread {
+			get {
+				lock (_sessionLock)
+					return _sessionDepth > 0 && _sessionThread != System.Threading.Thread.CurrentThread.ManagedThreadId;
+			}
+		}
+
+		void CheckSessionThread() {
+			if (SessionOnOtherThread)
+				throw new InvalidOperationException("a session is open on another thread");
+		}
+
+		// Reset() and Dispose() end the sessions of the calling thread.
+		void SessionsEnded() {
+			lock (_sessionLock) {
+				if (_sessionDepth > 0) {
+					_sessionDepth = 0;
+					_sessionThread = 0;
+					_sessionGeneration++;
+				}
+			}
+		}
+
+		JsMarshalPolicy? _policy;
+
+		// How the results of this context are converted, null for the
+		// JsEngine defaults (and again after Reset()). Not to be changed
+		// while a call on the context is running.
+		public JsMarshalPolicy? Policy {
+			get { return _policy; }
+			set {
+				CheckDisposed();
+				if (value.HasValue) {
+					JsMarshalPolicy policy = value.Value;
+					jscontext_set_policy(_context, ref policy);
+				} else {
+					jscontext_set_policy(_context, IntPtr.Zero);
+				}
+				_policy = value;
+			}
+		}
+
 		public object Execute(JsScript script, TimeSpan? executionTimeout = null) {
 			if (script == null)
 				throw new ArgumentNullException("script");
@@ -199,6 +392,185 @@ namespace VroomJs
             return res;
         }
 
+		// Execute converting only as much of the result as mode says, e.g.
+		// nothing for scripts run for their side effects.
+		public object Execute(string code, JsResultMode mode, string name = null) {
+			if (code == null)
+				throw new ArgumentNullException("code");
+
+			CheckDisposed();
+
+			JsValue v = jscontext_execute_mode(_context, code, name ?? "<Unnamed Script>", mode);
+			object res = _convert.FromJsValue(v);
+			jsvalue_dispose(v);
+
+			Exception e = res as JsException;
+			if (e != null)
+				throw e;
+			return res;
+		}
+
+		public object Execute(JsScript script, JsResultMode mode) {
+			if (script == null)
+				throw new ArgumentNullException("script");
+
+			CheckDisposed();
+
+			JsValue v = jscontext_execute_script_mode(_context, script.Handle, mode);
+			object res = _convert.FromJsValue(v);
+			jsvalue_dispose(v);
+
+			Exception e = res as JsException;
+			if (e != null)
+				throw e;
+			return res;
+		}
+
+		// Execute with a policy for this call only, instead of Policy.
+		public object Execute(string code, JsMarshalPolicy policy, JsResultMode mode = JsResultMode.Full, string name = null) {
+			if (code == null)
+				throw new ArgumentNullException("code");
+
+			CheckDisposed();
+
+			JsValue v = jscontext_execute_policy(_context, code, name ?? "<Unnamed Script>", mode, ref policy);
+			object res = _convert.FromJsValue(v);
+			jsvalue_dispose(v);
+
+			Exception e = res as JsException;
+			if (e != null)
+				throw e;
+			return res;
+		}
+
+		public object Execute(JsScript script, JsMarshalPolicy policy, JsResultMode mode = JsResultMode.Full) {
+			if (script == null)
+				throw new ArgumentNullException("script");
+
+			CheckDisposed();
+
+			JsValue v = jscontext_execute_script_policy(_context, script.Handle, mode, ref policy);
+			object res = _convert.FromJsValue(v);
+			jsvalue_dispose(v);
+
+			Exception e = res as JsException;
+			if (e != null)
+				throw e;
+			return res;
+		}
+
+		internal object ConvertHandle(JsHandle handle) {
+			CheckDisposed();
+
+			JsValue v = jscontext_convert(_context, handle.Handle);
+			object res = _convert.FromJsValue(v);
+			jsvalue_dispose(v);
+
+			Exception e = res as JsException;
+			if (e != null)
+				throw e;
+			return res;
+		}
+
+		internal int GetHandleArrayLength(JsHandle handle) {
+			CheckDisposed();
+
+			JsValue v = jscontext_array_length(_context, handle.Handle);
+			object res = _convert.FromJsValue(v);
+			jsvalue_dispose(v);
+
+			Exception e = res as JsException;
+			if (e != null)
+				throw e;
+			return System.Convert.ToInt32(res);
+		}
+
+		internal Array GetHandleRange(JsHandle handle, int start, int count) {
+			CheckDisposed();
+
+			JsValue v = jscontext_array_get_range(_context, handle.Handle, start, count);
+			object res = _convert.FromJsValue(v);
+			jsvalue_dispose(v);
+
+			Exception e = res as JsException;
+			if (e != null)
+				throw e;
+			return (Array)res;
+		}
+
+		internal string ReadHandleString(JsHandle handle, int offset, int count) {
+			CheckDisposed();
+
+			JsValue v = jscontext_string_read(_context, handle.Handle, offset, count);
+			object res = _convert.FromJsValue(v);
+			jsvalue_dispose(v);
+
+			Exception e = res as JsException;
+			if (e != null)
+				throw e;
+			return (string)res;
+		}
+
+		// For scripts returning records: the result is a JsColumns with the
+		// given keys if it's an array of objects, else whatever Execute would
+		// have returned.
+		public object ExecuteColumns(string code, string[] names, string name = null) {
+			if (code == null)
+				throw new ArgumentNullException("code");
+			if (names == null)
+				throw new ArgumentNullException("names");
+
+			CheckDisposed();
+
+			JsValue v = jscontext_execute_columns(_context, code, name ?? "<Unnamed Script>", names, names.Length);
+			object res = _convert.FromJsValue(v);
+			jsvalue_dispose(v);
+
+			Exception e = res as JsException;
+			if (e != null)
+				throw e;
+			return res;
+		}
+
+		// ExecuteColumns converting only as much of the result as mode says:
+		// the columns are only built with JsResultMode.Full.
+		public object ExecuteColumns(string code, string[] names, JsResultMode mode, string name = null) {
+			if (code == null)
+				throw new ArgumentNullException("code");
+			if (names == null)
+				throw new ArgumentNullException("names");
+
+			CheckDisposed();
+
+			JsValue v = jscontext_execute_columns_policy(_context, code, name ?? "<Unnamed Script>", names, names.Length, mode, IntPtr.Zero);
+			object res = _convert.FromJsValue(v);
+			jsvalue_dispose(v);
+
+			Exception e = res as JsException;
+			if (e != null)
+				throw e;
+			return res;
+		}
+
+		// ExecuteColumns with a policy for this call only, instead of Policy.
+		public object ExecuteColumns(string code, string[] names, JsMarshalPolicy policy, JsResultMode mode = JsResultMode.Full, string name = null) {
+			if (code == null)
+				throw new ArgumentNullException("code");
+			if (names == null)
+				throw new ArgumentNullException("names");
+
+			CheckDisposed();
+
+			JsValue v = jscontext_execute_columns_policy(_context, code, name ?? "<Unnamed Script>", names, names.Length, mode, ref policy);
+			object res = _convert.FromJsValue(v);
+			jsvalue_dispose(v);
+
+			Exception e = res as JsException;
+			if (e != null)
+				throw e;
+			return res;
+		}
+
 		public object GetGlobal() 
 		{
 			CheckDisposed();	
@@ -249,6 +621,81 @@ namespace VroomJs
 			// TODO: Check the result of the operation for errors.
         }
 
+        // Same as above with a name registered with JsEngine.InternName().
+        public object GetVariable(int atom)
+        {
+            CheckDisposed();
+
+            JsValue v = jscontext_get_variable_atom(_context, atom);
+            object res = _convert.FromJsValue(v);
+            jsvalue_dispose(v);
+
+            Exception e = res as JsException;
+            if (e != null)
+                throw e;
+            return res;
+        }
+
+        public void SetVariable(int atom, object value)
+        {
+            CheckDisposed();
+
+            JsValue a = _convert.ToJsValue(value);
+            JsValue b = jscontext_set_variable_atom(_context, atom, a);
+            object res = _convert.FromJsValue(b);
+            jsvalue_dispose(a);
+            jsvalue_dispose(b);
+
+            Exception e = res as JsException;
+            if (e != null)
+                throw e;
+        }
+
+        // The variable serialized by JSON.stringify in V8, without building
+        // the CLR objects; null if it has no JSON form (e.g., undefined).
+        public string GetVariableJson(string name)
+        {
+            if (name == null)
+                throw new ArgumentNullException("name");
+
+            CheckDisposed();
+
+            JsValue v = jscontext_get_json(_context, name);
+            object res = _convert.FromJsValue(v);
+            jsvalue_dispose(v);
+
+            Exception e = res as JsException;
+            if (e != null)
+                throw e;
+            return (string)res;
+        }
+
+        public void SetVariableJson(string name, string json)
+        {
+            if (json == null)
+                throw new ArgumentNullException("json");
+            SetVariableJson(name, Encoding.UTF8.GetBytes(json));
+        }
+
+        // Parsed by JSON.parse in V8 straight from the UTF-8 bytes.
+        public void SetVariableJson(string name, byte[] json)
+        {
+            if (name == null)
+                throw new ArgumentNullException("name");
+            if (json == null)
+                throw new ArgumentNullException("json");
+
+            CheckDisposed();
+
+            JsValue v = jscontext_set_json(_context, name, json, json.Length);
+            object res = _convert.FromJsValue(v);
+            jsvalue_dispose(v);
+
+            Exception e = res as JsException;
+            if (e != null)
+                throw e;
+        }
+
 		public void SetFunction(string name, Delegate func) {
 			WeakDelegate del;
 			if (func.Target != null) {
@@ -281,6 +728,58 @@ namespace VroomJs
 	        _keepalives.Remove(slot);
         }
 
+		// Arrays of numbers handed to V8 as buffers stay pinned until V8 collects
+		// the last object backed by them; V8 releases them by address. The
+		// release comes from whatever thread runs the V8 GC, hence the lock.
+		readonly Dictionary<IntPtr, PinnedBuffer> _buffers = new Dictionary<IntPtr, PinnedBuffer>();
+
+		class PinnedBuffer
+		{
+			public GCHandle Handle;
+			public int Refs;
+		}
+
+		internal JsValue KeepAlivePin(Array array, JsValueType type)
+		{
+			GCHandle handle = GCHandle.Alloc(array, GCHandleType.Pinned);
+			IntPtr data = handle.AddrOfPinnedObject();
+
+			lock (_buffers) {
+				PinnedBuffer buffer;
+				if (_buffers.TryGetValue(data, out buffer)) {
+					// Already pinned by another object.
+					handle.Free();
+				} else {
+					buffer = new PinnedBuffer { Handle = handle };
+					_buffers.Add(data, buffer);
+				}
+				buffer.Refs++;
+			}
+
+			return new JsValue { Type = type, Ptr = data, Length = array.Length };
+		}
+
+		internal Array KeepAliveGetBuffer(IntPtr data)
+		{
+			lock (_buffers) {
+				PinnedBuffer buffer;
+				if (_buffers.TryGetValue(data, out buffer))
+					return (Array)buffer.Handle.Target;
+				return null;
+			}
+		}
+
+		internal void KeepAliveReleaseBuffer(IntPtr data)
+		{
+			lock (_buffers) {
+				PinnedBuffer buffer;
+				if (_buffers.TryGetValue(data, out buffer) && --buffer.Refs == 0) {
+					buffer.Handle.Free();
+					_buffers.Remove(data);
+				}
+			}
+		}
+
 		#endregion
 
         #region IDisposable implementation
@@ -301,15 +800,24 @@ namespace VroomJs
         protected virtual void Dispose(bool disposing)
         {
             CheckDisposed();
+			CheckSessionThread();
 
             _disposed = true;
 			
 			jscontext_dispose(_context);
+			SessionsEnded();
 
 			if (disposing) {
 				_keepalives.Clear();
 			}
 
+			// Pinned memory isn't going to be released by anyone else.
+			lock (_buffers) {
+				foreach (PinnedBuffer buffer in _buffers.Values)
+					buffer.Handle.Free();
+				_buffers.Clear();
+			}
+
 			_notifyDispose(_id);
         }
 
@@ -324,7 +832,9 @@ namespace VroomJs
 
         ~JsContext()
         {
-            if (!_engine.IsDisposed && !_disposed)
+			// A session left open keeps V8 locked by its thread: better to leak
+			// the context than to hang the finalizer thread.
+            if (!_engine.IsDisposed && !_disposed && !SessionOnOtherThread)
                 Dispose(false);
         }
 
@@ -338,16 +848,9 @@ namespace VroomJs
 				return true;
 			}
 
-			BindingFlags flags;
-			if (type == obj) {
-				flags = BindingFlags.Public | BindingFlags.Static;
-			} else {
-				flags = BindingFlags.Public | BindingFlags.Instance;
-			}
-
-			PropertyInfo pi = type.GetProperty(name, flags | BindingFlags.SetProperty);
+			PropertyInfo pi = _engine.MemberCache.Resolve(type, name, type == obj) as PropertyInfo;
 			if (pi != null) {
-				pi.SetValue(obj, _convert.FromJsValue(value), null);
+				_engine.MemberCache.GetAccessor(pi).Set(obj, _convert.FromJsValue(value));
 				return true;
 			}
 			
@@ -358,8 +861,6 @@ namespace VroomJs
 #if DEBUG_TRACE_API
 			Console.WriteLine("setting prop " + name);
 #endif
-			// TODO: This is pretty slow: use a cache of generated code to make it faster.
-
 			var obj = KeepAliveGet(slot);
 			if (obj != null) {
 				Type type;
@@ -407,25 +908,11 @@ namespace VroomJs
 				return true;
 			}
 
-			BindingFlags flags;
-			if (type == obj) {
-				flags = BindingFlags.Public | BindingFlags.Static;
-			} else {
-				flags = BindingFlags.Public | BindingFlags.Instance;
-			}
-
-			// First of all try with a public property (the most common case).
-			PropertyInfo pi = type.GetProperty(name, flags | BindingFlags.GetProperty);
-			if (pi != null) {
-				result = pi.GetValue(obj, null);
-				value = _convert.ToJsValue(result);
-				return true;
-			}
+			// Property, field or method, in this order; resolved once per type and name.
+			MemberInfo member = _engine.MemberCache.Resolve(type, name, type == obj);
 
-			// try field.
-			FieldInfo fi = type.GetField(name, flags | BindingFlags.GetProperty);
-			if (fi != null) {
-				result = fi.GetValue(obj);
+			if (member is PropertyInfo || member is FieldInfo) {
+				result = _engine.MemberCache.GetAccessor(member).Get(obj);
 				value = _convert.ToJsValue(result);
 				return true;
 			}
@@ -434,10 +921,7 @@ namespace VroomJs
 			// parameter types so we just check if any method with the given name exists
 			// and then keep alive a "weak delegate", i.e., just a name and the target.
 			// The real method will be resolved during the invokation itself.
-			BindingFlags mFlags = flags | BindingFlags.InvokeMethod | BindingFlags.FlattenHierarchy;
-
-			// TODO: This is probably slooow.
-			if (type.GetMethods(mFlags).Any(x => x.Name == name)) {
+			if (member is MethodInfo) {
 				if (type == obj) {
 					result = new WeakDelegate(type, name);
 				} else {
@@ -461,7 +945,6 @@ namespace VroomJs
 				return JsValue.Empty;
 			}
 			
-			// TODO: This is pretty slow: use a cache of generated code to make it faster.
 			var obj = KeepAliveGet(slot);
 			if (obj != null) {
 				Type type;
@@ -485,9 +968,16 @@ namespace VroomJs
 						}
 					}
 					
-					// Else an error.
-					return JsValue.Error(KeepAliveAdd(
-						new InvalidOperationException(String.Format("property not found on {0}: {1} ", type, name))));
+					// Collections have a length, so that JS can loop over them
+					// with the indexed accessors.
+					ICollection collection = obj as ICollection;
+					if (collection != null && !(obj is IDictionary) && name == "length") {
+						return _convert.ToJsValue(collection.Count);
+					}
+
+					// Else let the native side throw (see KeepAliveMissingProperty),
+					// it remembers the type doesn't have it and won't ask again.
+					return JsValue.NotFound;
 				} catch (TargetInvocationException e) {
 					// Client code probably isn't interested in the exception part related to
 					// reflection, so we unwrap it and pass to V8 only the real exception thrown.
@@ -502,6 +992,18 @@ namespace VroomJs
 			return JsValue.Error(KeepAliveAdd(new IndexOutOfRangeException("invalid keepalive slot: " + slot)));
 		}
 
+		// The error for a name KeepAliveGetPropertyValue() didn't find, now or
+		// when the native side first asked for it on this type.
+		internal JsValue KeepAliveMissingProperty(int slot, string name) {
+			var obj = KeepAliveGet(slot);
+			if (obj == null)
+				return JsValue.Error(KeepAliveAdd(new IndexOutOfRangeException("invalid keepalive slot: " + slot)));
+
+			Type type = obj as Type ?? obj.GetType();
+			return JsValue.Error(KeepAliveAdd(
+				new InvalidOperationException(String.Format("property not found on {0}: {1} ", type, name))));
+		}
+
 		internal JsValue KeepAliveValueOf(int slot) {
 			var obj = KeepAliveGet(slot);
 			if (obj != null) {
@@ -517,7 +1019,6 @@ namespace VroomJs
 		}
 
 		internal JsValue KeepAliveInvoke(int slot, JsValue args) {
-			// TODO: This is pretty slow: use a cache of generated code to make it faster.
 #if DEBUG_TRACE_API
 			Console.WriteLine("invoking");
 #endif
@@ -543,8 +1044,6 @@ namespace VroomJs
 #if DEBUG_TRACE_API
 				Console.WriteLine("invoking " + obj.Target + " method " + obj.MethodName);
 #endif
-				object[] a = (object[])_convert.FromJsValue(args);
-
 				BindingFlags flags = BindingFlags.Public
 						| BindingFlags.InvokeMethod | BindingFlags.FlattenHierarchy;
 
@@ -557,15 +1056,117 @@ namespace VroomJs
 				if (obj is BoundWeakDelegate) {
 					flags |= BindingFlags.NonPublic;
 				}
-				
-				// need to convert methods from JsFunction's into delegates?
-				if (a.Any(z => z != null && z.GetType() == typeof(JsFunction))) {
-					CheckAndResolveJsFunctions(type, func.MethodName, flags, a);
+
+				return InvokeMethod(type, func.Target, func.MethodName, flags, args);
+			}
+
+			return JsValue.Error(KeepAliveAdd(new IndexOutOfRangeException("invalid keepalive slot: " + slot)));
+		}
+
+		private JsValue InvokeMethod(Type type, object target, string methodName, BindingFlags flags, JsValue args) {
+			object[] a = (object[])_convert.FromJsValue(args);
+			
+			// need to convert methods from JsFunction's into delegates?
+			if (a.Any(z => z != null && z.GetType() == typeof(JsFunction))) {
+				CheckAndResolveJsFunctions(type, methodName, flags, a);
+			}
+
+			try {
+				object result = _engine.MemberCache.GetInvoker(type, methodName, flags).Invoke(target, a);
+				return _convert.ToJsValue(result);
+			} catch (TargetInvocationException e) {
+				return JsValue.Error(KeepAliveAdd(e.InnerException));
+			} catch (Exception e) {
+				return JsValue.Error(KeepAliveAdd(e));
+			}
+		}
+
+		// Indexed property callback: obj[i] on managed lists and arrays. The ops
+		// match JSINDEXED_* on the native side. Anything that isn't a list, e.g.
+		// a dictionary with numeric keys, gets the index as a property name.
+		internal JsValue KeepAliveIndexed(int slot, int op, uint index, JsValue value) {
+			object obj = KeepAliveGet(slot);
+			IList list = obj as IList;
+			if (list == null) {
+				string name = index.ToString(System.Globalization.CultureInfo.InvariantCulture);
+				switch (op) {
+				case 0: // JSINDEXED_GET
+					return KeepAliveGetPropertyValue(slot, name);
+				case 1: // JSINDEXED_SET
+					return KeepAliveSetPropertyValue(slot, name, value);
+				}
+				return JsValue.Empty;
+			}
+
+			try {
+				switch (op) {
+				case 0: // JSINDEXED_GET
+					if (index >= (uint)list.Count)
+						return JsValue.Empty;
+					return _convert.ToJsValue(list[(int)index]);
+
+				case 1: // JSINDEXED_SET
+					object item = ConvertElement(list, _convert.FromJsValue(value));
+					if (index < (uint)list.Count)
+						list[(int)index] = item;
+					else if (index == (uint)list.Count && !list.IsFixedSize)
+						list.Add(item);
+					else
+						return JsValue.Error(KeepAliveAdd(new IndexOutOfRangeException("index out of range: " + index)));
+					return JsValue.Null;
+
+				case 2: // JSINDEXED_LENGTH
+					return _convert.ToJsValue(list.Count);
 				}
+			} catch (Exception e) {
+				return JsValue.Error(KeepAliveAdd(e));
+			}
 
+			return JsValue.Empty;
+		}
+
+		// Element type of each list type seen, null if not typed.
+		static readonly Dictionary<Type, Type> _elementTypes =
+			new Dictionary<Type, Type>();
+
+		// JS numbers come back as int or double: make them fit typed lists.
+		static object ConvertElement(IList list, object item) {
+			if (item == null)
+				return null;
+
+			Type type = list.GetType();
+			Type elementType;
+			lock (_elementTypes) {
+				if (!_elementTypes.TryGetValue(type, out elementType)) {
+					if (type.IsArray) {
+						elementType = type.GetElementType();
+					} else {
+						Type generic = type.GetInterfaces().FirstOrDefault(
+							i => i.IsGenericType && i.GetGenericTypeDefinition() == typeof(System.Collections.Generic.IList<>));
+						if (generic != null)
+							elementType = generic.GetGenericArguments()[0];
+					}
+					_elementTypes.Add(type, elementType);
+				}
+			}
+
+			if (elementType == null || elementType.IsInstanceOfType(item) || !(item is IConvertible))
+				return item;
+			return Convert.ChangeType(item, elementType, System.Globalization.CultureInfo.InvariantCulture);
+		}
+
+		// Callbacks for the members of types registered with
+		// JsEngine.RegisterType(), by their index in the registration.
+
+		internal JsValue KeepAliveGetMember(int slot, int member) {
+			var obj = KeepAliveGet(slot);
+			if (obj != null) {
+				MemberInfo mi = _engine.GetTypeMember(obj.GetType(), member);
 				try {
-					object result = type.InvokeMember(func.MethodName, flags, null, func.Target, a);
-					return _convert.ToJsValue(result);
+					if (mi is PropertyInfo || mi is FieldInfo)
+						return _convert.ToJsValue(_engine.MemberCache.GetAccessor(mi).Get(obj));
+					return JsValue.Error(KeepAliveAdd(
+						new InvalidOperationException(String.Format("no member {0} on {1}", member, obj.GetType()))));
 				} catch (TargetInvocationException e) {
 					return JsValue.Error(KeepAliveAdd(e.InnerException));
 				} catch (Exception e) {
@@ -576,6 +1177,44 @@ namespace VroomJs
 			return JsValue.Error(KeepAliveAdd(new IndexOutOfRangeException("invalid keepalive slot: " + slot)));
 		}
 
+		internal JsValue KeepAliveSetMember(int slot, int member, JsValue value) {
+			var obj = KeepAliveGet(slot);
+			if (obj != null) {
+				MemberInfo mi = _engine.GetTypeMember(obj.GetType(), member);
+				try {
+					if (mi is PropertyInfo || mi is FieldInfo) {
+						_engine.MemberCache.GetAccessor(mi).Set(obj, _convert.FromJsValue(value));
+						return JsValue.Null;
+					}
+					return JsValue.Error(KeepAliveAdd(
+						new InvalidOperationException(String.Format("no member {0} on {1}", member, obj.GetType()))));
+				} catch (TargetInvocationException e) {
+					return JsValue.Error(KeepAliveAdd(e.InnerException));
+				} catch (Exception e) {
+					return JsValue.Error(KeepAliveAdd(e));
+				}
+			}
+
+			return JsValue.Error(KeepAliveAdd(new IndexOutOfRangeException("invalid keepalive slot: " + slot)));
+		}
+
+		internal JsValue KeepAliveInvokeMember(int slot, int member, JsValue args) {
+			var obj = KeepAliveGet(slot);
+			if (obj != null) {
+				MethodInfo mi = _engine.GetTypeMember(obj.GetType(), member) as MethodInfo;
+				if (mi == null) {
+					return JsValue.Error(KeepAliveAdd(
+						new InvalidOperationException(String.Format("no method {0} on {1}", member, obj.GetType()))));
+				}
+				// By name, so that overloads are resolved against the arguments.
+				BindingFlags flags = BindingFlags.Public | BindingFlags.Instance
+						| BindingFlags.InvokeMethod | BindingFlags.FlattenHierarchy;
+				return InvokeMethod(obj.GetType(), obj, mi.Name, flags, args);
+			}
+
+			return JsValue.Error(KeepAliveAdd(new IndexOutOfRangeException("invalid keepalive slot: " + slot)));
+		}
+
 		private static void CheckAndResolveJsFunctions(Type type, string methodName, BindingFlags flags, object[] args) {
 			MethodInfo mi = type.GetMethod(methodName, flags);
 			ParameterInfo[] paramTypes = mi.GetParameters();
@@ -642,6 +1281,14 @@ namespace VroomJs
 		}
 
 		public object Invoke(IntPtr funcPtr, IntPtr thisPtr, object[] args) {
+			return Invoke(funcPtr, thisPtr, args, JsResultMode.Full);
+		}
+
+		public object Invoke(IntPtr funcPtr, IntPtr thisPtr, object[] args, JsResultMode mode) {
+			return Invoke(funcPtr, thisPtr, args, mode, null);
+		}
+
+		public object Invoke(IntPtr funcPtr, IntPtr thisPtr, object[] args, JsResultMode mode, JsMarshalPolicy? policy) {
 			CheckDisposed();
 
 			if (funcPtr == IntPtr.Zero)
@@ -651,7 +1298,13 @@ namespace VroomJs
 			if (args != null)
 				a = _convert.ToJsValue(args);
 
-			JsValue v = jscontext_invoke(_context, funcPtr, thisPtr, a);
+			JsValue v;
+			if (policy.HasValue) {
+				JsMarshalPolicy p = policy.Value;
+				v = jscontext_invoke_policy(_context, funcPtr, thisPtr, a, mode, ref p);
+			} else {
+				v = mode == JsResultMode.Full ? jscontext_invoke(_context, funcPtr, thisPtr, a) : jscontext_invoke_mode(_context, funcPtr, thisPtr, a, mode);
+			}
 			object res = _convert.FromJsValue(v);
 			jsvalue_dispose(v);
 			jsvalue_dispose(a);
@@ -661,5 +1314,48 @@ namespace VroomJs
 				throw e;
 			return res;
 		}
+
+		// Arguments and result as JSON: args is a JSON array (or null for no
+		// arguments) and the result is null if it has no JSON form.
+		public string InvokeJson(IntPtr funcPtr, IntPtr thisPtr, string args) {
+			CheckDisposed();
+
+			if (funcPtr == IntPtr.Zero)
+				throw new JsInteropException("wrapped V8 function is empty (IntPtr is Zero)");
+
+			byte[] a = args != null ? Encoding.UTF8.GetBytes(args) : null;
+			JsValue v = jscontext_invoke_json(_context, funcPtr, thisPtr, a, a != null ? a.Length : 0);
+			object res = _convert.FromJsValue(v);
+			jsvalue_dispose(v);
+
+			Exception e = res as JsException;
+			if (e != null)
+				throw e;
+			return (string)res;
+		}
+
+		// Calls the function once per argument set in a single trip to V8.
+		// A call that throws doesn't stop the others: its slot in the result
+		// holds the exception instead of a value.
+		public object[] InvokeBatch(IntPtr funcPtr, IntPtr thisPtr, object[][] argsets) {
+			if (argsets == null)
+				throw new ArgumentNullException("argsets");
+
+			CheckDisposed();
+
+			if (funcPtr == IntPtr.Zero)
+				throw new JsInteropException("wrapped V8 function is empty (IntPtr is Zero)");
+
+			JsValue a = _convert.ToJsValue(argsets);
+			JsValue v = jscontext_invoke_batch(_context, funcPtr, thisPtr, a);
+			object res = _convert.FromJsValue(v);
+			jsvalue_dispose(v);
+			jsvalue_dispose(a);
+
+			Exception e = res as Exception;
+			if (e != null)
+				throw e;
+			return (object[])res;
+		}
 	}
 }
@@ -24,7 +24,9 @@
 // THE SOFTWARE.
 
 using System;
+using System.Collections.Generic;
 using System.Runtime.InteropServices;
+using System.Text;
 
 namespace VroomJs
 {
@@ -39,8 +41,58 @@ namespace VroomJs
 
         readonly JsContext _context;
 
+        // Arrays of these go to V8 pinned, without converting their elements.
+        internal static readonly Dictionary<Type, JsValueType> BufferTypes = new Dictionary<Type, JsValueType> {
+            { typeof(SByte), JsValueType.Int8Buffer },
+            { typeof(Byte), JsValueType.UInt8Buffer },
+            { typeof(Int16), JsValueType.Int16Buffer },
+            { typeof(UInt16), JsValueType.UInt16Buffer },
+            { typeof(Int32), JsValueType.Int32Buffer },
+            { typeof(UInt32), JsValueType.UInt32Buffer },
+            { typeof(Single), JsValueType.FloatBuffer },
+            { typeof(Double), JsValueType.DoubleBuffer }
+        };
+
+        static readonly Dictionary<JsValueType, Type> BufferElementTypes = new Dictionary<JsValueType, Type> {
+            { JsValueType.Int8Buffer, typeof(SByte) },
+            { JsValueType.UInt8Buffer, typeof(Byte) },
+            { JsValueType.Int16Buffer, typeof(Int16) },
+            { JsValueType.UInt16Buffer, typeof(UInt16) },
+            { JsValueType.Int32Buffer, typeof(Int32) },
+            { JsValueType.UInt32Buffer, typeof(UInt32) },
+            { JsValueType.FloatBuffer, typeof(Single) },
+            { JsValueType.DoubleBuffer, typeof(Double) }
+        };
+
+        // The non-empty arrays, dictionaries and columns of the conversion in
+        // progress by their address in the tree (their offset in a flat
+        // block), for the references to them.
+        Dictionary<IntPtr, object> _references;
+        int _nesting;
+
         public object FromJsValue(JsValue v)
         {
+            _nesting++;
+            try {
+                return ConvertJsValue(v);
+            } finally {
+                if (--_nesting == 0 && _references != null)
+                    _references.Clear();
+            }
+        }
+
+        // Before converting what's inside: a reference can be a cycle.
+        private void AddReference(JsValue v, object obj)
+        {
+            if (v.Length == 0)
+                return;
+            if (_references == null)
+                _references = new Dictionary<IntPtr, object>();
+            _references[v.Ptr] = obj;
+        }
+
+        private object ConvertJsValue(JsValue v)
+        {
 #if DEBUG_TRACE_API
 			Console.WriteLine("Converting Js value to .net");
 #endif
@@ -62,8 +114,20 @@ namespace VroomJs
 					return v.Num;
 
 				case JsValueType.String:
+				case JsValueType.ExternalString:
 					return Marshal.PtrToStringUni(v.Ptr);
 
+				case JsValueType.AsciiString:
+					// One byte per character, valid in any ANSI code page.
+					return Marshal.PtrToStringAnsi(v.Ptr, v.Length);
+
+				case JsValueType.Json: {
+					// UTF-8, Length is in bytes.
+					byte[] bytes = new byte[v.Length];
+					Marshal.Copy(v.Ptr, bytes, 0, v.Length);
+					return Encoding.UTF8.GetString(bytes);
+				}
+
 				case JsValueType.Date:
 					/*
                     // The formula (v.num * 10000) + 621355968000000000L was taken from a StackOverflow
@@ -75,6 +139,7 @@ namespace VroomJs
 
 				case JsValueType.Array: {
 					var r = new object[v.Length];
+					AddReference(v, r);
 					for (int i = 0; i < v.Length; i++) {
 						var vi = (JsValue)Marshal.PtrToStructure(new IntPtr(v.Ptr.ToInt64() + (16 * i)), typeof(JsValue));
 						r[i] = FromJsValue(vi);
@@ -107,10 +172,9 @@ namespace VroomJs
 #if NET40
                 case JsValueType.Wrapped:
                     return new JsObject(_context, v.Ptr);
-#else
+#endif
 				case JsValueType.Dictionary:
             		return JsDictionaryObject(v);
-#endif
 				case JsValueType.Error:
             		return JsException.Create(this, (JsError)Marshal.PtrToStructure(v.Ptr, typeof(JsError)));
 
@@ -120,15 +184,146 @@ namespace VroomJs
 						fa[i] = (JsValue)Marshal.PtrToStructure(new IntPtr(v.Ptr.ToInt64() + (16 * i)), typeof(JsValue));
 					}
             		return new JsFunction(_context, fa[0].Ptr, fa[1].Ptr);
+
+				case JsValueType.Flat:
+					unsafe {
+						byte* block = (byte*)v.Ptr;
+						return FromFlatValue(block, *(JsValue*)block);
+					}
+
+				case JsValueType.Columns: {
+					// The keys and then a column per key.
+					var keys = (object[])FromJsValue((JsValue)Marshal.PtrToStructure(v.Ptr, typeof(JsValue)));
+					var names = new string[keys.Length];
+					var columns = new Array[keys.Length];
+					var r = new JsColumns(names, columns, v.Length);
+					AddReference(v, r);
+					for (int i = 0; i < keys.Length; i++) {
+						names[i] = (string)keys[i];
+						var vi = (JsValue)Marshal.PtrToStructure(new IntPtr(v.Ptr.ToInt64() + (16 * (i + 1))), typeof(JsValue));
+						columns[i] = (Array)FromJsValue(vi);
+					}
+					return r;
+				}
+
+				case JsValueType.Handle:
+					return new JsHandle(_context, v.Ptr, v.Length);
+
+				case JsValueType.Reference: {
+					object target;
+					if (_references == null || !_references.TryGetValue(v.Ptr, out target))
+						return new JsInteropException("reference to an object not converted yet");
+					return target;
+				}
+
+				case JsValueType.Int32Array:
+					int[] ints = new int[v.Length];
+					Marshal.Copy(v.Ptr, ints, 0, v.Length);
+					return ints;
+
+				case JsValueType.DoubleArray:
+					double[] doubles = new double[v.Length];
+					Marshal.Copy(v.Ptr, doubles, 0, v.Length);
+					return doubles;
+
+				case JsValueType.Int8Buffer:
+				case JsValueType.UInt8Buffer:
+				case JsValueType.Int16Buffer:
+				case JsValueType.UInt16Buffer:
+				case JsValueType.Int32Buffer:
+				case JsValueType.UInt32Buffer:
+				case JsValueType.FloatBuffer:
+				case JsValueType.DoubleBuffer:
+					// Our own arrays come back as themselves.
+					Array buffer = _context != null ? _context.KeepAliveGetBuffer(v.Ptr) : null;
+					return buffer ?? CopyBuffer(v);
+
             	default:
                     throw new InvalidOperationException("unknown type code: " + v.Type);
             }           
         }
 
-#if !NET40 
-    	private JsObject JsDictionaryObject(JsValue v) 
+        // JsValueType.Flat: a whole tree in one block, with byte offsets from the
+        // start of the block where the tree has pointers (see js_flatten).
+        // Containers are walked here, everything else relocated and handed to
+        // FromJsValue.
+        private unsafe object FromFlatValue(byte* block, JsValue v)
+        {
+            switch (v.Type) {
+                case JsValueType.Array: {
+                    JsValue* nodes = (JsValue*)(block + v.Ptr.ToInt64());
+                    object[] r = new object[v.Length];
+                    AddReference(v, r);
+                    for (int i = 0; i < v.Length; i++)
+                        r[i] = FromFlatValue(block, nodes[i]);
+                    return r;
+                }
+                case JsValueType.Dictionary: {
+                    JsValue* nodes = (JsValue*)(block + v.Ptr.ToInt64());
+                    var obj = NewDictionaryObject(v.Length);
+                    AddReference(v, obj);
+                    for (int i = 0; i < v.Length * 2; i += 2)
+                        obj[(string)FromFlatValue(block, nodes[i])] = FromFlatValue(block, nodes[i + 1]);
+                    return obj;
+                }
+                case JsValueType.Columns: {
+                    JsValue* nodes = (JsValue*)(block + v.Ptr.ToInt64());
+                    int count = nodes[0].Length;
+                    var names = new string[count];
+                    var columns = new Array[count];
+                    var r = new JsColumns(names, columns, v.Length);
+                    AddReference(v, r);
+                    object[] keys = (object[])FromFlatValue(block, nodes[0]);
+                    for (int i = 0; i < count; i++) {
+                        names[i] = (string)keys[i];
+                        columns[i] = (Array)FromFlatValue(block, nodes[i + 1]);
+                    }
+                    return r;
+                }
+
+                case JsValueType.String:
+                case JsValueType.StringError:
+                case JsValueType.AsciiString:
+                case JsValueType.Int32Array:
+                case JsValueType.DoubleArray:
+                case JsValueType.Function:
+                    if (v.Ptr != IntPtr.Zero)
+                        v.Ptr = new IntPtr(block + v.Ptr.ToInt64());
+                    return FromJsValue(v);
+
+                default:
+                    return FromJsValue(v);
+            }
+        }
+
+        private static Array CopyBuffer(JsValue v)
+        {
+            Type elementType = BufferElementTypes[v.Type];
+            Array array = Array.CreateInstance(elementType, v.Length);
+            byte[] bytes = new byte[Buffer.ByteLength(array)];
+            Marshal.Copy(v.Ptr, bytes, 0, bytes.Length);
+            Buffer.BlockCopy(bytes, 0, array, 0, bytes.Length);
+            return array;
+        }
+
+#if NET40
+		// JsObject wraps a live V8 object here: dictionary mode results, only
+		// asked for through a JsMarshalPolicy, are plain dictionaries.
+		private static Dictionary<string, object> NewDictionaryObject(int count)
+		{
+			return new Dictionary<string, object>(count);
+		}
+#else
+		private static JsObject NewDictionaryObject(int count)
+		{
+			return new JsObject();
+		}
+#endif
+
+    	private object JsDictionaryObject(JsValue v) 
 		{
-			JsObject obj = new JsObject();
+			var obj = NewDictionaryObject(v.Length);
+			AddReference(v, obj);
 			for (int i = 0; i < (v.Length * 2); i += 2) 
 			{
 				var key = (JsValue)Marshal.PtrToStructure(new IntPtr(v.Ptr.ToInt64() + (16 * i)), typeof(JsValue));
@@ -137,7 +332,6 @@ namespace VroomJs
 			}
 			return obj;
     	}
-#endif
 
     	public JsValue ToJsValue(object obj)
         {
@@ -187,6 +381,12 @@ namespace VroomJs
                 Num = Convert.ToInt64(((DateTime)obj).Subtract(EPOCH).TotalMilliseconds) /*(((DateTime)obj).Ticks - 621355968000000000.0 + 26748000000000.0)/10000.0*/
             };
 
+            // Arrays of numbers wrapped in a JsBuffer are pinned and read by V8 in place.
+
+            var buffer = obj as JsBuffer;
+            if (buffer != null)
+                return _context.KeepAlivePin(buffer.Array, BufferTypes[buffer.Array.GetType().GetElementType()]);
+
             // Arrays of anything that can be cast to object[] are recursively convertef after
             // allocating an appropriate jsvalue on the unmanaged side.
 
@@ -204,9 +404,16 @@ namespace VroomJs
             // _keepalives list, to make sure the GC won't collect it while still in
             // use by the unmanaged Javascript engine. We don't try to track duplicates
             // because adding the same object more than one time acts more or less as
-            // reference counting.
+            // reference counting. Objects of types registered with JsEngine.RegisterType()
+            // also carry their type id, for V8 to use the template of the type, and
+            // all of them the key of their type for the native member cache.
 
-            return new JsValue { Type = JsValueType.Managed, Index = _context.KeepAliveAdd(obj) };
+            return new JsValue {
+                Type = JsValueType.Managed,
+                Index = _context.KeepAliveAdd(obj),
+                I32 = _context.Engine.GetTypeId(obj.GetType()),
+                TypeKey = _context.Engine.GetTypeKey(obj)
+            };
         }
     }
 }
@@ -1,5 +1,7 @@
 ﻿using System;
 using System.Collections.Generic;
+using System.Linq;
+using System.Reflection;
 using System.Runtime.InteropServices;
 using System.Threading;
 
@@ -13,10 +15,37 @@ namespace VroomJs {
 		delegate JsValue KeepAliveInvokeDelegate(int context, int slot, JsValue args);
 		delegate JsValue KeepAliveDeletePropertyDelegate(int context, int slot, [MarshalAs(UnmanagedType.LPWStr)] string name);
 		delegate JsValue KeepAliveEnumeratePropertiesDelegate(int context, int slot);
+		delegate JsValue KeepAliveGetMemberDelegate(int context, int slot, int member);
+		delegate JsValue KeepAliveSetMemberDelegate(int context, int slot, int member, JsValue value);
+		delegate JsValue KeepAliveInvokeMemberDelegate(int context, int slot, int member, JsValue args);
+		delegate JsValue KeepAliveIndexedDelegate(int context, int slot, int op, uint index, JsValue value);
+		delegate void KeepAliveReleaseBufferDelegate(int context, IntPtr data);
+		delegate JsValue KeepAliveMissingPropertyDelegate(int context, int slot, [MarshalAs(UnmanagedType.LPWStr)] string name);
 
 		[DllImport("VroomJsNative", CallingConvention = CallingConvention.StdCall)]
 		static extern void js_set_object_marshal_type(JsObjectMarshalType objectMarshalType);
 
+		[DllImport("VroomJsNative", CallingConvention = CallingConvention.StdCall)]
+		static extern void js_set_compact_strings(bool enabled);
+
+		[DllImport("VroomJsNative", CallingConvention = CallingConvention.StdCall)]
+		static extern void js_set_packed_arrays(bool enabled);
+
+		[DllImport("VroomJsNative", CallingConvention = CallingConvention.StdCall)]
+		static extern void js_set_flat_results(bool enabled);
+
+		[DllImport("VroomJsNative", CallingConvention = CallingConvention.StdCall)]
+		static extern void js_set_columnar_results(bool enabled);
+
+		[DllImport("VroomJsNative", CallingConvention = CallingConvention.StdCall)]
+		static extern void js_set_shared_objects(bool enabled);
+
+		[DllImport("VroomJsNative", CallingConvention = CallingConvention.StdCall)]
+		static extern void js_set_conversion_limits(int maxDepth, int maxNodes);
+
+		[DllImport("VroomJsNative", CallingConvention = CallingConvention.StdCall)]
+		static extern void js_set_max_string_length(int length);
+
 		[DllImport("VroomJsNative", CallingConvention = CallingConvention.StdCall)]
 		static extern void js_dump_allocated_items();
 
@@ -32,6 +61,76 @@ namespace VroomJs {
 			int maxYoungSpace, int maxOldSpace
 		);
 		
+		[DllImport("VroomJsNative", CallingConvention = CallingConvention.StdCall)]
+		static extern IntPtr jsenginepool_acquire(
+			HandleRef pool,
+			KeepaliveRemoveDelegate keepaliveRemove,
+			KeepAliveGetPropertyValueDelegate keepaliveGetPropertyValue,
+			KeepAliveSetPropertyValueDelegate keepaliveSetPropertyValue,
+			KeepAliveValueOfDelegate keepaliveValueOf,
+			KeepAliveInvokeDelegate keepaliveInvoke,
+			KeepAliveDeletePropertyDelegate keepaliveDeleteProperty,
+			KeepAliveEnumeratePropertiesDelegate keepaliveEnumerateProperties
+		);
+
+		[StructLayout(LayoutKind.Sequential)]
+		struct jsscriptcache_stats {
+			public long hits;
+			public long misses;
+			public long evictions;
+			public long size;
+			public long budget;
+			public int entries;
+			public int padding;
+		}
+
+		[DllImport("VroomJsNative", CallingConvention = CallingConvention.StdCall)]
+		static extern void jsengine_set_script_cache_budget(HandleRef engine, long budget);
+
+		[DllImport("VroomJsNative", CallingConvention = CallingConvention.StdCall)]
+		static extern void jsengine_get_script_cache_stats(HandleRef engine, out jsscriptcache_stats stats);
+
+		[StructLayout(LayoutKind.Sequential)]
+		struct jsmembercache_stats {
+			public long hits;
+			public long misses;
+			public long entries;
+		}
+
+		[DllImport("VroomJsNative", CallingConvention = CallingConvention.StdCall)]
+		static extern void jsengine_get_member_cache_stats(HandleRef engine, out jsmembercache_stats stats);
+
+		[DllImport("VroomJsNative", CallingConvention = CallingConvention.StdCall)]
+		static extern void jsengine_set_precompile_cache(HandleRef engine, [MarshalAs(UnmanagedType.LPWStr)] string directory);
+
+		[DllImport("VroomJsNative", CallingConvention = CallingConvention.StdCall)]
+		static extern int jsengine_intern_name(HandleRef engine, [MarshalAs(UnmanagedType.LPWStr)] string name);
+
+		[DllImport("VroomJsNative", CallingConvention = CallingConvention.StdCall)]
+		static extern void jsengine_set_member_delegates(HandleRef engine,
+			KeepAliveGetMemberDelegate keepaliveGetMember,
+			KeepAliveSetMemberDelegate keepaliveSetMember,
+			KeepAliveInvokeMemberDelegate keepaliveInvokeMember);
+
+		[DllImport("VroomJsNative", CallingConvention = CallingConvention.StdCall)]
+		static extern int jsengine_register_type(HandleRef engine,
+			[MarshalAs(UnmanagedType.LPArray, ArraySubType = UnmanagedType.LPWStr)] string[] names,
+			int[] kinds, int count);
+
+		[DllImport("VroomJsNative", CallingConvention = CallingConvention.StdCall)]
+		static extern void jsengine_set_indexed_delegate(HandleRef engine, KeepAliveIndexedDelegate keepaliveIndexed);
+
+		[DllImport("VroomJsNative", CallingConvention = CallingConvention.StdCall)]
+		static extern void jsengine_set_buffer_delegate(HandleRef engine, KeepAliveReleaseBufferDelegate keepaliveReleaseBuffer);
+
+		[DllImport("VroomJsNative", CallingConvention = CallingConvention.StdCall)]
+		static extern void jsengine_set_missing_property_delegate(HandleRef engine, KeepAliveMissingPropertyDelegate keepaliveMissingProperty);
+
+		// Member kinds for jsengine_register_type.
+		const int MemberKindGet = 1;
+		const int MemberKindSet = 2;
+		const int MemberKindMethod = 4;
+
 		[DllImport("VroomJsNative", CallingConvention = CallingConvention.StdCall)]
 		static extern void jsengine_terminate_execution(HandleRef engine);
 			
@@ -52,6 +151,28 @@ namespace VroomJs {
 		readonly KeepAliveInvokeDelegate _keepalive_invoke;
 		readonly KeepAliveDeletePropertyDelegate _keepalive_delete_property;
 		readonly KeepAliveEnumeratePropertiesDelegate _keepalive_enumerate_properties;
+		readonly KeepAliveGetMemberDelegate _keepalive_get_member;
+		readonly KeepAliveSetMemberDelegate _keepalive_set_member;
+		readonly KeepAliveInvokeMemberDelegate _keepalive_invoke_member;
+		readonly KeepAliveIndexedDelegate _keepalive_indexed;
+		readonly KeepAliveReleaseBufferDelegate _keepalive_release_buffer;
+		readonly KeepAliveMissingPropertyDelegate _keepalive_missing_property;
+
+		// Types registered with RegisterType(): the id V8 knows them by and
+		// their members, indexed like in the registration. Both under the lock
+		// of _typeIds, read by the conversions of any thread.
+		private readonly Dictionary<Type, int> _typeIds = new Dictionary<Type, int>();
+		private readonly Dictionary<int, MemberInfo[]> _typeMembers = new Dictionary<int, MemberInfo[]>();
+
+		// Keys of the CLR types of the objects handed to V8, for its cache of
+		// the names they don't have.
+		private readonly Dictionary<Type, int> _typeKeys = new Dictionary<Type, int>();
+
+		readonly JsMemberCache _memberCache = new JsMemberCache();
+
+		internal JsMemberCache MemberCache {
+			get { return _memberCache; }
+		}
 
 		private readonly Dictionary<int, JsContext> _aliveContexts = new Dictionary<int, JsContext>();
 		private readonly Dictionary<int, JsScript> _aliveScripts = new Dictionary<int, JsScript>();
@@ -59,6 +180,116 @@ namespace VroomJs {
 		private int _currentContextId = 0;
 		private int _currentScriptId = 0;
 
+		static bool _packedArrays;
+
+		// When set, JS arrays made only of numbers are returned as int[] (if all
+		// of them are 32-bit integers) or double[] instead of object[]. Applies
+		// to all the engines.
+		public static bool PackedArrays {
+			get { return _packedArrays; }
+			set {
+				js_set_packed_arrays(value);
+				_packedArrays = value;
+			}
+		}
+
+		static bool _flatResults;
+
+		// When set, array and object results come over from V8 as a single
+		// block, decoded in one pass and freed with one call, instead of a tree
+		// of separate allocations. Applies to all the engines.
+		public static bool FlatResults {
+			get { return _flatResults; }
+			set {
+				js_set_flat_results(value);
+				_flatResults = value;
+			}
+		}
+
+		static bool _columnarResults;
+
+		// When set, arrays of at least two objects with the same keys come
+		// back as JsColumns instead of object[] of dictionaries, with the keys
+		// marshaled once. Only in dictionary mode; applies to all the engines.
+		public static bool ColumnarResults {
+			get { return _columnarResults; }
+			set {
+				js_set_columnar_results(value);
+				_columnarResults = value;
+			}
+		}
+
+		static bool _sharedObjects;
+
+		// When set, an object reachable from more than one place in a result
+		// is converted once and shows up as the same CLR object everywhere.
+		// Cycles are preserved that way whether this is set or not. Applies to
+		// all the engines.
+		public static bool SharedObjects {
+			get { return _sharedObjects; }
+			set {
+				js_set_shared_objects(value);
+				_sharedObjects = value;
+			}
+		}
+
+		static int _maxConversionDepth;
+		static int _maxConversionNodes;
+
+		// Results nested deeper than this (or with more values than
+		// MaxConversionNodes) throw a JsException instead of being converted;
+		// 0 for no limit. Apply to all the engines.
+		public static int MaxConversionDepth {
+			get { return _maxConversionDepth; }
+			set {
+				js_set_conversion_limits(value, _maxConversionNodes);
+				_maxConversionDepth = value;
+			}
+		}
+
+		public static int MaxConversionNodes {
+			get { return _maxConversionNodes; }
+			set {
+				js_set_conversion_limits(_maxConversionDepth, value);
+				_maxConversionNodes = value;
+			}
+		}
+
+		static int _maxStringLength;
+
+		// String values longer than this make the whole result throw too.
+		public static int MaxStringLength {
+			get { return _maxStringLength; }
+			set {
+				js_set_max_string_length(value);
+				_maxStringLength = value;
+			}
+		}
+
+		static JsObjectMarshalType _objectMarshalType;
+
+		// All of the above, as used by contexts without a JsContext.Policy.
+		internal static JsMarshalPolicy DefaultPolicy {
+			get {
+				JsMarshalFlags flags = JsMarshalFlags.CompactStrings;
+				if (_packedArrays)
+					flags |= JsMarshalFlags.PackedArrays;
+				if (_flatResults)
+					flags |= JsMarshalFlags.FlatResults;
+				if (_columnarResults)
+					flags |= JsMarshalFlags.ColumnarResults;
+				if (_sharedObjects)
+					flags |= JsMarshalFlags.SharedObjects;
+				return new JsMarshalPolicy {
+					MarshalType = _objectMarshalType,
+					Flags = flags,
+					MaxDepth = _maxConversionDepth,
+					MaxNodes = _maxConversionNodes,
+					MaxStringLength = _maxStringLength
+				};
+			}
+		}
+
 		public static void DumpAllocatedItems() {
 			js_dump_allocated_items();
 		}
@@ -69,19 +300,16 @@ namespace VroomJs {
         	objectMarshalType = JsObjectMarshalType.Dynamic;
 #endif
 			js_set_object_marshal_type(objectMarshalType);
+			_objectMarshalType = objectMarshalType;
+			js_set_compact_strings(true);
 		}
 
 		readonly HandleRef _engine;
 
-		public JsEngine(int maxYoungSpace = -1, int maxOldSpace = -1) {
-			_keepalive_remove = new KeepaliveRemoveDelegate(KeepAliveRemove);
-			_keepalive_get_property_value = new KeepAliveGetPropertyValueDelegate(KeepAliveGetPropertyValue);
-			_keepalive_set_property_value = new KeepAliveSetPropertyValueDelegate(KeepAliveSetPropertyValue);
-			_keepalive_valueof = new KeepAliveValueOfDelegate(KeepAliveValueOf);
-			_keepalive_invoke = new KeepAliveInvokeDelegate(KeepAliveInvoke);
-			_keepalive_delete_property = new KeepAliveDeletePropertyDelegate(KeepAliveDeleteProperty);
-			_keepalive_enumerate_properties = new KeepAliveEnumeratePropertiesDelegate(KeepAliveEnumerateProperties);
-			
+		// Set when the engine came from a pool and must go back there on Dispose().
+		readonly JsEnginePool _pool;
+
+		public JsEngine(int maxYoungSpace = -1, int maxOldSpace = -1) : this() {
 			_engine = new HandleRef(this, jsengine_new(
 				_keepalive_remove,
 				_keepalive_get_property_value,
@@ -92,6 +320,47 @@ namespace VroomJs {
 				_keepalive_enumerate_properties,
 				maxYoungSpace, 
 				maxOldSpace));
+			SetDelegates();
+		}
+
+		internal JsEngine(JsEnginePool pool) : this() {
+			_pool = pool;
+			_engine = new HandleRef(this, jsenginepool_acquire(
+				pool.Handle,
+				_keepalive_remove,
+				_keepalive_get_property_value,
+				_keepalive_set_property_value, 
+				_keepalive_valueof,
+				_keepalive_invoke,
+				_keepalive_delete_property,
+				_keepalive_enumerate_properties));
+			SetDelegates();
+		}
+
+		// The delegates handed to the native engine, kept here so that the GC
+		// doesn't collect them while it can still call them.
+		private JsEngine() {
+			_keepalive_remove = new KeepaliveRemoveDelegate(KeepAliveRemove);
+			_keepalive_get_property_value = new KeepAliveGetPropertyValueDelegate(KeepAliveGetPropertyValue);
+			_keepalive_set_property_value = new KeepAliveSetPropertyValueDelegate(KeepAliveSetPropertyValue);
+			_keepalive_valueof = new KeepAliveValueOfDelegate(KeepAliveValueOf);
+			_keepalive_invoke = new KeepAliveInvokeDelegate(KeepAliveInvoke);
+			_keepalive_delete_property = new KeepAliveDeletePropertyDelegate(KeepAliveDeleteProperty);
+			_keepalive_enumerate_properties = new KeepAliveEnumeratePropertiesDelegate(KeepAliveEnumerateProperties);
+			_keepalive_get_member = new KeepAliveGetMemberDelegate(KeepAliveGetMember);
+			_keepalive_set_member = new KeepAliveSetMemberDelegate(KeepAliveSetMember);
+			_keepalive_invoke_member = new KeepAliveInvokeMemberDelegate(KeepAliveInvokeMember);
+			_keepalive_indexed = new KeepAliveIndexedDelegate(KeepAliveIndexed);
+			_keepalive_release_buffer = new KeepAliveReleaseBufferDelegate(KeepAliveReleaseBuffer);
+			_keepalive_missing_property = new KeepAliveMissingPropertyDelegate(KeepAliveMissingProperty);
+		}
+
+		// Those the native engine doesn't get at creation.
+		private void SetDelegates() {
+			jsengine_set_member_delegates(_engine, _keepalive_get_member, _keepalive_set_member, _keepalive_invoke_member);
+			jsengine_set_indexed_delegate(_engine, _keepalive_indexed);
+			jsengine_set_buffer_delegate(_engine, _keepalive_release_buffer);
+			jsengine_set_missing_property_delegate(_engine, _keepalive_missing_property);
 		}
 
 		public void TerminateExecution() {
@@ -102,6 +371,154 @@ namespace VroomJs {
 			jsengine_dump_heap_stats(_engine);
 		}
 
+		// Scripts run through JsContext.Execute(string) are compiled once and
+		// kept in a LRU cache shared by all the contexts of the engine. The
+		// budget is in bytes of cached source; 0 disables the cache.
+		public void SetScriptCacheBudget(long bytes) {
+			CheckDisposed();
+			jsengine_set_script_cache_budget(_engine, bytes);
+		}
+
+		// CompileScript() keeps the V8 precompile data of every script in this
+		// directory (created if missing) and reuses it in later processes,
+		// which skips most of the parsing of big scripts. Pass null to stop.
+		public void SetPrecompileCacheDirectory(string directory) {
+			CheckDisposed();
+			jsengine_set_precompile_cache(_engine, directory);
+		}
+
+		// Registers a property name once and returns an atom for it, valid in
+		// every context of this engine. The atom overloads of GetVariable(),
+		// GetPropertyValue() and friends skip marshaling and hashing the name
+		// on every call, which adds up when the same fields are read over
+		// and over.
+		public int InternName(string name) {
+			if (name == null)
+				throw new ArgumentNullException("name");
+			CheckDisposed();
+			return jsengine_intern_name(_engine, name);
+		}
+
+		// Gives the objects of the given type a V8 template of their own, with
+		// an accessor for each public property and field and a prototype
+		// method for each public method, instead of going through the generic
+		// named interceptor. V8 then sees a stable hidden class and its inline
+		// caches work, and the callbacks carry a member index instead of a
+		// name. Members are exposed both as declared and in lowerCamelCase.
+		// Only the members known at registration are visible from JS.
+		public void RegisterType(Type type) {
+			if (type == null)
+				throw new ArgumentNullException("type");
+			CheckDisposed();
+			lock (_typeIds) {
+				if (_typeIds.ContainsKey(type))
+					return;
+			}
+
+			var names = new List<string>();
+			var kinds = new List<int>();
+			var members = new List<MemberInfo>();
+			Action<string, int, MemberInfo> add = (name, kind, member) => {
+				foreach (string n in new[] { Char.ToLower(name[0]) + name.Substring(1), name }) {
+					// valueOf comes from the prototype, first member wins.
+					if (n == "valueOf" || names.Contains(n))
+						continue;
+					names.Add(n);
+					kinds.Add(kind);
+					members.Add(member);
+				}
+			};
+
+			BindingFlags flags = BindingFlags.Public | BindingFlags.Instance;
+			foreach (PropertyInfo pi in type.GetProperties(flags)) {
+				if (pi.GetIndexParameters().Length > 0)
+					continue;
+				int kind = (pi.CanRead ? MemberKindGet : 0) | (pi.CanWrite ? MemberKindSet : 0);
+				add(pi.Name, kind, pi);
+			}
+			foreach (FieldInfo fi in type.GetFields(flags)) {
+				add(fi.Name, fi.IsInitOnly || fi.IsLiteral ? MemberKindGet : MemberKindGet | MemberKindSet, fi);
+			}
+			foreach (MethodInfo mi in type.GetMethods(flags | BindingFlags.FlattenHierarchy).Where(m => !m.IsSpecialName)) {
+				add(mi.Name, MemberKindMethod, mi);
+			}
+
+			// Not locked across the call: it waits for V8, and a thread holding
+			// V8 can be converting. Losing a race only wastes a template.
+			int id = jsengine_register_type(_engine, names.ToArray(), kinds.ToArray(), names.Count);
+			lock (_typeIds) {
+				if (_typeIds.ContainsKey(type))
+					return;
+				_typeIds.Add(type, id);
+				_typeMembers.Add(id, members.ToArray());
+			}
+		}
+
+		// 0 when the members of obj can change from one read to the next: Type
+		// objects (their static members, but they all share a CLR type),
+		// dictionaries and dynamic objects.
+		internal int GetTypeKey(object obj) {
+			if (obj is Type || obj is System.Collections.IDictionary)
+				return 0;
+#if NET40
+			if (obj is System.Dynamic.IDynamicMetaObjectProvider)
+				return 0;
+#endif
+			Type type = obj.GetType();
+			// Contexts of the same engine convert on different threads.
+			lock (_typeKeys) {
+				int key;
+				if (!_typeKeys.TryGetValue(type, out key)) {
+					key = _typeKeys.Count + 1;
+					_typeKeys.Add(type, key);
+				}
+				return key;
+			}
+		}
+
+		internal void GetMemberCacheStats(JsEngineStats stats) {
+			jsmembercache_stats native;
+			jsengine_get_member_cache_stats(_engine, out native);
+			stats.MemberCacheHits = native.hits;
+			stats.MemberCacheMisses = native.misses;
+			stats.MemberCacheEntries = native.entries;
+		}
+
+		// 0 for types that weren't registered.
+		internal int GetTypeId(Type type) {
+			int id;
+			lock (_typeIds) {
+				_typeIds.TryGetValue(type, out id);
+			}
+			return id;
+		}
+
+		internal MemberInfo GetTypeMember(Type type, int member) {
+			int id;
+			MemberInfo[] members;
+			lock (_typeIds) {
+				if (!_typeIds.TryGetValue(type, out id) || !_typeMembers.TryGetValue(id, out members))
+					return null;
+			}
+			if (member < 0 || member >= members.Length)
+				return null;
+			return members[member];
+		}
+
+		public JsScriptCacheStats GetScriptCacheStats() {
+			CheckDisposed();
+			jsscriptcache_stats stats;
+			jsengine_get_script_cache_stats(_engine, out stats);
+			return new JsScriptCacheStats {
+				Hits = stats.hits,
+				Misses = stats.misses,
+				Evictions = stats.evictions,
+				Size = stats.size,
+				Budget = stats.budget,
+				Entries = stats.entries
+			};
+		}
+
 		public void DisposeObject(IntPtr ptr) {
 			// If the engine has already been explicitly disposed we pass Zero as
 			// the first argument because we need to free the memory allocated by
@@ -179,6 +596,54 @@ namespace VroomJs {
 			return value;
 		}
 
+		private JsValue KeepAliveGetMember(int contextId, int slot, int member) {
+			JsContext context;
+			if (!_aliveContexts.TryGetValue(contextId, out context)) {
+				throw new Exception("fail");
+			}
+			return context.KeepAliveGetMember(slot, member);
+		}
+
+		private JsValue KeepAliveSetMember(int contextId, int slot, int member, JsValue value) {
+			JsContext context;
+			if (!_aliveContexts.TryGetValue(contextId, out context)) {
+				throw new Exception("fail");
+			}
+			return context.KeepAliveSetMember(slot, member, value);
+		}
+
+		private JsValue KeepAliveInvokeMember(int contextId, int slot, int member, JsValue args) {
+			JsContext context;
+			if (!_aliveContexts.TryGetValue(contextId, out context)) {
+				throw new Exception("fail");
+			}
+			return context.KeepAliveInvokeMember(slot, member, args);
+		}
+
+		private JsValue KeepAliveIndexed(int contextId, int slot, int op, uint index, JsValue value) {
+			JsContext context;
+			if (!_aliveContexts.TryGetValue(contextId, out context)) {
+				throw new Exception("fail");
+			}
+			return context.KeepAliveIndexed(slot, op, index, value);
+		}
+
+		private void KeepAliveReleaseBuffer(int contextId, IntPtr data) {
+			JsContext context;
+			if (!_aliveContexts.TryGetValue(contextId, out context)) {
+				return;
+			}
+			context.KeepAliveReleaseBuffer(data);
+		}
+
+		private JsValue KeepAliveMissingProperty(int contextId, int slot, string name) {
+			JsContext context;
+			if (!_aliveContexts.TryGetValue(contextId, out context)) {
+				throw new Exception("fail");
+			}
+			return context.KeepAliveMissingProperty(slot, name);
+		}
+
 		private void KeepAliveRemove(int contextId, int slot) {
 #if DEBUG_TRACE_API
 			Console.WriteLine("Keep alive remove for " + contextId + " " + slot);
@@ -232,6 +697,13 @@ namespace VroomJs {
         {
             CheckDisposed();
 
+			if (disposing) {
+				foreach (var aliveContext in _aliveContexts) {
+					if (aliveContext.Value.SessionOnOtherThread)
+						throw new InvalidOperationException("a session is open on another thread");
+				}
+			}
+
             _disposed = true;
 
             if (disposing) {
@@ -247,7 +719,11 @@ namespace VroomJs {
 				Console.WriteLine("Calling jsEngine dispose: " + _engine.Handle.ToInt64());
 #endif
         
-			jsengine_dispose(_engine);
+			// The pool checks the engine is clean before reusing it.
+			if (_pool != null && !_pool.IsDisposed)
+				_pool.Release(_engine);
+			else
+				jsengine_dispose(_engine);
         }
 
         void CheckDisposed()
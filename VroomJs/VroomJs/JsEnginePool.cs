@@ -0,0 +1,130 @@
+// This file is part of the VroomJs library.
+//
+// Author:
+//     Federico Di Gregorio <fog@initd.org>
+//
+// Copyright (c) 2013 
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+using System;
+using System.Runtime.InteropServices;
+
+namespace VroomJs
+{
+    // Keeps initialized engines around so that getting one doesn't pay for
+    // creating the isolate and its global context. Engines are given back to
+    // the pool by disposing them; the pool reuses them only if all their
+    // contexts were disposed too.
+    public class JsEnginePool : IDisposable
+    {
+        [StructLayout(LayoutKind.Sequential)]
+        struct jsenginepool_stats
+        {
+            public long hits;
+            public long misses;
+            public long created;
+            public long recycled;
+            public long discarded;
+            public long creation_time_total;
+            public long creation_time_max;
+            public int idle;
+            public int leased;
+        }
+
+        [DllImport("VroomJsNative", CallingConvention = CallingConvention.StdCall)]
+        static extern IntPtr jsenginepool_new(int minSize, int maxSize, int maxYoungSpace, int maxOldSpace);
+
+        [DllImport("VroomJsNative", CallingConvention = CallingConvention.StdCall)]
+        static extern void jsenginepool_release(HandleRef pool, HandleRef engine);
+
+        [DllImport("VroomJsNative", CallingConvention = CallingConvention.StdCall)]
+        static extern void jsenginepool_get_stats(HandleRef pool, out jsenginepool_stats stats);
+
+        [DllImport("VroomJsNative", CallingConvention = CallingConvention.StdCall)]
+        static extern void jsenginepool_dispose(HandleRef pool);
+
+        readonly HandleRef _pool;
+
+        public JsEnginePool(int minSize, int maxSize, int maxYoungSpace = -1, int maxOldSpace = -1)
+        {
+            _pool = new HandleRef(this, jsenginepool_new(minSize, maxSize, maxYoungSpace, maxOldSpace));
+        }
+
+        internal HandleRef Handle
+        {
+            get { return _pool; }
+        }
+
+        public JsEngine Acquire()
+        {
+            CheckDisposed();
+            return new JsEngine(this);
+        }
+
+        internal void Release(HandleRef engine)
+        {
+            jsenginepool_release(_pool, engine);
+        }
+
+        public JsEnginePoolStats GetStats()
+        {
+            CheckDisposed();
+            jsenginepool_stats stats;
+            jsenginepool_get_stats(_pool, out stats);
+            return new JsEnginePoolStats {
+                Hits = stats.hits,
+                Misses = stats.misses,
+                Created = stats.created,
+                Recycled = stats.recycled,
+                Discarded = stats.discarded,
+                TotalCreationTime = TimeSpan.FromTicks(stats.creation_time_total * 10),
+                MaxCreationTime = TimeSpan.FromTicks(stats.creation_time_max * 10),
+                Idle = stats.idle,
+                Leased = stats.leased
+            };
+        }
+
+        #region IDisposable implementation
+
+        bool _disposed;
+
+        public bool IsDisposed
+        {
+            get { return _disposed; }
+        }
+
+        // Engines still leased are not touched: disposing them later frees
+        // them directly instead of handing them back.
+        public void Dispose()
+        {
+            CheckDisposed();
+            _disposed = true;
+            jsenginepool_dispose(_pool);
+        }
+
+        void CheckDisposed()
+        {
+            if (_disposed)
+                throw new ObjectDisposedException("JsEnginePool:" + _pool.Handle);
+        }
+
+        #endregion
+    }
+}
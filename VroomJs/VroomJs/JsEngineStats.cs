@@ -32,6 +32,20 @@ namespace VroomJs
         public int KeepAliveMaxSlots { get; set; }
         public int KeepAliveAllocatedSlots { get; set; }
         public int KeepAliveUsedSlots { get; set; }
+
+        // Native cache of the names missing from CLR types, shared by all the
+        // contexts of the engine: hits are property reads that didn't call
+        // into the CLR at all.
+        public long MemberCacheHits { get; set; }
+        public long MemberCacheMisses { get; set; }
+        public long MemberCacheEntries { get; set; }
+
+        // CLR side cache of what names resolve to on each type.
+        public long MemberKindCacheHits { get; set; }
+        public long MemberKindCacheMisses { get; set; }
+
+        // Arrays handed to V8 in a JsBuffer and still pinned.
+        public int PinnedBuffers { get; set; }
     }
 }
 
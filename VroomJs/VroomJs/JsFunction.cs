@@ -25,6 +25,22 @@ namespace VroomJs {
 			return result;
 		}
 
+		public object Invoke(object[] args, JsResultMode mode) {
+			return _context.Invoke(_funcPtr, _thisPtr, args, mode);
+		}
+
+		public object Invoke(object[] args, JsMarshalPolicy policy, JsResultMode mode = JsResultMode.Full) {
+			return _context.Invoke(_funcPtr, _thisPtr, args, mode, policy);
+		}
+
+		public string InvokeJson(string args) {
+			return _context.InvokeJson(_funcPtr, _thisPtr, args);
+		}
+
+		public object[] InvokeBatch(object[][] argsets) {
+			return _context.InvokeBatch(_funcPtr, _thisPtr, argsets);
+		}
+
 		public object MakeDelegate(Type type, object[] args) {
 			if (type.BaseType != typeof(MulticastDelegate)) {
 				throw new ApplicationException("Not a delegate.");
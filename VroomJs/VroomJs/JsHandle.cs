@@ -0,0 +1,127 @@
+// This file is part of the VroomJs library.
+//
+// Author:
+//     Federico Di Gregorio <fog@initd.org>
+//
+// Copyright (c) 2013 
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+using System;
+
+namespace VroomJs
+{
+	// A JS object left in V8 by JsResultMode.Handle, or a large array or
+	// string left by JsResultMode.Lazy. Convert() does what the call that
+	// returned it would have done with JsResultMode.Full; GetRange() and
+	// Read() convert only a piece of an array or string.
+	public class JsHandle : IDisposable
+	{
+		readonly JsContext _context;
+		readonly IntPtr _handle;
+		readonly int _length;
+
+		public JsHandle(JsContext context, IntPtr ptr) : this(context, ptr, 0)
+		{
+		}
+
+		public JsHandle(JsContext context, IntPtr ptr, int length)
+		{
+			if (context == null)
+				throw new ArgumentNullException("context");
+			if (ptr == IntPtr.Zero)
+				throw new ArgumentException("can't wrap an empty object (ptr is Zero)", "ptr");
+
+			_context = context;
+			_handle = ptr;
+			_length = length;
+		}
+
+		public IntPtr Handle {
+			get { return _handle; }
+		}
+
+		// The length of an array or string when the handle was made, 0 for
+		// other objects.
+		public int Length {
+			get { return _length; }
+		}
+
+		public object Convert()
+		{
+			CheckDisposed();
+			return _context.ConvertHandle(this);
+		}
+
+		// The current length of an array, which scripts may have changed.
+		public int GetArrayLength()
+		{
+			CheckDisposed();
+			return _context.GetHandleArrayLength(this);
+		}
+
+		// Up to count elements of an array from start, as object[] (or int[]
+		// and double[] with JsEngine.PackedArrays).
+		public Array GetRange(int start, int count)
+		{
+			CheckDisposed();
+			return _context.GetHandleRange(this, start, count);
+		}
+
+		// Up to count characters of a string from offset.
+		public string Read(int offset, int count)
+		{
+			CheckDisposed();
+			return _context.ReadHandleString(this, offset, count);
+		}
+
+		void CheckDisposed()
+		{
+			if (_disposed)
+				throw new ObjectDisposedException("JsHandle:" + _handle);
+		}
+
+		#region IDisposable implementation
+
+		bool _disposed;
+
+		public void Dispose()
+		{
+			Dispose(true);
+			GC.SuppressFinalize(this);
+		}
+
+		protected virtual void Dispose(bool disposing)
+		{
+			if (_disposed)
+				return;
+
+			_disposed = true;
+
+			_context.Engine.DisposeObject(_handle);
+		}
+
+		~JsHandle()
+		{
+			Dispose(false);
+		}
+
+		#endregion
+	}
+}
@@ -0,0 +1,62 @@
+// This file is part of the VroomJs library.
+//
+// Author:
+//     Federico Di Gregorio <fog@initd.org>
+//
+// Copyright (c) 2013 
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+using System;
+using System.Runtime.InteropServices;
+
+namespace VroomJs
+{
+	// Switches of a JsMarshalPolicy, the same as the JsEngine properties of
+	// the same name.
+	[Flags]
+	public enum JsMarshalFlags
+	{
+		None = 0,
+		CompactStrings = 1,
+		PackedArrays = 2,
+		FlatResults = 4,
+		ColumnarResults = 8,
+		SharedObjects = 16
+	}
+
+	// How results are converted from V8 for one context (JsContext.Policy)
+	// or one call, instead of the engine-wide defaults. Limits are 0 for
+	// none; going past any of them throws a JsException.
+	[StructLayout(LayoutKind.Sequential)]
+	public struct JsMarshalPolicy
+	{
+		public JsObjectMarshalType MarshalType;
+		public JsMarshalFlags Flags;
+		public int MaxDepth;
+		public int MaxNodes;
+		// In characters, for string values.
+		public int MaxStringLength;
+
+		// The current engine-wide defaults, a starting point to change.
+		public static JsMarshalPolicy Default {
+			get { return JsEngine.DefaultPolicy; }
+		}
+	}
+}
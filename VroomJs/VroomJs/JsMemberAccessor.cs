@@ -0,0 +1,139 @@
+// This file is part of the VroomJs library.
+//
+// Author:
+//     Federico Di Gregorio <fog@initd.org>
+//
+// Copyright (c) 2013 
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+using System;
+using System.Linq.Expressions;
+using System.Reflection;
+
+namespace VroomJs
+{
+    // Getter and setter of a property or a field, compiled once so that JS
+    // reads and writes don't go through reflection every time. Whatever the
+    // compiled code can't do as reflection would (conversions between
+    // primitive types, nulls for value types, fields of structs) still goes
+    // through reflection.
+    class JsMemberAccessor
+    {
+        readonly PropertyInfo _property;
+        readonly FieldInfo _field;
+        readonly Type _memberType;
+        readonly bool _isStatic;
+
+        readonly Func<object, object> _get;
+        readonly Action<object, object> _set;
+
+        public JsMemberAccessor(MemberInfo member)
+        {
+            _property = member as PropertyInfo;
+            _field = member as FieldInfo;
+            if (_property == null && _field == null)
+                throw new ArgumentException("not a property or a field: " + member.Name, "member");
+
+            if (_property != null) {
+                _memberType = _property.PropertyType;
+                MethodInfo accessor = _property.GetGetMethod() ?? _property.GetSetMethod();
+                _isStatic = accessor != null && accessor.IsStatic;
+            } else {
+                _memberType = _field.FieldType;
+                _isStatic = _field.IsStatic;
+            }
+
+            if (CanCompile(member)) {
+                _get = CompileGetter();
+                _set = CompileSetter();
+            }
+        }
+
+        public object Get(object obj)
+        {
+            if (_get != null)
+                return _get(obj);
+            if (_property != null)
+                return _property.GetValue(obj, null);
+            return _field.GetValue(obj);
+        }
+
+        public void Set(object obj, object value)
+        {
+            if (_set != null && (value == null ? !_memberType.IsValueType : _memberType.IsInstanceOfType(value))) {
+                _set(obj, value);
+                return;
+            }
+            if (_property != null)
+                _property.SetValue(obj, value, null);
+            else
+                _field.SetValue(obj, value);
+        }
+
+        bool CanCompile(MemberInfo member)
+        {
+            // Assigning through an unboxed struct would lose the write, and
+            // compiled code can't reach into types it can't see.
+            Type declaringType = member.DeclaringType;
+            if (declaringType.IsValueType || !declaringType.IsVisible || !_memberType.IsVisible)
+                return false;
+            return _property == null || _property.GetIndexParameters().Length == 0;
+        }
+
+        Func<object, object> CompileGetter()
+        {
+            if (_property != null && _property.GetGetMethod() == null)
+                return null;
+
+            ParameterExpression obj = Expression.Parameter(typeof(object), "obj");
+            Expression instance = _isStatic ? null : Expression.Convert(obj, (_property ?? (MemberInfo)_field).DeclaringType);
+            Expression member = _property != null
+                ? Expression.Property(instance, _property)
+                : Expression.Field(instance, _field);
+            return Expression.Lambda<Func<object, object>>(Expression.Convert(member, typeof(object)), obj).Compile();
+        }
+
+        Action<object, object> CompileSetter()
+        {
+            ParameterExpression obj = Expression.Parameter(typeof(object), "obj");
+            ParameterExpression value = Expression.Parameter(typeof(object), "value");
+
+            if (_property != null) {
+                MethodInfo setter = _property.GetSetMethod();
+                if (setter == null)
+                    return null;
+                Expression instance = _isStatic ? null : Expression.Convert(obj, _property.DeclaringType);
+                Expression call = Expression.Call(instance, setter, Expression.Convert(value, _memberType));
+                return Expression.Lambda<Action<object, object>>(call, obj, value).Compile();
+            }
+
+#if NET40
+            if (_field.IsInitOnly || _field.IsLiteral)
+                return null;
+            Expression target = _isStatic ? null : Expression.Convert(obj, _field.DeclaringType);
+            Expression assign = Expression.Assign(Expression.Field(target, _field), Expression.Convert(value, _memberType));
+            return Expression.Lambda<Action<object, object>>(assign, obj, value).Compile();
+#else
+            // No assignments in 3.5 expression trees: fields are set by reflection.
+            return null;
+#endif
+        }
+    }
+}
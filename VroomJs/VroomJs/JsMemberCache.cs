@@ -0,0 +1,127 @@
+// This file is part of the VroomJs library.
+//
+// Author:
+//     Federico Di Gregorio <fog@initd.org>
+//
+// Copyright (c) 2013 
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+using System;
+using System.Collections.Generic;
+using System.Linq;
+using System.Reflection;
+
+namespace VroomJs
+{
+    // What a name resolves to on a CLR type when read from JS: a property, a
+    // field, a method (any overload, resolved at invocation) or nothing. The
+    // reflection walk is done once per type and name.
+    class JsMemberCache
+    {
+        readonly Dictionary<Type, Dictionary<string, MemberInfo>> _instance = new Dictionary<Type, Dictionary<string, MemberInfo>>();
+        readonly Dictionary<Type, Dictionary<string, MemberInfo>> _static = new Dictionary<Type, Dictionary<string, MemberInfo>>();
+
+        // Compiled accessors and invokers, see JsMemberAccessor and JsMethodInvoker.
+        readonly Dictionary<MemberInfo, JsMemberAccessor> _accessors = new Dictionary<MemberInfo, JsMemberAccessor>();
+        readonly Dictionary<InvokerKey, JsMethodInvoker> _invokers = new Dictionary<InvokerKey, JsMethodInvoker>();
+
+        public long Hits { get; private set; }
+        public long Misses { get; private set; }
+
+        // Null if the type has no public member with that name.
+        public MemberInfo Resolve(Type type, string name, bool isStatic)
+        {
+            var cache = isStatic ? _static : _instance;
+
+            Dictionary<string, MemberInfo> members;
+            if (!cache.TryGetValue(type, out members)) {
+                members = new Dictionary<string, MemberInfo>();
+                cache.Add(type, members);
+            }
+
+            MemberInfo member;
+            if (members.TryGetValue(name, out member)) {
+                Hits++;
+                return member;
+            }
+            Misses++;
+
+            BindingFlags flags = BindingFlags.Public | (isStatic ? BindingFlags.Static : BindingFlags.Instance);
+            member = type.GetProperty(name, flags | BindingFlags.GetProperty);
+            if (member == null)
+                member = type.GetField(name, flags | BindingFlags.GetProperty);
+            if (member == null)
+                member = type.GetMethods(flags | BindingFlags.InvokeMethod | BindingFlags.FlattenHierarchy).FirstOrDefault(x => x.Name == name);
+            members.Add(name, member);
+            return member;
+        }
+
+        // Property or field.
+        public JsMemberAccessor GetAccessor(MemberInfo member)
+        {
+            JsMemberAccessor accessor;
+            if (!_accessors.TryGetValue(member, out accessor)) {
+                accessor = new JsMemberAccessor(member);
+                _accessors.Add(member, accessor);
+            }
+            return accessor;
+        }
+
+        public JsMethodInvoker GetInvoker(Type type, string name, BindingFlags flags)
+        {
+            InvokerKey key = new InvokerKey(type, name, flags);
+            JsMethodInvoker invoker;
+            if (!_invokers.TryGetValue(key, out invoker)) {
+                invoker = new JsMethodInvoker(type, name, flags);
+                _invokers.Add(key, invoker);
+            }
+            return invoker;
+        }
+
+        struct InvokerKey : IEquatable<InvokerKey>
+        {
+            readonly Type _type;
+            readonly string _name;
+            readonly BindingFlags _flags;
+
+            public InvokerKey(Type type, string name, BindingFlags flags)
+            {
+                _type = type;
+                _name = name;
+                _flags = flags;
+            }
+
+            public bool Equals(InvokerKey other)
+            {
+                return _type == other._type && _name == other._name && _flags == other._flags;
+            }
+
+            public override bool Equals(object obj)
+            {
+                return obj is InvokerKey && Equals((InvokerKey)obj);
+            }
+
+            public override int GetHashCode()
+            {
+                return (_type.GetHashCode() * 31 + _name.GetHashCode()) * 31 + (int)_flags;
+            }
+        }
+    }
+}
@@ -0,0 +1,107 @@
+// This file is part of the VroomJs library.
+//
+// Author:
+//     Federico Di Gregorio <fog@initd.org>
+//
+// Copyright (c) 2013 
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+using System;
+using System.Linq;
+using System.Linq.Expressions;
+using System.Reflection;
+
+namespace VroomJs
+{
+    // Calls a method by name from JS. When the name isn't overloaded and the
+    // arguments already have the parameter types the call goes through a
+    // compiled delegate, else through Type.InvokeMember() so that its binder
+    // can pick the overload and convert the arguments.
+    class JsMethodInvoker
+    {
+        readonly Type _type;
+        readonly string _name;
+        readonly BindingFlags _flags;
+
+        readonly Type[] _parameters;
+        readonly Func<object, object[], object> _invoke;
+
+        public JsMethodInvoker(Type type, string name, BindingFlags flags)
+        {
+            _type = type;
+            _name = name;
+            _flags = flags;
+
+            MethodInfo[] methods = type.GetMethods(flags).Where(x => x.Name == name).ToArray();
+            if (methods.Length == 1 && CanCompile(methods[0])) {
+                _parameters = methods[0].GetParameters().Select(x => x.ParameterType).ToArray();
+                _invoke = Compile(methods[0]);
+            }
+        }
+
+        public object Invoke(object target, object[] args)
+        {
+            if (_invoke != null && Matches(args))
+                return _invoke(target, args);
+            return _type.InvokeMember(_name, _flags, null, target, args);
+        }
+
+        bool Matches(object[] args)
+        {
+            if (args.Length != _parameters.Length)
+                return false;
+            for (int i = 0; i < args.Length; i++) {
+                if (args[i] == null ? _parameters[i].IsValueType : !_parameters[i].IsInstanceOfType(args[i]))
+                    return false;
+            }
+            return true;
+        }
+
+        static bool CanCompile(MethodInfo method)
+        {
+            // Methods of structs would run on an unboxed copy.
+            if (!method.IsPublic || method.IsGenericMethodDefinition
+                || !method.DeclaringType.IsVisible || !method.ReturnType.IsVisible)
+                return false;
+            if (!method.IsStatic && method.DeclaringType.IsValueType)
+                return false;
+            return method.GetParameters().All(x => !x.ParameterType.IsByRef && x.ParameterType.IsVisible
+                && !x.IsDefined(typeof(ParamArrayAttribute), false));
+        }
+
+        static Func<object, object[], object> Compile(MethodInfo method)
+        {
+            ParameterExpression target = Expression.Parameter(typeof(object), "target");
+            ParameterExpression args = Expression.Parameter(typeof(object[]), "args");
+
+            Expression instance = method.IsStatic ? null : Expression.Convert(target, method.DeclaringType);
+            Expression call = Expression.Call(instance, method, method.GetParameters().Select((x, i) =>
+                (Expression)Expression.Convert(Expression.ArrayIndex(args, Expression.Constant(i)), x.ParameterType)));
+
+            if (method.ReturnType == typeof(void)) {
+                Action<object, object[]> action = Expression.Lambda<Action<object, object[]>>(call, target, args).Compile();
+                return (t, a) => { action(t, a); return null; };
+            }
+
+            return Expression.Lambda<Func<object, object[], object>>(
+                Expression.Convert(call, typeof(object)), target, args).Compile();
+        }
+    }
+}
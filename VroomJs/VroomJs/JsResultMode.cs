@@ -0,0 +1,45 @@
+// This file is part of the VroomJs library.
+//
+// Author:
+//     Federico Di Gregorio <fog@initd.org>
+//
+// Copyright (c) 2013 
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+namespace VroomJs
+{
+	// How much of the result of a script or call to convert, see
+	// JsContext.Execute and JsFunction.Invoke.
+	public enum JsResultMode
+	{
+		// Everything, as usual.
+		Full = 0,
+		// Nothing: null, for scripts run for their side effects. Errors are
+		// still thrown.
+		Discard = 1,
+		// Primitives (and dates) only, objects come back as null.
+		Primitives = 2,
+		// Objects as a JsHandle, converted if and when asked.
+		Handle = 3,
+		// Arrays and strings of 64K elements or characters and more as a
+		// JsHandle, to be read a range at a time; everything else in full.
+		Lazy = 4
+	}
+}
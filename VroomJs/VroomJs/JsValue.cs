@@ -36,6 +36,11 @@ namespace VroomJs
         [FieldOffset(0)] public double Num;
         [FieldOffset(0)] public IntPtr Ptr;
 
+        // Managed objects: the id of their registered type in I32 (see
+        // JsEngine.RegisterType) and the key of their CLR type for the native
+        // member cache here, 0 for types whose members can change.
+        [FieldOffset(4)] public int TypeKey;
+
         // See JsValueType, marshaled as integer.
         [FieldOffset(8)] public JsValueType Type;
 
@@ -51,6 +56,10 @@ namespace VroomJs
     		get { return new JsValue() { Type = JsValueType.Empty }; }
     	}
 
+        public static JsValue NotFound {
+            get { return new JsValue() { Type = JsValueType.NotFound }; }
+        }
+
         public static JsValue Error(int slot)
         {
             return new JsValue { Type = JsValueType.ManagedError, Index = slot };
@@ -46,6 +46,24 @@ namespace VroomJs
         Wrapped = 14,
         Dictionary = 15,
 		Error = 16,
-		Function = 17
+		Function = 17,
+		ExternalString = 18,
+		AsciiString = 19,
+		NotFound = 20,
+		Int8Buffer = 21,
+		UInt8Buffer = 22,
+		Int16Buffer = 23,
+		UInt16Buffer = 24,
+		Int32Buffer = 25,
+		UInt32Buffer = 26,
+		FloatBuffer = 27,
+		DoubleBuffer = 28,
+		Int32Array = 29,
+		DoubleArray = 30,
+		Flat = 31,
+		Json = 32,
+		Columns = 33,
+		Reference = 34,
+		Handle = 35
     }
 }
\ No newline at end of file
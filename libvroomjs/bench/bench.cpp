@@ -0,0 +1,1175 @@
+// This file is part of the VroomJs library.
+//
+// Author:
+//     Federico Di Gregorio <fog@initd.org>
+//
+// Copyright © 2013 Federico Di Gregorio <fog@initd.org>
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+// Standalone microbenchmarks for the bridge entry points. This program links
+// against libVroomJsNative and plays the part of the CLR: the keepalive_*
+// delegates below are plain C functions returning canned values, so what gets
+// measured is only the native side (locking, scopes, conversions and the
+// allocations made for the jsvalue trees).
+//
+// Usage: vroomjs_bench [iterations] [filter]
+//
+// Only benchmarks whose "entry/shape" name contains filter are run. Every
+// timed operation includes the jsvalue_dispose of its result because the CLR
+// side always pays for it too.
+
+#include <stdio.h>
+#include <string.h>
+#include <algorithm>
+#include <chrono>
+#include <functional>
+#include <string>
+#include <vector>
+
+#include "../vroomjs.h"
+
+extern "C"
+{
+	EXPORT void CALLINGCONVENTION js_set_object_marshal_type(int32_t type);
+	EXPORT void CALLINGCONVENTION js_set_compact_strings(int32_t enabled);
+	EXPORT void CALLINGCONVENTION js_set_packed_arrays(int32_t enabled);
+	EXPORT void CALLINGCONVENTION js_set_flat_results(int32_t enabled);
+	EXPORT void CALLINGCONVENTION js_set_columnar_results(int32_t enabled);
+	EXPORT void CALLINGCONVENTION js_set_shared_objects(int32_t enabled);
+	EXPORT void CALLINGCONVENTION js_set_conversion_limits(int32_t max_depth, int32_t max_nodes);
+	EXPORT JsEngine* CALLINGCONVENTION jsengine_new(keepalive_remove_f keepalive_remove,
+                           keepalive_get_property_value_f keepalive_get_property_value,
+                           keepalive_set_property_value_f keepalive_set_property_value,
+						   keepalive_valueof_f keepalive_valueof,
+                           keepalive_invoke_f keepalive_invoke,
+						   keepalive_delete_property_f keepalive_delete_property,
+						   keepalive_enumerate_properties_f keepalive_enumerate_properties,
+						   int32_t max_young_space, int32_t max_old_space);
+	EXPORT void CALLINGCONVENTION jsengine_dispose(JsEngine* engine);
+	EXPORT void CALLINGCONVENTION jsengine_set_script_cache_budget(JsEngine* engine, int64_t budget);
+	EXPORT void CALLINGCONVENTION jsengine_set_precompile_cache(JsEngine* engine, const uint16_t* directory);
+	EXPORT int32_t CALLINGCONVENTION jsengine_intern_name(JsEngine* engine, const uint16_t* name);
+	EXPORT void CALLINGCONVENTION jsengine_set_member_delegates(JsEngine* engine,
+						   keepalive_get_member_f keepalive_get_member,
+						   keepalive_set_member_f keepalive_set_member,
+						   keepalive_invoke_member_f keepalive_invoke_member);
+	EXPORT void CALLINGCONVENTION jsengine_set_indexed_delegate(JsEngine* engine, keepalive_indexed_f keepalive_indexed);
+	EXPORT void CALLINGCONVENTION jsengine_set_buffer_delegate(JsEngine* engine, keepalive_release_buffer_f keepalive_release_buffer);
+	EXPORT int32_t CALLINGCONVENTION jsengine_register_type(JsEngine* engine, const uint16_t** names, const int32_t* kinds, int32_t count);
+	EXPORT JsEnginePool* CALLINGCONVENTION jsenginepool_new(int32_t min_size, int32_t max_size, 
+						   int32_t max_young_space, int32_t max_old_space);
+	EXPORT JsEngine* CALLINGCONVENTION jsenginepool_acquire(JsEnginePool* pool,
+                           keepalive_remove_f keepalive_remove, 
+                           keepalive_get_property_value_f keepalive_get_property_value,
+                           keepalive_set_property_value_f keepalive_set_property_value,
+						   keepalive_valueof_f keepalive_valueof,
+                           keepalive_invoke_f keepalive_invoke,
+						   keepalive_delete_property_f keepalive_delete_property,
+						   keepalive_enumerate_properties_f keepalive_enumerate_properties);
+	EXPORT void CALLINGCONVENTION jsenginepool_release(JsEnginePool* pool, JsEngine* engine);
+	EXPORT void CALLINGCONVENTION jsenginepool_get_stats(JsEnginePool* pool, jsenginepool_stats* stats);
+	EXPORT void CALLINGCONVENTION jsenginepool_dispose(JsEnginePool* pool);
+	EXPORT void CALLINGCONVENTION jsengine_dispose_object(JsEngine* engine, Persistent<Object>* obj);
+	EXPORT JsContext* CALLINGCONVENTION jscontext_new(int32_t id, JsEngine *engine);
+	EXPORT void jscontext_dispose(JsContext* context);
+	EXPORT int32_t CALLINGCONVENTION jscontext_reset(JsContext* context);
+	EXPORT void CALLINGCONVENTION jscontext_session_begin(JsContext* context);
+	EXPORT int32_t CALLINGCONVENTION jscontext_session_end(JsContext* context);
+	EXPORT jsvalue CALLINGCONVENTION jscontext_execute(JsContext* context, const uint16_t* str, const uint16_t *resourceName);
+	EXPORT jsvalue CALLINGCONVENTION jscontext_execute_script(JsContext* context, JsScript *script);
+	EXPORT jsvalue CALLINGCONVENTION jscontext_execute_mode(JsContext* context, const uint16_t* str, const uint16_t *resourceName, int32_t mode);
+	EXPORT void CALLINGCONVENTION jscontext_set_policy(JsContext* context, const jspolicy *policy);
+	EXPORT jsvalue CALLINGCONVENTION jscontext_execute_policy(JsContext* context, const uint16_t* str, const uint16_t *resourceName, int32_t mode, const jspolicy *policy);
+	EXPORT jsvalue CALLINGCONVENTION jscontext_convert(JsContext* context, Persistent<Object>* obj);
+	EXPORT jsvalue CALLINGCONVENTION jscontext_array_get_range(JsContext* context, Persistent<Object>* obj, int32_t start, int32_t count);
+	EXPORT jsvalue CALLINGCONVENTION jscontext_string_read(JsContext* context, Persistent<Object>* obj, int32_t offset, int32_t count);
+	EXPORT jsvalue CALLINGCONVENTION jscontext_execute_columns(JsContext* context, const uint16_t* str, const uint16_t *resourceName, const uint16_t** names, int32_t count);
+	EXPORT jsvalue CALLINGCONVENTION jscontext_set_variable(JsContext* context, const uint16_t* name, jsvalue value);
+	EXPORT jsvalue CALLINGCONVENTION jscontext_get_variable(JsContext* context, const uint16_t* name);
+	EXPORT jsvalue CALLINGCONVENTION jscontext_get_json(JsContext* context, const uint16_t* name);
+	EXPORT jsvalue CALLINGCONVENTION jscontext_set_json(JsContext* context, const uint16_t* name, const char* json, int32_t length);
+	EXPORT jsvalue CALLINGCONVENTION jscontext_invoke_json(JsContext* context, Persistent<Function>* funcArg, Persistent<Object>* thisArg, const char* args, int32_t length);
+	EXPORT jsvalue CALLINGCONVENTION jscontext_get_property_value(JsContext* context, Persistent<Object>* obj, const uint16_t* name);
+	EXPORT jsvalue CALLINGCONVENTION jscontext_set_property_value(JsContext* context, Persistent<Object>* obj, const uint16_t* name, jsvalue value);
+	EXPORT jsvalue CALLINGCONVENTION jscontext_get_property_values(JsContext* context, Persistent<Object>* obj, const uint16_t** names, int32_t count);
+	EXPORT jsvalue CALLINGCONVENTION jscontext_set_property_values(JsContext* context, Persistent<Object>* obj, const uint16_t** names, int32_t count, jsvalue values);
+	EXPORT jsvalue CALLINGCONVENTION jscontext_get_property_value_atom(JsContext* context, Persistent<Object>* obj, int32_t atom);
+	EXPORT jsvalue CALLINGCONVENTION jscontext_set_property_value_atom(JsContext* context, Persistent<Object>* obj, int32_t atom, jsvalue value);
+	EXPORT jsvalue CALLINGCONVENTION jscontext_get_property_values_atoms(JsContext* context, Persistent<Object>* obj, const int32_t* atoms, int32_t count);
+	EXPORT jsvalue CALLINGCONVENTION jscontext_invoke(JsContext* context, Persistent<Function>* funcArg, Persistent<Object>* thisArg, jsvalue args);
+	EXPORT jsvalue CALLINGCONVENTION jscontext_invoke_batch(JsContext* context, Persistent<Function>* funcArg, Persistent<Object>* thisArg, jsvalue argsets);
+	EXPORT JsScript* CALLINGCONVENTION jsscript_new(JsEngine *engine);
+	EXPORT void CALLINGCONVENTION jsscript_dispose(JsScript *script);
+	EXPORT jsvalue CALLINGCONVENTION jsscript_compile(JsScript* script, const uint16_t* str, const uint16_t *resourceName);
+	EXPORT jsvalue CALLINGCONVENTION jsvalue_alloc_string(const uint16_t* str);
+	EXPORT jsvalue CALLINGCONVENTION jsvalue_alloc_array(const int32_t length);
+}
+
+static const int LongStringLength = 64 * 1024;
+static const int ArrayLength = 10000;
+
+typedef std::basic_string<uint16_t> ustring;
+
+static ustring U(const char* s)
+{
+	ustring r;
+	while (*s != '\0')
+		r.push_back((uint16_t)*s++);
+	return r;
+}
+
+static ustring U(const std::string& s)
+{
+	return U(s.c_str());
+}
+
+static jsvalue MakeNull()
+{
+	jsvalue v;
+	v.type = JSVALUE_TYPE_NULL;
+	v.length = 0;
+	v.value.i64 = 0;
+	return v;
+}
+
+static jsvalue MakeInteger(int32_t i)
+{
+	jsvalue v;
+	v.type = JSVALUE_TYPE_INTEGER;
+	v.length = 0;
+	v.value.i64 = 0;
+	v.value.i32 = i;
+	return v;
+}
+
+// Payloads, built once, in both their JS source and jsvalue form.
+
+static std::string long_string_;
+static ustring long_string16_;
+
+static std::string JsLongString()
+{
+	return "'" + long_string_ + "'";
+}
+
+static const char* JsArray()
+{
+	return "(function () { var a = new Array(10000); for (var i = 0; i < a.length; i++) a[i] = i; return a; })()";
+}
+
+static const char* JsNestedDict()
+{
+	return "(function () {"
+		"  var rows = [];"
+		"  for (var i = 0; i < 100; i++)"
+		"    rows.push({ id: i, name: 'row' + i, tags: ['a', 'b'], child: { x: i, y: { z: 'leaf' } } });"
+		"  return { total: rows.length, rows: rows };"
+		"})()";
+}
+
+// The typical interop result: an array of objects with string fields.
+static const char* JsRecords()
+{
+	return "(function () {"
+		"  var rows = [];"
+		"  for (var i = 0; i < 1000; i++)"
+		"    rows.push({ id: 'id' + i, name: 'name' + i, email: 'user' + i + '@example.com', city: 'city' + (i % 50) });"
+		"  return rows;"
+		"})()";
+}
+
+// Many rows with a mix of number and string fields.
+static const char* JsRecords100k()
+{
+	return "(function () {"
+		"  var rows = [];"
+		"  for (var i = 0; i < 100000; i++)"
+		"    rows.push({ id: i, score: i / 7, name: 'name' + i, city: 'city' + (i % 50) });"
+		"  return rows;"
+		"})()";
+}
+
+// A denormalized config: 1000 entries pointing at a few shared objects, each
+// of them pointing back at the root.
+static const char* JsSharedGraph()
+{
+	return "(function () {"
+		"  var root = { entries: [] };"
+		"  var shared = [];"
+		"  for (var i = 0; i < 20; i++)"
+		"    shared.push({ name: 'profile' + i, root: root, limits: { cpu: i, memory: i * 1024, tags: ['a', 'b', 'c'] } });"
+		"  for (var i = 0; i < 1000; i++)"
+		"    root.entries.push({ id: i, profile: shared[i % 20], fallback: shared[(i + 1) % 20] });"
+		"  return root;"
+		"})()";
+}
+
+static jsvalue AllocPayload(const char* shape)
+{
+	if (strcmp(shape, "string") == 0)
+		return jsvalue_alloc_string(long_string16_.c_str());
+	if (strcmp(shape, "array") == 0) {
+		jsvalue v = jsvalue_alloc_array(ArrayLength);
+		for (int i = 0; i < ArrayLength; i++)
+			v.value.arr[i] = MakeInteger(i);
+		return v;
+	}
+	return MakeInteger(42);
+}
+
+// Stub CLR side. Managed object ids are meaningless here: every property
+// read answers with the current callback payload and every call with 42.
+
+static jsvalue callback_payload_;
+
+static void CALLINGCONVENTION stub_remove(int, int)
+{
+}
+
+static jsvalue CALLINGCONVENTION stub_get_property_value(int, int, uint16_t*)
+{
+	// The native side disposes what we return, so hand out a fresh copy.
+	if (callback_payload_.type == JSVALUE_TYPE_STRING)
+		return jsvalue_alloc_string(callback_payload_.value.str);
+	return callback_payload_;
+}
+
+static jsvalue CALLINGCONVENTION stub_set_property_value(int, int, uint16_t*, jsvalue)
+{
+	return MakeNull();
+}
+
+static jsvalue CALLINGCONVENTION stub_valueof(int, int)
+{
+	return MakeInteger(42);
+}
+
+static jsvalue CALLINGCONVENTION stub_invoke(int, int, jsvalue)
+{
+	return MakeInteger(42);
+}
+
+static jsvalue CALLINGCONVENTION stub_delete_property(int, int, uint16_t*)
+{
+	jsvalue v;
+	v.type = JSVALUE_TYPE_BOOLEAN;
+	v.length = 0;
+	v.value.i64 = 0;
+	return v;
+}
+
+static jsvalue CALLINGCONVENTION stub_enumerate_properties(int, int)
+{
+	return jsvalue_alloc_array(0);
+}
+
+static jsvalue CALLINGCONVENTION stub_get_member(int, int, int32_t)
+{
+	return stub_get_property_value(0, 0, NULL);
+}
+
+static jsvalue CALLINGCONVENTION stub_set_member(int, int, int32_t, jsvalue)
+{
+	return MakeNull();
+}
+
+static jsvalue CALLINGCONVENTION stub_invoke_member(int, int, int32_t, jsvalue)
+{
+	return MakeInteger(42);
+}
+
+// Every managed object looks like a list of StubListLength integers.
+static const int StubListLength = 1000;
+
+static jsvalue CALLINGCONVENTION stub_indexed(int, int, int32_t op, uint32_t index, jsvalue)
+{
+	if (op == JSINDEXED_LENGTH)
+		return MakeInteger(StubListLength);
+	if (op == JSINDEXED_SET)
+		return MakeNull();
+	if (index >= (uint32_t)StubListLength) {
+		jsvalue v;
+		v.type = JSVALUE_TYPE_EMPTY;
+		return v;
+	}
+	return MakeInteger((int32_t)index);
+}
+
+// Timing.
+
+static void CALLINGCONVENTION stub_release_buffer(int, void*)
+{
+}
+
+static int iterations_ = 2000;
+static const char* filter_ = NULL;
+
+static double Percentile(std::vector<double>& sorted, double p)
+{
+	size_t i = (size_t)(p * (sorted.size() - 1));
+	return sorted[i];
+}
+
+static void Run(const char* entry, const char* shape, std::function<void()> op, int iterations = -1)
+{
+	std::string name = std::string(entry) + "/" + shape;
+	if (filter_ != NULL && name.find(filter_) == std::string::npos)
+		return;
+
+	if (iterations < 0)
+		iterations = iterations_;
+	iterations = std::max(1, iterations);
+
+	// Warm up: let V8 optimize and the allocator settle.
+	int warmup = std::max(1, iterations / 10);
+	for (int i = 0; i < warmup; i++)
+		op();
+
+	std::vector<double> samples(iterations);
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	for (int i = 0; i < iterations; i++) {
+		std::chrono::steady_clock::time_point t0 = std::chrono::steady_clock::now();
+		op();
+		std::chrono::steady_clock::time_point t1 = std::chrono::steady_clock::now();
+		samples[i] = std::chrono::duration<double, std::micro>(t1 - t0).count();
+	}
+	double total = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+	std::sort(samples.begin(), samples.end());
+	printf("%-44s %12.0f %12.2f %12.2f\n", name.c_str(),
+		iterations / total, Percentile(samples, 0.50), Percentile(samples, 0.99));
+	fflush(stdout);
+}
+
+// Helpers to reach V8 objects the same way the CLR does: by executing code in
+// DYNAMIC mode and keeping the returned Persistent<Object>* around.
+
+static Persistent<Object>* Wrapped(JsContext* context, const char* code)
+{
+	js_set_object_marshal_type(JSOBJECT_MARSHAL_TYPE_DYNAMIC);
+	jsvalue v = jscontext_execute(context, U(code).c_str(), U("<bench>").c_str());
+	js_set_object_marshal_type(JSOBJECT_MARSHAL_TYPE_DICTIONARY);
+	if (v.type != JSVALUE_TYPE_WRAPPED) {
+		fprintf(stderr, "expected an object from: %s\n", code);
+		exit(1);
+	}
+	return (Persistent<Object>*)v.value.ptr;
+}
+
+static jsvalue Callable(JsContext* context, const char* code)
+{
+	jsvalue v = jscontext_execute(context, U(code).c_str(), U("<bench>").c_str());
+	if (v.type != JSVALUE_TYPE_FUNCTION) {
+		fprintf(stderr, "expected a function from: %s\n", code);
+		exit(1);
+	}
+	return v;
+}
+
+// The first three shapes can also be built on the CLR side (there is no CLR to
+// JS conversion for dictionaries: they are sent as managed objects).
+static const char* shapes_[] = { "primitive", "string", "array", "dict", "records" };
+static const int ShapeCount = 5;
+static const int ClrShapeCount = 3;
+
+static std::string ShapeSource(const char* shape)
+{
+	if (strcmp(shape, "string") == 0)
+		return JsLongString();
+	if (strcmp(shape, "array") == 0)
+		return JsArray();
+	if (strcmp(shape, "dict") == 0)
+		return JsNestedDict();
+	if (strcmp(shape, "records") == 0)
+		return JsRecords();
+	return "42";
+}
+
+static void BenchExecute(JsEngine* engine, JsContext* context)
+{
+	for (int s = 0; s < ShapeCount; s++) {
+		const char* shape = shapes_[s];
+		ustring code = U(ShapeSource(shape));
+		ustring name = U("<bench>");
+		Run("jscontext_execute", shape, [&]() {
+			jsvalue_dispose(jscontext_execute(context, code.c_str(), name.c_str()));
+		});
+	}
+
+	// Tree-shaped results as a single flat block.
+	js_set_flat_results(1);
+	for (int s = 0; s < ShapeCount; s++) {
+		const char* shape = shapes_[s];
+		ustring code = U(ShapeSource(shape));
+		ustring name = U("<bench>");
+		Run("jscontext_execute_flat", shape, [&]() {
+			jsvalue_dispose(jscontext_execute(context, code.c_str(), name.c_str()));
+		});
+	}
+	js_set_flat_results(0);
+
+	// Same, parsing every time.
+	jsengine_set_script_cache_budget(engine, 0);
+	for (int s = 0; s < ShapeCount; s++) {
+		const char* shape = shapes_[s];
+		ustring code = U(ShapeSource(shape));
+		ustring name = U("<bench>");
+		Run("jscontext_execute_uncached", shape, [&]() {
+			jsvalue_dispose(jscontext_execute(context, code.c_str(), name.c_str()));
+		});
+	}
+	jsengine_set_script_cache_budget(engine, JS_SCRIPT_CACHE_DEFAULT_BUDGET);
+
+	for (int s = 0; s < ShapeCount; s++) {
+		const char* shape = shapes_[s];
+		JsScript* script = jsscript_new(engine);
+		jsvalue_dispose(jsscript_compile(script, U(ShapeSource(shape)).c_str(), U("<bench>").c_str()));
+		Run("jscontext_execute_script", shape, [&]() {
+			jsvalue_dispose(jscontext_execute_script(context, script));
+		});
+		jsscript_dispose(script);
+	}
+
+	// Results converted as much as needed: not at all, only if primitive,
+	// or kept in V8 and converted later.
+	const char* modes[] = { "discard", "primitives", "handle", "handle_convert" };
+	for (int m = 0; m < 4; m++) {
+		for (int s = 0; s < ShapeCount; s++) {
+			const char* shape = shapes_[s];
+			ustring code = U(ShapeSource(shape));
+			ustring name = U("<bench>");
+			std::string entry = std::string("jscontext_execute_") + modes[m];
+			int32_t mode = m == 3 ? JSRESULT_MODE_HANDLE : m + JSRESULT_MODE_DISCARD;
+			Run(entry.c_str(), shape, [&]() {
+				jsvalue v = jscontext_execute_mode(context, code.c_str(), name.c_str(), mode);
+				if (v.type == JSVALUE_TYPE_HANDLE) {
+					Persistent<Object>* handle = (Persistent<Object>*)v.value.ptr;
+					if (m == 3)
+						jsvalue_dispose(jscontext_convert(context, handle));
+					jsengine_dispose_object(engine, handle);
+				}
+				jsvalue_dispose(v);
+			});
+		}
+	}
+}
+
+static void BenchProperties(JsEngine* engine, JsContext* context)
+{
+	std::string code = "({ primitive: 42, string: " + JsLongString() +
+		", array: " + JsArray() + ", dict: " + JsNestedDict() +
+		", records: " + JsRecords() + " })";
+	Persistent<Object>* holder = Wrapped(context, code.c_str());
+
+	for (int s = 0; s < ShapeCount; s++) {
+		const char* shape = shapes_[s];
+		ustring name = U(shape);
+		Run("jscontext_get_property_value", shape, [&]() {
+			jsvalue_dispose(jscontext_get_property_value(context, holder, name.c_str()));
+		});
+	}
+
+	Persistent<Object>* target = Wrapped(context, "({})");
+	for (int s = 0; s < ClrShapeCount; s++) {
+		const char* shape = shapes_[s];
+		ustring name = U(shape);
+		Run("jscontext_set_property_value", shape, [&]() {
+			jsvalue value = AllocPayload(shape);
+			jsvalue_dispose(jscontext_set_property_value(context, target, name.c_str(), value));
+			jsvalue_dispose(value);
+		});
+	}
+
+	// Reading and writing a 16 field record, one call per field or batched.
+	Persistent<Object>* record = Wrapped(context,
+		"({ f0: 0, f1: 1, f2: 2, f3: 3, f4: 'a', f5: 'b', f6: 'c', f7: 'd',"
+		"   f8: 8.5, f9: 9.5, f10: true, f11: false, f12: null, f13: 13, f14: 'e', f15: 15 })");
+	std::vector<ustring> fields(16);
+	std::vector<const uint16_t*> names(16);
+	for (int i = 0; i < 16; i++) {
+		fields[i] = U("f" + std::to_string(i));
+		names[i] = fields[i].c_str();
+	}
+
+	Run("jscontext_get_property_value", "record16", [&]() {
+		for (int i = 0; i < 16; i++)
+			jsvalue_dispose(jscontext_get_property_value(context, record, names[i]));
+	});
+	Run("jscontext_get_property_values", "record16", [&]() {
+		jsvalue_dispose(jscontext_get_property_values(context, record, &names[0], 16));
+	});
+	Run("jscontext_set_property_value", "record16", [&]() {
+		for (int i = 0; i < 16; i++)
+			jsvalue_dispose(jscontext_set_property_value(context, record, names[i], MakeInteger(i)));
+	});
+	Run("jscontext_set_property_values", "record16", [&]() {
+		jsvalue values = jsvalue_alloc_array(16);
+		for (int i = 0; i < 16; i++)
+			values.value.arr[i] = MakeInteger(i);
+		jsvalue_dispose(jscontext_set_property_values(context, record, &names[0], 16, values));
+		jsvalue_dispose(values);
+	});
+
+	// The same fields by interned name.
+	std::vector<int32_t> atoms(16);
+	for (int i = 0; i < 16; i++)
+		atoms[i] = jsengine_intern_name(engine, names[i]);
+
+	Run("jscontext_get_property_value_atom", "record16", [&]() {
+		for (int i = 0; i < 16; i++)
+			jsvalue_dispose(jscontext_get_property_value_atom(context, record, atoms[i]));
+	});
+	Run("jscontext_get_property_values_atoms", "record16", [&]() {
+		jsvalue_dispose(jscontext_get_property_values_atoms(context, record, &atoms[0], 16));
+	});
+	Run("jscontext_set_property_value_atom", "record16", [&]() {
+		for (int i = 0; i < 16; i++)
+			jsvalue_dispose(jscontext_set_property_value_atom(context, record, atoms[i], MakeInteger(i)));
+	});
+
+	jsengine_dispose_object(engine, record);
+	jsengine_dispose_object(engine, target);
+	jsengine_dispose_object(engine, holder);
+}
+
+static void BenchInvoke(JsEngine* engine, JsContext* context)
+{
+	// The identity function measures both directions of the conversion.
+	jsvalue f = Callable(context, "(function (x) { return x; })");
+	Persistent<Function>* func = (Persistent<Function>*)f.value.arr[0].value.ptr;
+
+	for (int s = 0; s < ClrShapeCount; s++) {
+		const char* shape = shapes_[s];
+		Run("jscontext_invoke", shape, [&]() {
+			jsvalue args = jsvalue_alloc_array(1);
+			args.value.arr[0] = AllocPayload(shape);
+			jsvalue_dispose(jscontext_invoke(context, func, NULL, args));
+			jsvalue_dispose(args);
+		});
+	}
+
+	for (int s = ClrShapeCount; s < ShapeCount; s++) {
+		const char* shape = shapes_[s];
+		jsvalue g = Callable(context, ("(function () { return " + ShapeSource(shape) + "; })").c_str());
+		Persistent<Function>* gen = (Persistent<Function>*)g.value.arr[0].value.ptr;
+		Run("jscontext_invoke", shape, [&]() {
+			jsvalue args = jsvalue_alloc_array(0);
+			jsvalue_dispose(jscontext_invoke(context, gen, NULL, args));
+			jsvalue_dispose(args);
+		});
+		jsengine_dispose_object(engine, (Persistent<Object>*)g.value.arr[0].value.ptr);
+		jsvalue_dispose(g);
+	}
+	jsengine_dispose_object(engine, (Persistent<Object>*)f.value.arr[0].value.ptr);
+	jsvalue_dispose(f);
+}
+
+// A hundred small calls in a row, each locking and entering the context or
+// all of them inside one session.
+static void BenchSession(JsEngine* engine, JsContext* context)
+{
+	jsvalue f = Callable(context, "(function (x) { return x + 1; })");
+	Persistent<Function>* func = (Persistent<Function>*)f.value.arr[0].value.ptr;
+
+	for (int session = 0; session < 2; session++) {
+		Run(session ? "jscontext_invoke_session" : "jscontext_invoke", "x100", [&]() {
+			if (session)
+				jscontext_session_begin(context);
+			for (int i = 0; i < 100; i++) {
+				jsvalue args = jsvalue_alloc_array(1);
+				args.value.arr[0] = MakeInteger(i);
+				jsvalue_dispose(jscontext_invoke(context, func, NULL, args));
+				jsvalue_dispose(args);
+			}
+			if (session)
+				jscontext_session_end(context);
+		}, iterations_ / 10);
+	}
+	jsengine_dispose_object(engine, (Persistent<Object>*)f.value.arr[0].value.ptr);
+	jsvalue_dispose(f);
+}
+
+// Plain data read, written and passed through as UTF-8 JSON rather than as
+// DICTIONARY marshaled jsvalue trees.
+static void BenchJson(JsEngine* engine, JsContext* context)
+{
+	jsvalue f = Callable(context, "(function (x) { return x; })");
+	Persistent<Function>* func = (Persistent<Function>*)f.value.arr[0].value.ptr;
+
+	for (int s = 2; s < ShapeCount; s++) { // array, dict and records
+		const char* shape = shapes_[s];
+		ustring name = U(std::string("json_") + shape);
+		jsvalue_dispose(jscontext_execute(context, U("var json_" + std::string(shape) + " = " + ShapeSource(shape)).c_str(), U("<bench>").c_str()));
+
+		Run("jscontext_get_variable", shape, [&]() {
+			jsvalue_dispose(jscontext_get_variable(context, name.c_str()));
+		});
+		Run("jscontext_get_json", shape, [&]() {
+			jsvalue_dispose(jscontext_get_json(context, name.c_str()));
+		});
+
+		jsvalue text = jscontext_get_json(context, name.c_str());
+		if (text.type != JSVALUE_TYPE_JSON) {
+			fprintf(stderr, "expected JSON for: %s\n", shape);
+			exit(1);
+		}
+		std::string json((const char*)text.value.ptr, text.length);
+		std::string args = "[" + json + "]";
+		jsvalue_dispose(text);
+
+		Run("jscontext_set_json", shape, [&]() {
+			jsvalue_dispose(jscontext_set_json(context, name.c_str(), json.c_str(), (int32_t)json.size()));
+		});
+		Run("jscontext_invoke_json", shape, [&]() {
+			jsvalue_dispose(jscontext_invoke_json(context, func, NULL, args.c_str(), (int32_t)args.size()));
+		});
+	}
+	jsengine_dispose_object(engine, (Persistent<Object>*)f.value.arr[0].value.ptr);
+	jsvalue_dispose(f);
+}
+
+// Arrays of records as DICTIONARY trees or by column, with the keys found by
+// looking at the rows or declared by the caller. The size of each result is
+// that of its flat copy (see js_flatten), i.e. all of its allocations.
+static void BenchColumns(JsEngine*, JsContext* context)
+{
+	const char* shapes[] = { "records", "records100k" };
+	const char* fields[][4] = { { "id", "name", "email", "city" }, { "id", "score", "name", "city" } };
+
+	for (int s = 0; s < 2; s++) {
+		const char* shape = shapes[s];
+		ustring code = U(s == 0 ? JsRecords() : JsRecords100k());
+		ustring name = U("<bench>");
+		ustring keys16[4];
+		const uint16_t* keys[4];
+		for (int f = 0; f < 4; f++) {
+			keys16[f] = U(fields[s][f]);
+			keys[f] = keys16[f].c_str();
+		}
+		int iterations = s == 0 ? -1 : std::max(1, iterations_ / 100);
+
+		Run("jscontext_execute", shape, [&]() {
+			jsvalue_dispose(jscontext_execute(context, code.c_str(), name.c_str()));
+		}, iterations);
+		js_set_columnar_results(1);
+		Run("jscontext_execute_columnar", shape, [&]() {
+			jsvalue_dispose(jscontext_execute(context, code.c_str(), name.c_str()));
+		}, iterations);
+		js_set_columnar_results(0);
+		Run("jscontext_execute_columns", shape, [&]() {
+			jsvalue_dispose(jscontext_execute_columns(context, code.c_str(), name.c_str(), keys, 4));
+		}, iterations);
+
+		js_set_flat_results(1);
+		jsvalue dict = jscontext_execute(context, code.c_str(), name.c_str());
+		jsvalue columns = jscontext_execute_columns(context, code.c_str(), name.c_str(), keys, 4);
+		js_set_flat_results(0);
+		printf("%-44s %12d bytes\n", (std::string("result_size/dict/") + shape).c_str(), dict.length);
+		printf("%-44s %12d bytes\n", (std::string("result_size/columns/") + shape).c_str(), columns.length);
+		jsvalue_dispose(dict);
+		jsvalue_dispose(columns);
+	}
+}
+
+// An object graph with shared objects and cycles, with every shared object
+// converted where it's met (cycles only are references) or once.
+static void BenchGraph(JsEngine*, JsContext* context)
+{
+	ustring code = U(JsSharedGraph());
+	ustring name = U("<bench>");
+
+	for (int shared = 0; shared < 2; shared++) {
+		const char* entry = shared ? "jscontext_execute_shared" : "jscontext_execute";
+		js_set_shared_objects(shared);
+		Run(entry, "graph", [&]() {
+			jsvalue_dispose(jscontext_execute(context, code.c_str(), name.c_str()));
+		});
+
+		js_set_flat_results(1);
+		jsvalue v = jscontext_execute(context, code.c_str(), name.c_str());
+		js_set_flat_results(0);
+		printf("%-44s %12d bytes\n", (std::string("result_size/") + (shared ? "shared" : "copies") + "/graph").c_str(), v.length);
+		jsvalue_dispose(v);
+	}
+	js_set_shared_objects(0);
+
+	// Stopped early by a node limit.
+	js_set_conversion_limits(0, 1000);
+	Run("jscontext_execute_limited", "graph", [&]() {
+		jsvalue_dispose(jscontext_execute(context, code.c_str(), name.c_str()));
+	});
+	js_set_conversion_limits(0, 0);
+
+	// The same settings as a policy of the call or of the context instead of
+	// the process-wide defaults.
+	jspolicy policy = { JSOBJECT_MARSHAL_TYPE_DICTIONARY, JSPOLICY_SHARED_OBJECTS, 0, 0, 0 };
+	Run("jscontext_execute_policy", "graph", [&]() {
+		jsvalue_dispose(jscontext_execute_policy(context, code.c_str(), name.c_str(), JSRESULT_MODE_FULL, &policy));
+	});
+	jscontext_set_policy(context, &policy);
+	Run("jscontext_execute_context_policy", "graph", [&]() {
+		jsvalue_dispose(jscontext_execute(context, code.c_str(), name.c_str()));
+	});
+	jscontext_set_policy(context, NULL);
+}
+
+// A 1M-element array and a 16M-character string converted at once or read
+// in 64K pieces through JSRESULT_MODE_LAZY, which is the one to look at for
+// peak memory rather than time.
+static void BenchLazy(JsEngine* engine, JsContext* context)
+{
+	const int32_t chunk = 64 * 1024;
+	const char* shapes[] = { "array1m", "string16m" };
+	const char* sources[] = {
+		"(function() { var a = new Array(1000000); for (var i = 0; i < a.length; i++) a[i] = i * 0.5; return a; })()",
+		"(function() { var s = 'abcdefghijklmnop'; while (s.length < 16 * 1024 * 1024) s += s; return s; })()"
+	};
+	ustring name = U("<bench>");
+
+	for (int s = 0; s < 2; s++) {
+		ustring code = U(sources[s]);
+		Run("jscontext_execute", shapes[s], [&]() {
+			jsvalue_dispose(jscontext_execute(context, code.c_str(), name.c_str()));
+		}, iterations_ / 100);
+		Run("jscontext_execute_lazy", shapes[s], [&]() {
+			jsvalue v = jscontext_execute_mode(context, code.c_str(), name.c_str(), JSRESULT_MODE_LAZY);
+			if (v.type == JSVALUE_TYPE_HANDLE) {
+				Persistent<Object>* handle = (Persistent<Object>*)v.value.ptr;
+				for (int32_t i = 0; i < v.length; i += chunk) {
+					if (s == 0)
+						jsvalue_dispose(jscontext_array_get_range(context, handle, i, chunk));
+					else
+						jsvalue_dispose(jscontext_string_read(context, handle, i, chunk));
+				}
+				jsengine_dispose_object(engine, handle);
+			}
+			jsvalue_dispose(v);
+		}, iterations_ / 100);
+	}
+}
+
+// A feature vector of doubles handed to a scoring function, converted element
+// by element or exposed in place as external array data.
+static void BenchBuffers(JsEngine* engine, JsContext* context)
+{
+	jsvalue f = Callable(context,
+		"(function (v) { var s = 0; for (var i = 0; i < v.length; i++) s += v[i]; return s; })");
+	Persistent<Function>* func = (Persistent<Function>*)f.value.arr[0].value.ptr;
+
+	std::vector<double> features(ArrayLength);
+	for (int i = 0; i < ArrayLength; i++)
+		features[i] = i * 0.5;
+
+	Run("jscontext_invoke", "doubles_array", [&]() {
+		jsvalue args = jsvalue_alloc_array(1);
+		args.value.arr[0] = jsvalue_alloc_array(ArrayLength);
+		for (int i = 0; i < ArrayLength; i++) {
+			args.value.arr[0].value.arr[i].type = JSVALUE_TYPE_NUMBER;
+			args.value.arr[0].value.arr[i].length = 0;
+			args.value.arr[0].value.arr[i].value.num = features[i];
+		}
+		jsvalue_dispose(jscontext_invoke(context, func, NULL, args));
+		jsvalue_dispose(args);
+	});
+
+	Run("jscontext_invoke", "doubles_buffer", [&]() {
+		jsvalue args = jsvalue_alloc_array(1);
+		args.value.arr[0].type = JSVALUE_TYPE_DOUBLE_BUFFER;
+		args.value.arr[0].length = ArrayLength;
+		args.value.arr[0].value.ptr = &features[0];
+		jsvalue_dispose(jscontext_invoke(context, func, NULL, args));
+		jsvalue_dispose(args);
+	});
+
+	// And the other way around, arrays of numbers returned by scripts as
+	// jsvalue trees or packed.
+	const char* results[][2] = {
+		{ "ints", "(function () { var a = new Array(10000); for (var i = 0; i < a.length; i++) a[i] = i; return a; })" },
+		{ "doubles", "(function () { var a = new Array(10000); for (var i = 0; i < a.length; i++) a[i] = i * 0.5; return a; })" }
+	};
+	jsvalue noargs = jsvalue_alloc_array(0);
+	for (int r = 0; r < 2; r++) {
+		jsvalue g = Callable(context, results[r][1]);
+		Persistent<Function>* gen = (Persistent<Function>*)g.value.arr[0].value.ptr;
+		for (int packed = 0; packed < 2; packed++) {
+			js_set_packed_arrays(packed);
+			std::string shape = std::string(results[r][0]) + (packed ? "_packed" : "_array");
+			Run("jscontext_invoke", shape.c_str(), [&]() {
+				jsvalue_dispose(jscontext_invoke(context, gen, NULL, noargs));
+			});
+		}
+		js_set_packed_arrays(0);
+		jsengine_dispose_object(engine, (Persistent<Object>*)g.value.arr[0].value.ptr);
+		jsvalue_dispose(g);
+	}
+	jsvalue_dispose(noargs);
+
+	jsengine_dispose_object(engine, (Persistent<Object>*)f.value.arr[0].value.ptr);
+	jsvalue_dispose(f);
+}
+
+// A scoring function over batches of records, one invoke per record or one
+// invoke per batch. Each op is a whole batch.
+static void BenchInvokeBatch(JsEngine* engine, JsContext* context)
+{
+	jsvalue f = Callable(context, "(function (a, b) { return a * 2 + b; })");
+	Persistent<Function>* func = (Persistent<Function>*)f.value.arr[0].value.ptr;
+
+	const int sizes[] = { 1, 16, 256, 4096 };
+	for (int s = 0; s < 4; s++) {
+		int size = sizes[s];
+		std::string shape = std::to_string(size);
+		int iterations = std::max(1, iterations_ * 16 / std::max(16, size));
+
+		Run("jscontext_invoke_loop", shape.c_str(), [&]() {
+			for (int i = 0; i < size; i++) {
+				jsvalue args = jsvalue_alloc_array(2);
+				args.value.arr[0] = MakeInteger(i);
+				args.value.arr[1] = MakeInteger(1);
+				jsvalue_dispose(jscontext_invoke(context, func, NULL, args));
+				jsvalue_dispose(args);
+			}
+		}, iterations);
+
+		Run("jscontext_invoke_batch", shape.c_str(), [&]() {
+			jsvalue argsets = jsvalue_alloc_array(size);
+			for (int i = 0; i < size; i++) {
+				argsets.value.arr[i] = jsvalue_alloc_array(2);
+				argsets.value.arr[i].value.arr[0] = MakeInteger(i);
+				argsets.value.arr[i].value.arr[1] = MakeInteger(1);
+			}
+			jsvalue_dispose(jscontext_invoke_batch(context, func, NULL, argsets));
+			jsvalue_dispose(argsets);
+		}, iterations);
+	}
+
+	jsengine_dispose_object(engine, (Persistent<Object>*)f.value.arr[0].value.ptr);
+	jsvalue_dispose(f);
+}
+
+static void BenchCallbacks(JsEngine* engine, JsContext* context)
+{
+	// A managed object is just an id on the CLR side; the stubs ignore it.
+	jsvalue m;
+	m.type = JSVALUE_TYPE_MANAGED;
+	m.length = 1;
+	m.value.i64 = 0;
+	jsvalue_dispose(jscontext_set_variable(context, U("m").c_str(), m));
+
+	jsvalue f = Callable(context, "(function () { return m.value; })");
+	Persistent<Function>* get = (Persistent<Function>*)f.value.arr[0].value.ptr;
+	jsvalue args = jsvalue_alloc_array(0);
+
+	callback_payload_ = MakeInteger(42);
+	Run("managed_prop_get", "primitive", [&]() {
+		jsvalue_dispose(jscontext_invoke(context, get, NULL, args));
+	});
+
+	callback_payload_ = jsvalue_alloc_string(long_string16_.c_str());
+	Run("managed_prop_get", "string", [&]() {
+		jsvalue_dispose(jscontext_invoke(context, get, NULL, args));
+	});
+	jsvalue_dispose(callback_payload_);
+	callback_payload_ = MakeInteger(42);
+
+	jsvalue g = Callable(context, "(function () { return m(1, 'two', 3.5); })");
+	Persistent<Function>* call = (Persistent<Function>*)g.value.arr[0].value.ptr;
+	Run("managed_call", "primitive", [&]() {
+		jsvalue_dispose(jscontext_invoke(context, call, NULL, args));
+	});
+
+	// The same object with a registered type: accessors instead of the
+	// named interceptor.
+	ustring value_name = U("value"), sum_name = U("sum");
+	const uint16_t* names[] = { value_name.c_str(), sum_name.c_str() };
+	int32_t kinds[] = { JSMEMBER_KIND_GET | JSMEMBER_KIND_SET, JSMEMBER_KIND_METHOD };
+	jsvalue t = m;
+	t.value.i32 = jsengine_register_type(engine, names, kinds, 2);
+	jsvalue_dispose(jscontext_set_variable(context, U("t").c_str(), t));
+
+	jsvalue h = Callable(context,
+		"(function () { var s = 0; for (var i = 0; i < 100; i++) s += m.value; return s; })");
+	Persistent<Function>* loop = (Persistent<Function>*)h.value.arr[0].value.ptr;
+	Run("managed_prop_get", "loop100", [&]() {
+		jsvalue_dispose(jscontext_invoke(context, loop, NULL, args));
+	});
+
+	jsvalue k = Callable(context,
+		"(function () { var s = 0; for (var i = 0; i < 100; i++) s += t.value; return s; })");
+	Persistent<Function>* typed_loop = (Persistent<Function>*)k.value.arr[0].value.ptr;
+	Run("managed_member_get", "loop100", [&]() {
+		jsvalue_dispose(jscontext_invoke(context, typed_loop, NULL, args));
+	});
+
+	jsvalue c = Callable(context, "(function () { return t.sum(1, 'two', 3.5); })");
+	Persistent<Function>* typed_call = (Persistent<Function>*)c.value.arr[0].value.ptr;
+	Run("managed_member_call", "primitive", [&]() {
+		jsvalue_dispose(jscontext_invoke(context, typed_call, NULL, args));
+	});
+
+	jsvalue l = Callable(context,
+		"(function () { var s = 0; for (var i = 0; i < 1000; i++) s += m[i]; return s; })");
+	Persistent<Function>* index_loop = (Persistent<Function>*)l.value.arr[0].value.ptr;
+	Run("managed_index_get", "loop1000", [&]() {
+		jsvalue_dispose(jscontext_invoke(context, index_loop, NULL, args));
+	});
+
+	// Names the CLR doesn't have: every read goes through the CLR unless the
+	// object carries a type key for the native member cache.
+	jsvalue n = Callable(context,
+		"(function () { var s = 0; for (var i = 0; i < 100; i++) if (m.missing === undefined) s++; return s; })");
+	Persistent<Function>* miss_loop = (Persistent<Function>*)n.value.arr[0].value.ptr;
+	callback_payload_.type = JSVALUE_TYPE_EMPTY;
+	Run("managed_prop_miss", "loop100", [&]() {
+		jsvalue_dispose(jscontext_invoke(context, miss_loop, NULL, args));
+	});
+	m.value.managed.type_key = 1;
+	jsvalue_dispose(jscontext_set_variable(context, U("m").c_str(), m));
+	Run("managed_prop_miss", "loop100_cached", [&]() {
+		jsvalue_dispose(jscontext_invoke(context, miss_loop, NULL, args));
+	});
+	callback_payload_ = MakeInteger(42);
+
+	jsengine_dispose_object(engine, (Persistent<Object>*)n.value.arr[0].value.ptr);
+	jsvalue_dispose(n);
+	jsengine_dispose_object(engine, (Persistent<Object>*)l.value.arr[0].value.ptr);
+	jsvalue_dispose(l);
+	jsengine_dispose_object(engine, (Persistent<Object>*)c.value.arr[0].value.ptr);
+	jsvalue_dispose(c);
+	jsengine_dispose_object(engine, (Persistent<Object>*)k.value.arr[0].value.ptr);
+	jsvalue_dispose(k);
+	jsengine_dispose_object(engine, (Persistent<Object>*)h.value.arr[0].value.ptr);
+	jsvalue_dispose(h);
+
+	jsvalue_dispose(args);
+	jsengine_dispose_object(engine, (Persistent<Object>*)g.value.arr[0].value.ptr);
+	jsvalue_dispose(g);
+	jsengine_dispose_object(engine, (Persistent<Object>*)f.value.arr[0].value.ptr);
+	jsvalue_dispose(f);
+}
+
+// Mixed-width string corpora: 1000 strings of 256 characters that are pure
+// ASCII, Latin-1, CJK or a mix of the three, crossing in both directions with
+// and without compact (one byte per character) strings.
+
+static const char* corpora_[] = { "ascii", "latin1", "utf16", "mixed" };
+static const int CorpusCount = 4;
+
+static uint16_t CorpusBase(const char* corpus, int i)
+{
+	if (strcmp(corpus, "latin1") == 0)
+		return 0xe0;
+	if (strcmp(corpus, "utf16") == 0)
+		return 0x4e00;
+	if (strcmp(corpus, "mixed") == 0) {
+		static const uint16_t bases[] = { 0x61, 0xe0, 0x4e00 };
+		return bases[i % 3];
+	}
+	return 0x61;
+}
+
+static std::string CorpusSource(const char* corpus)
+{
+	char bases[64];
+	snprintf(bases, sizeof(bases), "[%d, %d, %d]",
+		CorpusBase(corpus, 0), CorpusBase(corpus, 1), CorpusBase(corpus, 2));
+	return std::string("(function () {"
+		"  var bases = ") + bases + ", a = [];"
+		"  for (var i = 0; i < 1000; i++) {"
+		"    var c = [];"
+		"    for (var j = 0; j < 256; j++) c.push(bases[i % 3] + (j % 26));"
+		"    a.push(String.fromCharCode.apply(null, c));"
+		"  }"
+		"  return a;"
+		"})()";
+}
+
+static void BenchStrings(JsEngine* engine, JsContext* context)
+{
+	Persistent<Object>* target = Wrapped(context, "({})");
+	ustring prop = U("s");
+
+	for (int compact = 0; compact < 2; compact++) {
+		js_set_compact_strings(compact);
+
+		for (int c = 0; c < CorpusCount; c++) {
+			const char* corpus = corpora_[c];
+			std::string shape = std::string(corpus) + (compact ? "+compact" : "");
+
+			JsScript* script = jsscript_new(engine);
+			jsvalue_dispose(jsscript_compile(script, U(CorpusSource(corpus)).c_str(), U("<bench>").c_str()));
+			Run("strings_from_v8", shape.c_str(), [&]() {
+				jsvalue_dispose(jscontext_execute_script(context, script));
+			}, iterations_ / 10);
+			jsscript_dispose(script);
+
+			std::vector<ustring> strings(1000);
+			for (int i = 0; i < 1000; i++) {
+				for (int j = 0; j < 256; j++)
+					strings[i].push_back(CorpusBase(corpus, i) + (j % 26));
+			}
+			Run("strings_to_v8", shape.c_str(), [&]() {
+				for (int i = 0; i < 1000; i++) {
+					jsvalue value = jsvalue_alloc_string(strings[i].c_str());
+					jsvalue_dispose(jscontext_set_property_value(context, target, prop.c_str(), value));
+					jsvalue_dispose(value);
+				}
+			}, iterations_ / 10);
+		}
+	}
+
+	js_set_compact_strings(0);
+	jsengine_dispose_object(engine, target);
+}
+
+// A bootstrap bundle of a few megabytes: mostly functions that are never
+// called during startup, which is what precompile data lets V8 skip.
+static std::string JsBundle()
+{
+	std::string bundle = "var lib = {};\n";
+	char buf[512];
+	for (int i = 0; i < 20000; i++) {
+		snprintf(buf, sizeof(buf),
+			"lib.f%d = function (a, b) {\n"
+			"  var r = [], i, s = 'item' + %d;\n"
+			"  for (i = 0; i < a.length; i++) { if (a[i] > b) r.push({ k: s + i, v: a[i] * %d }); }\n"
+			"  return r.length ? r : null;\n"
+			"};\n", i, i, i);
+		bundle += buf;
+	}
+	return bundle + "lib.f0([1, 2, 3], 1).length";
+}
+
+static void BenchPrecompile(JsEngine* engine)
+{
+	ustring bundle = U(JsBundle());
+	ustring name = U("bundle.js");
+
+	for (int cached = 0; cached < 2; cached++) {
+		// The warmup run fills the cache, the timed ones read it back.
+		jsengine_set_precompile_cache(engine, cached ? U("vroomjs_bench_precompile").c_str() : NULL);
+		Run("jsscript_compile_bundle", cached ? "precompiled" : "plain", [&]() {
+			JsScript* script = jsscript_new(engine);
+			jsvalue_dispose(jsscript_compile(script, bundle.c_str(), name.c_str()));
+			jsscript_dispose(script);
+		}, iterations_ / 200);
+	}
+	jsengine_set_precompile_cache(engine, NULL);
+}
+
+// A short tenant request: define a few globals, run, throw the state away.
+// Either with a context per request or with one context reset after each.
+static void BenchContexts(JsEngine* engine)
+{
+	ustring request = U("var state = { hits: 0 }; function handle(n) { state.hits += n; return state.hits; } handle(42)");
+
+	Run("context_request", "new", [&]() {
+		JsContext* context = jscontext_new(2, engine);
+		jsvalue_dispose(jscontext_execute(context, request.c_str(), NULL));
+		jscontext_dispose(context);
+	}, iterations_ / 10);
+
+	JsContext* context = jscontext_new(2, engine);
+	int32_t fast = 0, resets = 0;
+	Run("context_request", "recycled", [&]() {
+		jsvalue_dispose(jscontext_execute(context, request.c_str(), NULL));
+		fast += jscontext_reset(context);
+		resets++;
+	}, iterations_ / 10);
+	if (resets > 0)
+		printf("  reset: %d of %d in place\n", fast, resets);
+	jscontext_dispose(context);
+}
+
+// Round trip of getting an engine with one context ready and giving it back,
+// with and without the pool. Releasing to the pool includes the reset GC.
+static void BenchEngines()
+{
+	Run("engine_startup", "new", [&]() {
+		JsEngine* engine = jsengine_new(stub_remove, stub_get_property_value, stub_set_property_value,
+			stub_valueof, stub_invoke, stub_delete_property, stub_enumerate_properties, -1, -1);
+		JsContext* context = jscontext_new(1, engine);
+		jscontext_dispose(context);
+		jsengine_dispose(engine);
+	}, iterations_ / 20);
+
+	JsEnginePool* pool = jsenginepool_new(4, 8, -1, -1);
+	Run("engine_startup", "pool", [&]() {
+		JsEngine* engine = jsenginepool_acquire(pool, stub_remove, stub_get_property_value, stub_set_property_value,
+			stub_valueof, stub_invoke, stub_delete_property, stub_enumerate_properties);
+		JsContext* context = jscontext_new(1, engine);
+		jscontext_dispose(context);
+		jsenginepool_release(pool, engine);
+	}, iterations_ / 20);
+
+	jsenginepool_stats stats;
+	jsenginepool_get_stats(pool, &stats);
+	if (stats.hits + stats.misses > 0) {
+		printf("  pool: %lld hits, %lld misses, %lld created (max %lld us)\n",
+			(long long)stats.hits, (long long)stats.misses, (long long)stats.created,
+			(long long)stats.creation_time_max);
+	}
+	jsenginepool_dispose(pool);
+}
+
+int main(int argc, char* argv[])
+{
+	if (argc > 1)
+		iterations_ = atoi(argv[1]);
+	if (argc > 2)
+		filter_ = argv[2];
+
+	long_string_.reserve(LongStringLength);
+	for (int i = 0; i < LongStringLength; i++)
+		long_string_.push_back('a' + (i % 26));
+	long_string16_ = U(long_string_);
+	callback_payload_ = MakeInteger(42);
+
+	js_set_object_marshal_type(JSOBJECT_MARSHAL_TYPE_DICTIONARY);
+
+	JsEngine* engine = jsengine_new(stub_remove, stub_get_property_value, stub_set_property_value,
+		stub_valueof, stub_invoke, stub_delete_property, stub_enumerate_properties, -1, -1);
+	jsengine_set_member_delegates(engine, stub_get_member, stub_set_member, stub_invoke_member);
+	jsengine_set_indexed_delegate(engine, stub_indexed);
+	jsengine_set_buffer_delegate(engine, stub_release_buffer);
+	JsContext* context = jscontext_new(1, engine);
+
+	printf("%-44s %12s %12s %12s\n", "entry/shape", "ops/sec", "p50 (us)", "p99 (us)");
+
+	BenchExecute(engine, context);
+	BenchProperties(engine, context);
+	BenchInvoke(engine, context);
+	BenchInvokeBatch(engine, context);
+	BenchSession(engine, context);
+	BenchJson(engine, context);
+	BenchColumns(engine, context);
+	BenchGraph(engine, context);
+	BenchLazy(engine, context);
+	BenchBuffers(engine, context);
+	BenchCallbacks(engine, context);
+	BenchStrings(engine, context);
+	BenchPrecompile(engine);
+	BenchContexts(engine);
+	BenchEngines();
+
+	jscontext_dispose(context);
+	jsengine_dispose(engine);
+	return 0;
+}
@@ -23,12 +23,21 @@
 // OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
 // THE SOFTWARE.
 
+#include <cstring>
 #include <iostream>
 #include "vroomjs.h"
 
 using namespace v8;
 
-int32_t js_object_marshal_type;
+jspolicy js_default_policy;
+
+static void set_default_flag(int32_t flag, int32_t enabled)
+{
+	if (enabled)
+		js_default_policy.flags |= flag;
+	else
+		js_default_policy.flags &= ~flag;
+}
 
 extern "C" 
 {
@@ -37,7 +46,64 @@ extern "C"
 #ifdef DEBUG_TRACE_API
 		std::wcout << "js_object_marshal_type " << type << std::endl;
 #endif
-	    js_object_marshal_type = type;
+	    js_default_policy.object_marshal_type = type;
+    }
+
+	EXPORT void CALLINGCONVENTION js_set_compact_strings(int32_t enabled)
+    {
+#ifdef DEBUG_TRACE_API
+		std::wcout << "js_compact_strings " << enabled << std::endl;
+#endif
+	    set_default_flag(JSPOLICY_COMPACT_STRINGS, enabled);
+    }
+
+	EXPORT void CALLINGCONVENTION js_set_packed_arrays(int32_t enabled)
+    {
+#ifdef DEBUG_TRACE_API
+		std::wcout << "js_packed_arrays " << enabled << std::endl;
+#endif
+	    set_default_flag(JSPOLICY_PACKED_ARRAYS, enabled);
+    }
+
+	EXPORT void CALLINGCONVENTION js_set_flat_results(int32_t enabled)
+    {
+#ifdef DEBUG_TRACE_API
+		std::wcout << "js_flat_results " << enabled << std::endl;
+#endif
+	    set_default_flag(JSPOLICY_FLAT_RESULTS, enabled);
+    }
+
+	EXPORT void CALLINGCONVENTION js_set_columnar_results(int32_t enabled)
+    {
+#ifdef DEBUG_TRACE_API
+		std::wcout << "js_columnar_results " << enabled << std::endl;
+#endif
+	    set_default_flag(JSPOLICY_COLUMNAR_RESULTS, enabled);
+    }
+
+	EXPORT void CALLINGCONVENTION js_set_shared_objects(int32_t enabled)
+    {
+#ifdef DEBUG_TRACE_API
+		std::wcout << "js_shared_objects " << enabled << std::endl;
+#endif
+	    set_default_flag(JSPOLICY_SHARED_OBJECTS, enabled);
+    }
+
+	EXPORT void CALLINGCONVENTION js_set_conversion_limits(int32_t max_depth, int32_t max_nodes)
+    {
+#ifdef DEBUG_TRACE_API
+		std::wcout << "js_set_conversion_limits " << max_depth << " " << max_nodes << std::endl;
+#endif
+	    js_default_policy.max_depth = max_depth;
+	    js_default_policy.max_nodes = max_nodes;
+    }
+
+	EXPORT void CALLINGCONVENTION js_set_max_string_length(int32_t length)
+    {
+#ifdef DEBUG_TRACE_API
+		std::wcout << "js_set_max_string_length " << length << std::endl;
+#endif
+	    js_default_policy.max_string_length = length;
     }
 
 	EXPORT JsEngine* CALLINGCONVENTION jsengine_new(keepalive_remove_f keepalive_remove, 
@@ -65,6 +131,139 @@ extern "C"
 		return engine;
 	}
 
+	EXPORT JsEnginePool* CALLINGCONVENTION jsenginepool_new(int32_t min_size, int32_t max_size, 
+						   int32_t max_young_space, int32_t max_old_space)
+	{
+#ifdef DEBUG_TRACE_API
+		std::wcout << "jsenginepool_new" << std::endl;
+#endif
+		return JsEnginePool::New(min_size, max_size, max_young_space, max_old_space);
+	}
+
+	EXPORT JsEngine* CALLINGCONVENTION jsenginepool_acquire(JsEnginePool* pool,
+                           keepalive_remove_f keepalive_remove, 
+                           keepalive_get_property_value_f keepalive_get_property_value,
+                           keepalive_set_property_value_f keepalive_set_property_value,
+						   keepalive_valueof_f keepalive_valueof,
+                           keepalive_invoke_f keepalive_invoke,
+						   keepalive_delete_property_f keepalive_delete_property,
+						   keepalive_enumerate_properties_f keepalive_enumerate_properties) 
+	{
+#ifdef DEBUG_TRACE_API
+		std::wcout << "jsenginepool_acquire" << std::endl;
+#endif
+		JsEngine *engine = pool->Acquire();
+		if (engine != NULL) {
+            engine->SetRemoveDelegate(keepalive_remove);
+            engine->SetGetPropertyValueDelegate(keepalive_get_property_value);
+            engine->SetSetPropertyValueDelegate(keepalive_set_property_value);
+			engine->SetValueOfDelegate(keepalive_valueof);
+            engine->SetInvokeDelegate(keepalive_invoke);
+			engine->SetDeletePropertyDelegate(keepalive_delete_property);
+			engine->SetEnumeratePropertiesDelegate(keepalive_enumerate_properties);
+        }
+		return engine;
+	}
+
+	EXPORT void CALLINGCONVENTION jsenginepool_release(JsEnginePool* pool, JsEngine* engine)
+	{
+#ifdef DEBUG_TRACE_API
+		std::wcout << "jsenginepool_release" << std::endl;
+#endif
+		pool->Release(engine);
+	}
+
+	EXPORT void CALLINGCONVENTION jsenginepool_get_stats(JsEnginePool* pool, jsenginepool_stats* stats)
+	{
+		pool->GetStats(stats);
+	}
+
+	EXPORT void CALLINGCONVENTION jsenginepool_dispose(JsEnginePool* pool)
+	{
+#ifdef DEBUG_TRACE_API
+		std::wcout << "jsenginepool_dispose" << std::endl;
+#endif
+		pool->Dispose();
+		delete pool;
+	}
+
+	EXPORT void CALLINGCONVENTION jsengine_set_script_cache_budget(JsEngine* engine, int64_t budget)
+	{
+#ifdef DEBUG_TRACE_API
+		std::wcout << "jsengine_set_script_cache_budget " << budget << std::endl;
+#endif
+		engine->GetScriptCache()->SetBudget(budget);
+	}
+
+	EXPORT void CALLINGCONVENTION jsengine_get_script_cache_stats(JsEngine* engine, jsscriptcache_stats* stats)
+	{
+		engine->GetScriptCache()->GetStats(stats);
+	}
+
+	EXPORT void CALLINGCONVENTION jsengine_get_member_cache_stats(JsEngine* engine, jsmembercache_stats* stats)
+	{
+		engine->GetMemberCacheStats(stats);
+	}
+
+	EXPORT void CALLINGCONVENTION jsengine_set_precompile_cache(JsEngine* engine, const uint16_t* directory)
+	{
+#ifdef DEBUG_TRACE_API
+		std::wcout << "jsengine_set_precompile_cache" << std::endl;
+#endif
+		engine->SetPrecompileCache(directory);
+	}
+
+	EXPORT int32_t CALLINGCONVENTION jsengine_intern_name(JsEngine* engine, const uint16_t* name)
+	{
+#ifdef DEBUG_TRACE_API
+		std::wcout << "jsengine_intern_name" << std::endl;
+#endif
+		return engine->InternName(name);
+	}
+
+	EXPORT void CALLINGCONVENTION jsengine_set_member_delegates(JsEngine* engine,
+						   keepalive_get_member_f keepalive_get_member,
+						   keepalive_set_member_f keepalive_set_member,
+						   keepalive_invoke_member_f keepalive_invoke_member)
+	{
+#ifdef DEBUG_TRACE_API
+		std::wcout << "jsengine_set_member_delegates" << std::endl;
+#endif
+		engine->SetMemberDelegates(keepalive_get_member, keepalive_set_member, keepalive_invoke_member);
+	}
+
+	EXPORT void CALLINGCONVENTION jsengine_set_indexed_delegate(JsEngine* engine, keepalive_indexed_f keepalive_indexed)
+	{
+#ifdef DEBUG_TRACE_API
+		std::wcout << "jsengine_set_indexed_delegate" << std::endl;
+#endif
+		engine->SetIndexedDelegate(keepalive_indexed);
+	}
+
+	EXPORT void CALLINGCONVENTION jsengine_set_buffer_delegate(JsEngine* engine, keepalive_release_buffer_f keepalive_release_buffer)
+	{
+#ifdef DEBUG_TRACE_API
+		std::wcout << "jsengine_set_buffer_delegate" << std::endl;
+#endif
+		engine->SetReleaseBufferDelegate(keepalive_release_buffer);
+	}
+
+	EXPORT void CALLINGCONVENTION jsengine_set_missing_property_delegate(JsEngine* engine, keepalive_missing_property_f keepalive_missing_property)
+	{
+#ifdef DEBUG_TRACE_API
+		std::wcout << "jsengine_set_missing_property_delegate" << std::endl;
+#endif
+		engine->SetMissingPropertyDelegate(keepalive_missing_property);
+	}
+
+	EXPORT int32_t CALLINGCONVENTION jsengine_register_type(JsEngine* engine, const uint16_t** names, const int32_t* kinds, int32_t count)
+	{
+#ifdef DEBUG_TRACE_API
+		std::wcout << "jsengine_register_type" << std::endl;
+#endif
+		return engine->RegisterType(names, kinds, count);
+	}
+
 	EXPORT void CALLINGCONVENTION jsengine_terminate_execution(JsEngine* engine) {
 #ifdef DEBUG_TRACE_API
                 std::wcout << "jsengine_terminate_execution" << std::endl;
@@ -116,6 +315,30 @@ extern "C"
         while(!V8::IdleNotification()) {};
     }
 
+    EXPORT int32_t CALLINGCONVENTION jscontext_reset(JsContext* context)
+    {
+#ifdef DEBUG_TRACE_API
+		std::wcout << "jscontext_reset" << std::endl;
+#endif
+        return context->Reset() ? 1 : 0;
+    }
+
+    EXPORT void CALLINGCONVENTION jscontext_session_begin(JsContext* context)
+    {
+#ifdef DEBUG_TRACE_API
+		std::wcout << "jscontext_session_begin" << std::endl;
+#endif
+        context->BeginSession();
+    }
+
+    EXPORT int32_t CALLINGCONVENTION jscontext_session_end(JsContext* context)
+    {
+#ifdef DEBUG_TRACE_API
+		std::wcout << "jscontext_session_end" << std::endl;
+#endif
+        return context->EndSession() ? 1 : 0;
+    }
+
     EXPORT void jscontext_dispose(JsContext* context)
     {
 #ifdef DEBUG_TRACE_API
@@ -152,6 +375,62 @@ extern "C"
         return context->Execute(script);
     }
 
+    EXPORT jsvalue CALLINGCONVENTION jscontext_execute_mode(JsContext* context, const uint16_t* str, const uint16_t *resourceName, int32_t mode)
+    {
+#ifdef DEBUG_TRACE_API
+		std::wcout << "jscontext_execute_mode" << std::endl;
+#endif
+        return context->Execute(str, resourceName, mode);
+    }
+
+	EXPORT jsvalue CALLINGCONVENTION jscontext_execute_script_mode(JsContext* context, JsScript *script, int32_t mode)
+    {
+#ifdef DEBUG_TRACE_API
+		std::wcout << "jscontext_execute_script_mode" << std::endl;
+#endif
+        return context->Execute(script, mode);
+    }
+
+    EXPORT void CALLINGCONVENTION jscontext_set_policy(JsContext* context, const jspolicy *policy)
+    {
+#ifdef DEBUG_TRACE_API
+		std::wcout << "jscontext_set_policy" << std::endl;
+#endif
+        context->SetPolicy(policy);
+    }
+
+    EXPORT jsvalue CALLINGCONVENTION jscontext_execute_policy(JsContext* context, const uint16_t* str, const uint16_t *resourceName, int32_t mode, const jspolicy *policy)
+    {
+#ifdef DEBUG_TRACE_API
+		std::wcout << "jscontext_execute_policy" << std::endl;
+#endif
+        return context->Execute(str, resourceName, mode, policy);
+    }
+
+	EXPORT jsvalue CALLINGCONVENTION jscontext_execute_script_policy(JsContext* context, JsScript *script, int32_t mode, const jspolicy *policy)
+    {
+#ifdef DEBUG_TRACE_API
+		std::wcout << "jscontext_execute_script_policy" << std::endl;
+#endif
+        return context->Execute(script, mode, policy);
+    }
+
+    EXPORT jsvalue CALLINGCONVENTION jscontext_execute_columns(JsContext* context, const uint16_t* str, const uint16_t *resourceName, const uint16_t** names, int32_t count)
+    {
+#ifdef DEBUG_TRACE_API
+		std::wcout << "jscontext_execute_columns" << std::endl;
+#endif
+        return context->ExecuteColumns(str, resourceName, names, count);
+    }
+
+    EXPORT jsvalue CALLINGCONVENTION jscontext_execute_columns_policy(JsContext* context, const uint16_t* str, const uint16_t *resourceName, const uint16_t** names, int32_t count, int32_t mode, const jspolicy *policy)
+    {
+#ifdef DEBUG_TRACE_API
+		std::wcout << "jscontext_execute_columns_policy" << std::endl;
+#endif
+        return context->ExecuteColumns(str, resourceName, names, count, mode, policy);
+    }
+
 	EXPORT jsvalue CALLINGCONVENTION jscontext_get_global(JsContext* context)
     {
 #ifdef DEBUG_TRACE_API
@@ -176,6 +455,22 @@ extern "C"
         return context->GetVariable(name);
     }
 
+    EXPORT jsvalue CALLINGCONVENTION jscontext_set_variable_atom(JsContext* context, int32_t atom, jsvalue value)
+    {
+#ifdef DEBUG_TRACE_API
+		std::wcout << "jscontext_set_variable_atom" << std::endl;
+#endif
+        return context->SetVariable(atom, value);
+    }
+
+    EXPORT jsvalue CALLINGCONVENTION jscontext_get_variable_atom(JsContext* context, int32_t atom)
+    {
+#ifdef DEBUG_TRACE_API
+		std::wcout << "jscontext_get_variable_atom" << std::endl;
+#endif
+        return context->GetVariable(atom);
+    }
+
     EXPORT jsvalue CALLINGCONVENTION jscontext_get_property_value(JsContext* context, Persistent<Object>* obj, const uint16_t* name)
     {
 #ifdef DEBUG_TRACE_API
@@ -192,6 +487,54 @@ extern "C"
         return context->SetPropertyValue(obj, name, value);
     }    
 
+    EXPORT jsvalue CALLINGCONVENTION jscontext_get_property_value_atom(JsContext* context, Persistent<Object>* obj, int32_t atom)
+    {
+#ifdef DEBUG_TRACE_API
+		std::wcout << "jscontext_get_property_value_atom" << std::endl;
+#endif
+        return context->GetPropertyValue(obj, atom);
+    }
+
+    EXPORT jsvalue CALLINGCONVENTION jscontext_set_property_value_atom(JsContext* context, Persistent<Object>* obj, int32_t atom, jsvalue value)
+    {
+#ifdef DEBUG_TRACE_API
+		std::wcout << "jscontext_set_property_value_atom" << std::endl;
+#endif
+        return context->SetPropertyValue(obj, atom, value);
+    }
+
+    EXPORT jsvalue CALLINGCONVENTION jscontext_get_property_values(JsContext* context, Persistent<Object>* obj, const uint16_t** names, int32_t count)
+    {
+#ifdef DEBUG_TRACE_API
+		std::wcout << "jscontext_get_property_values" << std::endl;
+#endif
+        return context->GetPropertyValues(obj, names, count);
+    }
+    
+    EXPORT jsvalue CALLINGCONVENTION jscontext_set_property_values(JsContext* context, Persistent<Object>* obj, const uint16_t** names, int32_t count, jsvalue values)
+    {
+#ifdef DEBUG_TRACE_API
+		std::wcout << "jscontext_set_property_values" << std::endl;
+#endif
+        return context->SetPropertyValues(obj, names, count, values);
+    }    
+
+    EXPORT jsvalue CALLINGCONVENTION jscontext_get_property_values_atoms(JsContext* context, Persistent<Object>* obj, const int32_t* atoms, int32_t count)
+    {
+#ifdef DEBUG_TRACE_API
+		std::wcout << "jscontext_get_property_values_atoms" << std::endl;
+#endif
+        return context->GetPropertyValues(obj, atoms, count);
+    }
+
+    EXPORT jsvalue CALLINGCONVENTION jscontext_set_property_values_atoms(JsContext* context, Persistent<Object>* obj, const int32_t* atoms, int32_t count, jsvalue values)
+    {
+#ifdef DEBUG_TRACE_API
+		std::wcout << "jscontext_set_property_values_atoms" << std::endl;
+#endif
+        return context->SetPropertyValues(obj, atoms, count, values);
+    }
+
 	EXPORT jsvalue CALLINGCONVENTION jscontext_get_property_names(JsContext* context, Persistent<Object>* obj)
     {
 #ifdef DEBUG_TRACE_API
@@ -208,6 +551,14 @@ extern "C"
         return context->InvokeProperty(obj, name, args);
     }        
 
+    EXPORT jsvalue CALLINGCONVENTION jscontext_invoke_property_atom(JsContext* context, Persistent<Object>* obj, int32_t atom, jsvalue args)
+    {
+#ifdef DEBUG_TRACE_API
+		std::wcout << "jscontext_invoke_property_atom" << std::endl;
+#endif
+        return context->InvokeProperty(obj, atom, args);
+    }
+
 	  EXPORT jsvalue CALLINGCONVENTION jscontext_invoke(JsContext* context, Persistent<Function>* funcArg, Persistent<Object>* thisArg, jsvalue args)
     {
 #ifdef DEBUG_TRACE_API
@@ -216,6 +567,86 @@ extern "C"
         return context->InvokeFunction(funcArg, thisArg, args);
     }        
 
+	  EXPORT jsvalue CALLINGCONVENTION jscontext_invoke_mode(JsContext* context, Persistent<Function>* funcArg, Persistent<Object>* thisArg, jsvalue args, int32_t mode)
+    {
+#ifdef DEBUG_TRACE_API
+		std::wcout << "jscontext_invoke_mode" << std::endl;
+#endif
+        return context->InvokeFunction(funcArg, thisArg, args, mode);
+    }        
+
+	  EXPORT jsvalue CALLINGCONVENTION jscontext_invoke_policy(JsContext* context, Persistent<Function>* funcArg, Persistent<Object>* thisArg, jsvalue args, int32_t mode, const jspolicy *policy)
+    {
+#ifdef DEBUG_TRACE_API
+		std::wcout << "jscontext_invoke_policy" << std::endl;
+#endif
+        return context->InvokeFunction(funcArg, thisArg, args, mode, policy);
+    }        
+
+    EXPORT jsvalue CALLINGCONVENTION jscontext_convert(JsContext* context, Persistent<Object>* obj)
+    {
+#ifdef DEBUG_TRACE_API
+		std::wcout << "jscontext_convert" << std::endl;
+#endif
+        return context->Convert(obj);
+    }
+
+    EXPORT jsvalue CALLINGCONVENTION jscontext_array_length(JsContext* context, Persistent<Object>* obj)
+    {
+#ifdef DEBUG_TRACE_API
+		std::wcout << "jscontext_array_length" << std::endl;
+#endif
+        return context->GetArrayLength(obj);
+    }
+
+    EXPORT jsvalue CALLINGCONVENTION jscontext_array_get_range(JsContext* context, Persistent<Object>* obj, int32_t start, int32_t count)
+    {
+#ifdef DEBUG_TRACE_API
+		std::wcout << "jscontext_array_get_range" << std::endl;
+#endif
+        return context->GetArrayRange(obj, start, count);
+    }
+
+    EXPORT jsvalue CALLINGCONVENTION jscontext_string_read(JsContext* context, Persistent<Object>* obj, int32_t offset, int32_t count)
+    {
+#ifdef DEBUG_TRACE_API
+		std::wcout << "jscontext_string_read" << std::endl;
+#endif
+        return context->ReadString(obj, offset, count);
+    }
+
+	  EXPORT jsvalue CALLINGCONVENTION jscontext_invoke_batch(JsContext* context, Persistent<Function>* funcArg, Persistent<Object>* thisArg, jsvalue argsets)
+    {
+#ifdef DEBUG_TRACE_API
+		std::wcout << "jscontext_invoke_batch" << std::endl;
+#endif
+        return context->InvokeBatch(funcArg, thisArg, argsets);
+    }        
+
+    EXPORT jsvalue CALLINGCONVENTION jscontext_get_json(JsContext* context, const uint16_t* name)
+    {
+#ifdef DEBUG_TRACE_API
+		std::wcout << "jscontext_get_json" << std::endl;
+#endif
+        return context->GetVariableJson(name);
+    }
+
+    EXPORT jsvalue CALLINGCONVENTION jscontext_set_json(JsContext* context, const uint16_t* name, const char* json, int32_t length)
+    {
+#ifdef DEBUG_TRACE_API
+		std::wcout << "jscontext_set_json" << std::endl;
+#endif
+        return context->SetVariableJson(name, json, length);
+    }
+
+	  EXPORT jsvalue CALLINGCONVENTION jscontext_invoke_json(JsContext* context, Persistent<Function>* funcArg, Persistent<Object>* thisArg, const char* args, int32_t length)
+    {
+#ifdef DEBUG_TRACE_API
+		std::wcout << "jscontext_invoke_json" << std::endl;
+#endif
+        return context->InvokeFunctionJson(funcArg, thisArg, args, length);
+    }        
+
 	 EXPORT JsScript* CALLINGCONVENTION jsscript_new(JsEngine *engine)
     {
 #ifdef DEBUG_TRACE_API
@@ -254,12 +685,33 @@ extern "C"
             length++;
           
         v.length = length;
-        v.value.str = new uint16_t[length+1];
+        v.type = JSVALUE_TYPE_STRING;
+
+        // Large strings are shared with V8 instead of being copied again.
+        if (length >= JS_EXTERNAL_STRING_MIN_LENGTH) {
+            v.value.str = JsExternalString::Alloc(length);
+            v.type = JSVALUE_TYPE_EXTERNAL_STRING;
+        } else if ((js_default_policy.flags & JSPOLICY_COMPACT_STRINGS) && js_is_ascii(str, length)) {
+            // Same allocation as in JsEngine::AllocAsciiString.
+            v.value.str = (uint16_t*)JsArena::HeapAlloc(length + 1);
+            if (v.value.str != NULL) {
+                uint8_t *ascii = (uint8_t*)v.value.str;
+                js_narrow_ascii(str, length, ascii);
+                ascii[length] = '\0';
+                v.type = JSVALUE_TYPE_ASCII_STRING;
+            } else {
+                v.type = JSVALUE_TYPE_UNKNOWN_ERROR;
+            }
+            return v;
+        } else {
+            v.value.str = (uint16_t*)JsArena::HeapAlloc((length + 1) * sizeof(uint16_t));
+        }
+
         if (v.value.str != NULL) {
-            for (int i=0 ; i < length ; i++)
-                 v.value.str[i] = str[i];
+            memcpy(v.value.str, str, length * sizeof(uint16_t));
             v.value.str[length] = '\0';
-            v.type = JSVALUE_TYPE_STRING;
+        } else {
+            v.type = JSVALUE_TYPE_UNKNOWN_ERROR;
         }
 
         return v;
@@ -272,7 +724,7 @@ extern "C"
 #endif
         jsvalue v;
           
-        v.value.arr = new jsvalue[length];
+        v.value.arr = (jsvalue*)JsArena::HeapAlloc(length * sizeof(jsvalue));
         if (v.value.arr != NULL) {
             v.length = length;
             v.type = JSVALUE_TYPE_ARRAY;
@@ -281,38 +733,89 @@ extern "C"
         return v;
     }        
                 
-    EXPORT void CALLINGCONVENTION jsvalue_dispose(jsvalue value)
+    static void jsvalue_dispose_tree(jsvalue value)
     {
-#ifdef DEBUG_TRACE_API
-		std::wcout << "jsvalue_dispose" << std::endl;
-#endif
-        if (value.type == JSVALUE_TYPE_STRING || value.type == JSVALUE_TYPE_STRING_ERROR) {
+        if (value.type == JSVALUE_TYPE_STRING || value.type == JSVALUE_TYPE_ASCII_STRING || value.type == JSVALUE_TYPE_JSON || value.type == JSVALUE_TYPE_STRING_ERROR) {
             if (value.value.str != NULL) {
-				delete[] value.value.str;
+				JsArena::HeapFree(value.value.str);
 			}
         }
+		else if (value.type == JSVALUE_TYPE_EXTERNAL_STRING) {
+            if (value.value.str != NULL) {
+				JsExternalString::Release(value.value.str);
+			}
+		}
 		else if (value.type == JSVALUE_TYPE_ARRAY || value.type == JSVALUE_TYPE_FUNCTION) {
 		    for (int i=0 ; i < value.length ; i++) {
-                jsvalue_dispose(value.value.arr[i]);
+                jsvalue_dispose_tree(value.value.arr[i]);
 			}
             if (value.value.arr != NULL) {
-                delete[] value.value.arr;
+                JsArena::HeapFree(value.value.arr);
 			}
         }
+		else if (value.type == JSVALUE_TYPE_INT32_ARRAY || value.type == JSVALUE_TYPE_DOUBLE_ARRAY) {
+            if (value.value.ptr != NULL) {
+                JsArena::HeapFree(value.value.ptr);
+			}
+		}
+		else if (value.type == JSVALUE_TYPE_COLUMNS) {
+            if (value.value.arr != NULL) {
+                // The keys and then a column per key.
+                int32_t count = value.value.arr[0].length + 1;
+                for (int i=0 ; i < count ; i++) {
+                    jsvalue_dispose_tree(value.value.arr[i]);
+                }
+                JsArena::HeapFree(value.value.arr);
+			}
+		}
 		else if (value.type == JSVALUE_TYPE_DICT) {
 			for (int i=0 ; i < value.length * 2; i++) {
-                jsvalue_dispose(value.value.arr[i]);
+                jsvalue_dispose_tree(value.value.arr[i]);
 			}
             if (value.value.arr != NULL) {
-                delete[] value.value.arr;
+                JsArena::HeapFree(value.value.arr);
 			}
 		}
 		else if (value.type == JSVALUE_TYPE_ERROR) {
 			jserror *error = (jserror*)value.value.ptr;
-			jsvalue_dispose(error->resource);
-			jsvalue_dispose(error->message);
-			jsvalue_dispose(error->exception);
-			delete error;
+			jsvalue_dispose_tree(error->type);
+			jsvalue_dispose_tree(error->resource);
+			jsvalue_dispose_tree(error->message);
+			jsvalue_dispose_tree(error->exception);
+			JsArena::HeapFree(error);
 		}
+    }
+
+    EXPORT void CALLINGCONVENTION jsvalue_dispose(jsvalue value)
+    {
+#ifdef DEBUG_TRACE_API
+		std::wcout << "jsvalue_dispose" << std::endl;
+#endif
+        switch (value.type) {
+            case JSVALUE_TYPE_STRING:
+            case JSVALUE_TYPE_ASCII_STRING:
+            case JSVALUE_TYPE_JSON:
+            case JSVALUE_TYPE_STRING_ERROR:
+            case JSVALUE_TYPE_ARRAY:
+            case JSVALUE_TYPE_INT32_ARRAY:
+            case JSVALUE_TYPE_DOUBLE_ARRAY:
+            case JSVALUE_TYPE_FUNCTION:
+            case JSVALUE_TYPE_DICT:
+            case JSVALUE_TYPE_COLUMNS:
+            case JSVALUE_TYPE_ERROR:
+                // Results built inside a JsArenaScope are freed all at once,
+                // anything else (i.e., allocated by the CLR) is walked.
+                if (value.value.ptr == NULL || JsArena::Release(value.value.ptr))
+                    return;
+                jsvalue_dispose_tree(value);
+                break;
+            case JSVALUE_TYPE_EXTERNAL_STRING:
+                jsvalue_dispose_tree(value);
+                break;
+            case JSVALUE_TYPE_FLAT:
+                // See js_flatten.
+                delete[] (uint64_t*)value.value.ptr;
+                break;
+        }
     }       
 }
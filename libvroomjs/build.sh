@@ -1,4 +1,5 @@
 #!/bin/sh
-g++ jscontext.cpp jsengine.cpp managedref.cpp bridge.cpp -o libVroomJsNative.so -shared -L ~/v8-3.17/out/x64.release/lib.target/ -I ~/v8-3.17/include/ -fPIC -Wl,--no-as-needed -lv8
-
+g++ jsarena.cpp jscontext.cpp jsengine.cpp jsenginepool.cpp jsflat.cpp jsgraph.cpp jsprecompile.cpp jsscript.cpp jsscriptcache.cpp jsstring.cpp managedref.cpp bridge.cpp -o libVroomJsNative.so -shared -L ~/v8-3.17/out/x64.release/lib.target/ -I ~/v8-3.17/include/ -fPIC -pthread -Wl,--no-as-needed -lv8
 
+# Native microbenchmarks for the bridge entry points, see bench/bench.cpp.
+g++ bench/bench.cpp -o vroomjs_bench -O2 -L . -L ~/v8-3.17/out/x64.release/lib.target/ -I ~/v8-3.17/include/ -Wl,--no-as-needed -Wl,-rpath,'$ORIGIN' -lVroomJsNative -lv8
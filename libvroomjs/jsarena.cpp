@@ -0,0 +1,172 @@
+// This file is part of the VroomJs library.
+//
+// Author:
+//     Federico Di Gregorio <fog@initd.org>
+//
+// Copyright © 2013 Federico Di Gregorio <fog@initd.org>
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#include <cstdlib>
+#include <cstring>
+#include "vroomjs.h"
+
+static const size_t FirstChunkSize = 8 * 1024;
+static const size_t MaxChunkSize = 1024 * 1024;
+
+// Right before every block a jsvalue can point to: the arena that owns the
+// result the block is the root of, NULL for anything else. Reading it needs
+// no lock, results are released from whatever thread the CLR finalizes them
+// on.
+union BlockHeader
+{
+	JsArena *arena;
+	uint64_t align;
+};
+
+static inline BlockHeader *HeaderOf(void *block)
+{
+	return (BlockHeader*)block - 1;
+}
+
+JsArena *JsArena::New()
+{
+	return new JsArena();
+}
+
+void *JsArena::Alloc(size_t size)
+{
+	// Everything we put in here is either a jsvalue (8-byte aligned because of
+	// the union) or an uint16_t buffer, so 8 bytes is all we need.
+	size = ((size + 7) & ~(size_t)7) + sizeof(BlockHeader);
+
+	if (chunks_ == NULL || chunks_->size - chunks_->used < size) {
+		size_t chunk_size = FirstChunkSize;
+		if (chunks_ != NULL) {
+			chunk_size = chunks_->size * 2;
+			if (chunk_size > MaxChunkSize)
+				chunk_size = MaxChunkSize;
+		}
+		if (chunk_size < size)
+			chunk_size = size;
+
+		Chunk *chunk = (Chunk*)malloc(sizeof(Chunk) + chunk_size);
+		if (chunk == NULL)
+			return NULL;
+		chunk->next = chunks_;
+		chunk->size = chunk_size;
+		chunk->used = 0;
+		chunks_ = chunk;
+	}
+
+	BlockHeader *header = (BlockHeader*)((char*)(chunks_ + 1) + chunks_->used);
+	chunks_->used += size;
+	header->arena = NULL;
+	return header + 1;
+}
+
+void JsArena::Dispose()
+{
+	while (chunks_ != NULL) {
+		Chunk *next = chunks_->next;
+		free(chunks_);
+		chunks_ = next;
+	}
+}
+
+void JsArena::Adopt(void *root)
+{
+	HeaderOf(root)->arena = this;
+}
+
+bool JsArena::Release(void *root)
+{
+	JsArena *arena = HeaderOf(root)->arena;
+	if (arena == NULL)
+		return false;
+	delete arena;
+	return true;
+}
+
+void *JsArena::HeapAlloc(size_t size)
+{
+	BlockHeader *header = (BlockHeader*)malloc(sizeof(BlockHeader) + size);
+	if (header == NULL)
+		return NULL;
+	header->arena = NULL;
+	return header + 1;
+}
+
+void JsArena::HeapFree(void *block)
+{
+	if (block != NULL)
+		free(HeaderOf(block));
+}
+
+JsArenaScope::JsArenaScope(JsEngine *engine) : engine_(engine), arena_(NULL)
+{
+	previous_ = engine->GetArenaScope();
+	engine->SetArenaScope(this);
+}
+
+JsArenaScope::~JsArenaScope()
+{
+	engine_->SetArenaScope(previous_);
+	if (arena_ != NULL)
+		delete arena_;
+}
+
+void *JsArenaScope::Alloc(size_t size)
+{
+	// Created lazily: most results are primitives and never allocate.
+	if (arena_ == NULL)
+		arena_ = JsArena::New();
+	return arena_->Alloc(size);
+}
+
+jsvalue JsArenaScope::Close(jsvalue value)
+{
+	// Flat results are a copy: the arena goes away with the scope.
+	if ((engine_->GetPolicy()->flags & JSPOLICY_FLAT_RESULTS) && (value.type == JSVALUE_TYPE_ARRAY || value.type == JSVALUE_TYPE_DICT || value.type == JSVALUE_TYPE_COLUMNS)) {
+		jsvalue flat = js_flatten(value);
+		if (flat.type == JSVALUE_TYPE_FLAT)
+			return flat;
+	}
+
+	if (arena_ == NULL || value.value.ptr == NULL)
+		return value;
+
+	switch (value.type) {
+		case JSVALUE_TYPE_STRING:
+		case JSVALUE_TYPE_ASCII_STRING:
+		case JSVALUE_TYPE_JSON:
+		case JSVALUE_TYPE_STRING_ERROR:
+		case JSVALUE_TYPE_ARRAY:
+		case JSVALUE_TYPE_INT32_ARRAY:
+		case JSVALUE_TYPE_DOUBLE_ARRAY:
+		case JSVALUE_TYPE_FUNCTION:
+		case JSVALUE_TYPE_DICT:
+		case JSVALUE_TYPE_COLUMNS:
+		case JSVALUE_TYPE_ERROR:
+			arena_->Adopt(value.value.ptr);
+			arena_ = NULL;
+			break;
+	}
+	return value;
+}
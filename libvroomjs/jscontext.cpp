@@ -23,6 +23,7 @@
 // OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
 // THE SOFTWARE.
 
+#include <new>
 #include <vector>
 #include <iostream>
 #include "vroomjs.h"
@@ -43,40 +44,184 @@ JsContext* JsContext::New(int id, JsEngine *engine)
         Isolate::Scope isolate_scope(context->isolate_);
 
 		context->context_ = new Persistent<Context>(Context::New());
+		engine->ContextCreated();
 	}
     return context;
 }
 
+void JsContext::SetPolicy(const jspolicy *policy)
+{
+	if (policy == NULL) {
+		policy_ = &js_default_policy;
+		return;
+	}
+	own_policy_ = *policy;
+	policy_ = &own_policy_;
+}
+
 void JsContext::Dispose()
 {
+	// Only a session of this thread can be ended here: the CLR doesn't
+	// dispose contexts with a session open on another thread, the Locker
+	// below would wait for it forever.
+	if (engine_->GetIsolate() != NULL && Locker::IsLocked(isolate_) && session_depth_ > 0) {
+		session_depth_ = 1;
+		EndSession();
+	}
+
 	if(engine_->GetIsolate() != NULL) {
 		Locker locker(isolate_);
    	 	Isolate::Scope isolate_scope(isolate_);
+		if (reset_check_ != NULL) {
+			reset_check_->Dispose();
+			delete reset_check_;
+		}
 		context_->Dispose();            
     	delete context_;
+		engine_->ContextDisposed();
+	}
+}
+
+void JsContext::CaptureBaseline()
+{
+	HandleScope scope;
+	TryCatch trycatch;
+	(*context_)->Enter();
+
+	Handle<Script> script = engine_->GetResetScript();
+	if (!script.IsEmpty()) {
+		Local<Value> check = script->Run();
+		if (!check.IsEmpty() && check->IsFunction())
+			reset_check_ = new Persistent<Function>(Persistent<Function>::New(Handle<Function>::Cast(check)));
+	}
+
+	(*context_)->Exit();
+}
+
+bool JsContext::Reset()
+{
+	policy_ = &js_default_policy;
+
+	// The context can be replaced below, leaving nothing for a session to
+	// exit. As in Dispose(), only a session of this thread.
+	if (Locker::IsLocked(isolate_) && session_depth_ > 0) {
+		session_depth_ = 1;
+		EndSession();
+	}
+
+	Locker locker(isolate_);
+	Isolate::Scope isolate_scope(isolate_);
+	HandleScope scope;
+
+	if (reset_check_ != NULL) {
+		TryCatch trycatch;
+		(*context_)->Enter();
+
+		// The builtins are as we left them: dropping what was added to the
+		// global leaves nothing of the previous user reachable. ForceDelete
+		// because var and function declarations are DontDelete.
+		Handle<Object> global = (*context_)->Global();
+		Handle<Value> added = (*reset_check_)->Call(global, 0, NULL);
+		bool clean = !added.IsEmpty() && added->IsArray();
+		if (clean) {
+			Handle<Array> names = Handle<Array>::Cast(added);
+			for (uint32_t i = 0; clean && i < names->Length(); i++)
+				clean = global->ForceDelete(names->Get(i));
+		}
+
+		(*context_)->Exit();
+		if (clean)
+			return true;
+
+		reset_check_->Dispose();
+		delete reset_check_;
+		reset_check_ = NULL;
 	}
+
+	// First reset, or the previous user patched a builtin: start over from a
+	// new context and capture its baseline before anybody can touch it.
+	context_->Dispose();
+	delete context_;
+	context_ = new Persistent<Context>(Context::New());
+	CaptureBaseline();
+	return false;
+}
+
+void JsContext::BeginSession()
+{
+	// The session state is only touched with the isolate locked, so it's
+	// ours to read once we know we hold the lock. Only the thread of the
+	// session can while it's active.
+	if (Locker::IsLocked(isolate_) && session_depth_ > 0) {
+		session_depth_++;
+		return;
+	}
+
+	Locker *locker = new Locker(isolate_);
+	isolate_->Enter();
+	(*context_)->Enter();
+	session_locker_ = locker;
+	session_previous_ = engine_->GetEnteredContext();
+	engine_->SetEnteredContext(this);
+	session_depth_ = 1;
 }
 
-jsvalue JsContext::Execute(const uint16_t* str, const uint16_t *resourceName = NULL)
+bool JsContext::EndSession()
+{
+	if (!Locker::IsLocked(isolate_) || session_depth_ == 0)
+		return false;
+	if (--session_depth_ > 0)
+		return true;
+
+	engine_->SetEnteredContext(session_previous_);
+	(*context_)->Exit();
+	isolate_->Exit();
+	Locker *locker = session_locker_;
+	session_locker_ = NULL;
+	delete locker;
+	return true;
+}
+
+JsContextScope::JsContextScope(JsContext *context) : context_(context), entered_(false)
+{
+	// IsLocked() first: the entered context is only ours to read with the
+	// lock held.
+	JsEngine *engine = context->engine_;
+	if (Locker::IsLocked(context->isolate_) && engine->GetEnteredContext() == context)
+		return;
+
+	new (locker_) Locker(context->isolate_);
+	context->isolate_->Enter();
+	(*context->context_)->Enter();
+	previous_ = engine->GetEnteredContext();
+	engine->SetEnteredContext(context);
+	entered_ = true;
+}
+
+JsContextScope::~JsContextScope()
+{
+	if (!entered_)
+		return;
+
+	context_->engine_->SetEnteredContext(previous_);
+	(*context_->context_)->Exit();
+	context_->isolate_->Exit();
+	((Locker*)locker_)->~Locker();
+}
+
+jsvalue JsContext::Execute(const uint16_t* str, const uint16_t *resourceName, int32_t mode, const jspolicy *policy)
 {
     jsvalue v;
 
-    Locker locker(isolate_);
-    Isolate::Scope isolate_scope(isolate_);
-    (*context_)->Enter();
+    JsContextScope context_scope(this);
         
     HandleScope scope;
     TryCatch trycatch;
+    JsPolicyScope policy_scope(engine_, policy != NULL ? policy : policy_);
+    JsArenaScope arena(engine_);
     
-    Handle<String> source = String::New(str);   
-	Handle<Script> script;
-
-	if (resourceName != NULL) {
-		Handle<String> name = String::New(resourceName);
-		script = Script::Compile(source, name);  
-	} else {
-		script = Script::Compile(source);  
-	}
+	// Context independent: Run() binds it to the context we entered above.
+	Handle<Script> script = engine_->GetScriptCache()->Compile(str, resourceName);
 
 	if (!script.IsEmpty()) {
 		Local<Value> result = script->Run();
@@ -84,26 +229,25 @@ jsvalue JsContext::Execute(const uint16_t* str, const uint16_t *resourceName = N
 		if (result.IsEmpty())
             v = engine_->ErrorFromV8(trycatch);
         else
-            v = engine_->AnyFromV8(result);        
+            v = engine_->ResultFromV8(result, mode);        
     }
     else {
         v = engine_->ErrorFromV8(trycatch);
     }
             
-    (*context_)->Exit();
-	return v;     
+	return arena.Close(v);     
 }
 
-jsvalue JsContext::Execute(JsScript *jsscript)
+jsvalue JsContext::Execute(JsScript *jsscript, int32_t mode, const jspolicy *policy)
 {
     jsvalue v;
 
-    Locker locker(isolate_);
-    Isolate::Scope isolate_scope(isolate_);
-    (*context_)->Enter();
+    JsContextScope context_scope(this);
         
     HandleScope scope;
     TryCatch trycatch;
+    JsPolicyScope policy_scope(engine_, policy != NULL ? policy : policy_);
+    JsArenaScope arena(engine_);
    
 	Handle<Script> script = (*jsscript->GetScript());
 
@@ -113,41 +257,105 @@ jsvalue JsContext::Execute(JsScript *jsscript)
 		if (result.IsEmpty())
 			v = engine_->ErrorFromV8(trycatch);
 		else
-			v = engine_->AnyFromV8(result);        
+			v = engine_->ResultFromV8(result, mode);        
 	}
 
-    (*context_)->Exit();
-	return v;     
+	return arena.Close(v);     
 }
 
-jsvalue JsContext::SetVariable(const uint16_t* name, jsvalue value)
+jsvalue JsContext::ExecuteColumns(const uint16_t* str, const uint16_t *resourceName, const uint16_t** names, int32_t count, int32_t mode, const jspolicy *policy)
 {
-    Locker locker(isolate_);
-    Isolate::Scope isolate_scope(isolate_);
-    (*context_)->Enter();
+    jsvalue v;
+
+    JsContextScope context_scope(this);
+
+    HandleScope scope;
+    TryCatch trycatch;
+    JsPolicyScope policy_scope(engine_, policy != NULL ? policy : policy_);
+    JsArenaScope arena(engine_);
+
+    Handle<Script> script = engine_->GetScriptCache()->Compile(str, resourceName);
+
+    if (!script.IsEmpty()) {
+        Local<Value> result = script->Run();
+
+        if (result.IsEmpty()) {
+            v = engine_->ErrorFromV8(trycatch);
+        }
+        else if (mode != JSRESULT_MODE_FULL || !result->IsArray()) {
+            v = engine_->ResultFromV8(result, mode);
+        }
+        else {
+            Handle<Array> keys = Array::New(count);
+            for (int32_t i = 0; i < count; i++)
+                keys->Set(i, String::New(names[i]));
+            JsGraph graph(engine_);
+            if (!engine_->ColumnsFromV8(Handle<Array>::Cast(result), keys, v))
+                v = engine_->ValueFromV8(result);
+            v = graph.Close(v);
+        }
+    }
+    else {
+        v = engine_->ErrorFromV8(trycatch);
+    }
+
+    return arena.Close(v);
+}
+
+// The error for an unknown atom is built in the caller's arena, whatever
+// scope happens to be current: it is part of the caller's result.
+Handle<String> JsContext::NameOf(JsArenaScope &arena, const uint16_t* name, int32_t atom, jsvalue *error)
+{
+    if (name != NULL)
+        return String::New(name);
+
+    Handle<String> key = engine_->GetName(atom);
+    if (key.IsEmpty()) {
+        JsArenaScope *current = engine_->GetArenaScope();
+        engine_->SetArenaScope(&arena);
+        *error = engine_->StringFromV8(String::New("unknown name atom"), false);
+        error->type = JSVALUE_TYPE_STRING_ERROR;
+        engine_->SetArenaScope(current);
+    }
+    return key;
+}
+
+jsvalue JsContext::SetVariable(const uint16_t* name, int32_t atom, jsvalue value)
+{
+    jsvalue error;
+
+    JsContextScope context_scope(this);
         
     HandleScope scope;
+    JsPolicyScope policy_scope(engine_, policy_);
+    // Ours even without results to allocate: called back from managed code
+    // in the middle of another call, the error would otherwise come from
+    // that call's arena.
+    JsArenaScope arena(engine_);
+
+    Handle<String> key = NameOf(arena, name, atom, &error);
+    if (key.IsEmpty()) {
+        return arena.Close(error);
+    }
         
     Handle<Value> v = engine_->AnyToV8(value, id_);
 
-    if ((*context_)->Global()->Set(String::New(name), v) == false) {
+    if ((*context_)->Global()->Set(key, v) == false) {
         // TODO: Return an error if set failed.
     }        
 
-    (*context_)->Exit();
-    
-    return engine_->AnyFromV8(Null());
+    return arena.Close(engine_->AnyFromV8(Null()));
 }
 
 jsvalue JsContext::GetGlobal() {
 	jsvalue v;
     
-    Locker locker(isolate_);
-    Isolate::Scope isolate_scope(isolate_);
-    (*context_)->Enter();
+    JsContextScope context_scope(this);
         
     HandleScope scope;
     TryCatch trycatch;
+    JsPolicyScope policy_scope(engine_, policy_);
+    JsArenaScope arena(engine_);
                 
     Local<Value> value = (*context_)->Global();
     if (!value.IsEmpty()) {
@@ -157,44 +365,140 @@ jsvalue JsContext::GetGlobal() {
         v = engine_->ErrorFromV8(trycatch);
     }
     
-    (*context_)->Exit();
-    
-    return v;
+    return arena.Close(v);
 }
 
-jsvalue JsContext::GetVariable(const uint16_t* name)
+jsvalue JsContext::Convert(Persistent<Object>* obj)
 {
     jsvalue v;
-    
-    Locker locker(isolate_);
-    Isolate::Scope isolate_scope(isolate_);
-    (*context_)->Enter();
-        
+
+    JsContextScope context_scope(this);
+
     HandleScope scope;
     TryCatch trycatch;
-                
-    Local<Value> value = (*context_)->Global()->Get(String::New(name));
+    JsPolicyScope policy_scope(engine_, policy_);
+    JsArenaScope arena(engine_);
+
+    Local<Value> value = *(*obj);
     if (!value.IsEmpty()) {
-        v = engine_->AnyFromV8(value);        
+        // Strings from JSRESULT_MODE_LAZY come back as strings.
+        if (value->IsStringObject())
+            value = Handle<StringObject>::Cast(value)->StringValue();
+        v = engine_->AnyFromV8(value);
     }
     else {
         v = engine_->ErrorFromV8(trycatch);
     }
+
+    return arena.Close(v);
+}
+
+jsvalue JsContext::GetArrayLength(Persistent<Object>* obj)
+{
+    jsvalue v;
+
+    JsContextScope context_scope(this);
+
+    HandleScope scope;
+    JsPolicyScope policy_scope(engine_, policy_);
+    JsArenaScope arena(engine_);
+
+    Local<Value> value = *(*obj);
+    if (value.IsEmpty() || !value->IsArray()) {
+        v = engine_->StringFromV8(String::New("isn't an array"), false);
+        v.type = JSVALUE_TYPE_STRING_ERROR;
+    }
+    else {
+        v = engine_->AnyFromV8(Integer::NewFromUnsigned(Handle<Array>::Cast(value)->Length()));
+    }
+
+    return arena.Close(v);
+}
+
+jsvalue JsContext::GetArrayRange(Persistent<Object>* obj, int32_t start, int32_t count)
+{
+    jsvalue v;
+
+    JsContextScope context_scope(this);
+
+    HandleScope scope;
+    TryCatch trycatch;
+    JsPolicyScope policy_scope(engine_, policy_);
+    JsArenaScope arena(engine_);
+
+    Local<Value> value = *(*obj);
+    if (value.IsEmpty() || !value->IsArray() || start < 0) {
+        v = engine_->StringFromV8(String::New(start < 0 ? "invalid range" : "isn't an array"), false);
+        v.type = JSVALUE_TYPE_STRING_ERROR;
+    }
+    else {
+        // A conversion of its own, as if the range was the whole result.
+        JsGraph graph(engine_);
+        bool packed = (policy_->flags & JSPOLICY_PACKED_ARRAYS) != 0;
+        v = graph.Close(engine_->ArrayFromV8(Handle<Array>::Cast(value), packed, start, count));
+    }
+
+    return arena.Close(v);
+}
+
+jsvalue JsContext::ReadString(Persistent<Object>* obj, int32_t offset, int32_t count)
+{
+    jsvalue v;
+
+    JsContextScope context_scope(this);
+
+    HandleScope scope;
+    JsPolicyScope policy_scope(engine_, policy_);
+    JsArenaScope arena(engine_);
+
+    Local<Value> value = *(*obj);
+    if (value.IsEmpty() || !value->IsStringObject() || offset < 0) {
+        v = engine_->StringFromV8(String::New(offset < 0 ? "invalid range" : "isn't a string"), false);
+        v.type = JSVALUE_TYPE_STRING_ERROR;
+    }
+    else {
+        // Write() copies only the characters asked for, whatever the shape
+        // of the string in V8.
+        v = engine_->StringFromV8(Handle<StringObject>::Cast(value)->StringValue(), true, offset, count);
+    }
+
+    return arena.Close(v);
+}
+
+jsvalue JsContext::GetVariable(const uint16_t* name, int32_t atom)
+{
+    jsvalue v;
     
-    (*context_)->Exit();
+    JsContextScope context_scope(this);
+        
+    HandleScope scope;
+    TryCatch trycatch;
+    JsPolicyScope policy_scope(engine_, policy_);
+    JsArenaScope arena(engine_);
+                
+    Handle<String> key = NameOf(arena, name, atom, &v);
+    if (!key.IsEmpty()) {
+        Local<Value> value = (*context_)->Global()->Get(key);
+        if (!value.IsEmpty()) {
+            v = engine_->AnyFromV8(value);        
+        }
+        else {
+            v = engine_->ErrorFromV8(trycatch);
+        }
+    }
     
-    return v;
+    return arena.Close(v);
 }
 
 jsvalue JsContext::GetPropertyNames(Persistent<Object>* obj) {
 	 jsvalue v;
     
-    Locker locker(isolate_);
-    Isolate::Scope isolate_scope(isolate_);
-    (*context_)->Enter();
+    JsContextScope context_scope(this);
         
     HandleScope scope;
     TryCatch trycatch;
+    JsPolicyScope policy_scope(engine_, policy_);
+    JsArenaScope arena(engine_);
                 
     Local<Value> value = (*obj)->GetPropertyNames();
     if (!value.IsEmpty()) {
@@ -204,76 +508,154 @@ jsvalue JsContext::GetPropertyNames(Persistent<Object>* obj) {
         v = engine_->ErrorFromV8(trycatch);
     }
     
-    (*context_)->Exit();
-    
-    return v;
+    return arena.Close(v);
 }
 
-jsvalue JsContext::GetPropertyValue(Persistent<Object>* obj, const uint16_t* name)
+jsvalue JsContext::GetPropertyValue(Persistent<Object>* obj, const uint16_t* name, int32_t atom)
 {
     jsvalue v;
     
-    Locker locker(isolate_);
-    Isolate::Scope isolate_scope(isolate_);
-    (*context_)->Enter();
+    JsContextScope context_scope(this);
         
     HandleScope scope;
     TryCatch trycatch;
+    JsPolicyScope policy_scope(engine_, policy_);
+    JsArenaScope arena(engine_);
                 
-    Local<Value> value = (*obj)->Get(String::New(name));
-    if (!value.IsEmpty()) {
-        v = engine_->AnyFromV8(value);        
-    }
-    else {
-        v = engine_->ErrorFromV8(trycatch);
+    Handle<String> key = NameOf(arena, name, atom, &v);
+    if (!key.IsEmpty()) {
+        Local<Value> value = (*obj)->Get(key);
+        if (!value.IsEmpty()) {
+            v = engine_->AnyFromV8(value);        
+        }
+        else {
+            v = engine_->ErrorFromV8(trycatch);
+        }
     }
     
-    (*context_)->Exit();
-    
-    return v;
+    return arena.Close(v);
 }
 
 
-jsvalue JsContext::SetPropertyValue(Persistent<Object>* obj, const uint16_t* name, jsvalue value)
+jsvalue JsContext::SetPropertyValue(Persistent<Object>* obj, const uint16_t* name, int32_t atom, jsvalue value)
 {
-    Locker locker(isolate_);
-    Isolate::Scope isolate_scope(isolate_);
-    (*context_)->Enter();
+    jsvalue error;
+
+    JsContextScope context_scope(this);
         
     HandleScope scope;
+    JsPolicyScope policy_scope(engine_, policy_);
+    JsArenaScope arena(engine_);
+
+    Handle<String> key = NameOf(arena, name, atom, &error);
+    if (key.IsEmpty()) {
+        return arena.Close(error);
+    }
         
     Handle<Value> v = engine_->AnyToV8(value, id_);
 
-    if ((*obj)->Set(String::New(name), v) == false) {
+    if ((*obj)->Set(key, v) == false) {
         // TODO: Return an error if set failed.
     }          
     	
-    (*context_)->Exit();
-    
-    return engine_->AnyFromV8(Null());
+    return arena.Close(engine_->AnyFromV8(Null()));
+}
+
+jsvalue JsContext::GetPropertyValues(Persistent<Object>* obj, const uint16_t** names, const int32_t* atoms, int32_t count)
+{
+    jsvalue v;
+
+    JsContextScope context_scope(this);
+        
+    HandleScope scope;
+    TryCatch trycatch;
+    JsPolicyScope policy_scope(engine_, policy_);
+    JsArenaScope arena(engine_);
+
+    v.type = JSVALUE_TYPE_ARRAY;
+    v.length = count;
+    v.value.arr = engine_->AllocArray(count);
+
+    // A getter that throws only fails its own slot.
+    for (int32_t i = 0; i < count; i++) {
+        Handle<String> key = NameOf(arena, names != NULL ? names[i] : NULL, atoms != NULL ? atoms[i] : -1, &v.value.arr[i]);
+        if (key.IsEmpty())
+            continue;
+        Local<Value> value = (*obj)->Get(key);
+        if (!value.IsEmpty()) {
+            v.value.arr[i] = engine_->AnyFromV8(value);
+        }
+        else {
+            v.value.arr[i] = engine_->ErrorFromV8(trycatch);
+            trycatch.Reset();
+        }
+    }
+
+    return arena.Close(v);
 }
 
-jsvalue JsContext::InvokeFunction(Persistent<Function>* func, Persistent<Object>* thisArg, jsvalue args) {
+jsvalue JsContext::SetPropertyValues(Persistent<Object>* obj, const uint16_t** names, const int32_t* atoms, int32_t count, jsvalue values)
+{
+    jsvalue v;
+
+    JsContextScope context_scope(this);
+        
+    HandleScope scope;
+    TryCatch trycatch;
+    JsPolicyScope policy_scope(engine_, policy_);
+    JsArenaScope arena(engine_);
+
+    if (values.type != JSVALUE_TYPE_ARRAY || values.length != count) {
+        v = engine_->StringFromV8(String::New("names and values differ in length"), false);
+        v.type = JSVALUE_TYPE_STRING_ERROR;
+    }
+    else {
+        v.type = JSVALUE_TYPE_ARRAY;
+        v.length = count;
+        v.value.arr = engine_->AllocArray(count);
+
+        for (int32_t i = 0; i < count; i++) {
+            Handle<String> key = NameOf(arena, names != NULL ? names[i] : NULL, atoms != NULL ? atoms[i] : -1, &v.value.arr[i]);
+            if (key.IsEmpty())
+                continue;
+            Handle<Value> value = engine_->AnyToV8(values.value.arr[i], id_);
+            if ((*obj)->Set(key, value)) {
+                v.value.arr[i] = engine_->AnyFromV8(Null());
+            }
+            else {
+                v.value.arr[i] = engine_->ErrorFromV8(trycatch);
+                trycatch.Reset();
+            }
+        }
+    }
+
+    return arena.Close(v);
+}
+
+jsvalue JsContext::InvokeFunction(Persistent<Function>* func, Persistent<Object>* thisArg, jsvalue args, int32_t mode, const jspolicy *policy) {
 	jsvalue v;
 	
-    Locker locker(isolate_);
-    Isolate::Scope isolate_scope(isolate_);
-    (*context_)->Enter();
+    JsContextScope context_scope(this);
         
     HandleScope scope;    
     TryCatch trycatch;
+    JsPolicyScope policy_scope(engine_, policy != NULL ? policy : policy_);
+    JsArenaScope arena(engine_);
   
 	Local<Value> prop = *(*func);
-    if (prop.IsEmpty() || !prop->IsFunction()) {
-        v = engine_->StringFromV8(String::New("isn't a function"));
-        v.type = JSVALUE_TYPE_STRING_ERROR;   
-    }
 	
-	Local<Object> reciever = *(*thisArg);
+	Local<Object> reciever;
+	if (thisArg != NULL) {
+		reciever = *(*thisArg);
+	}
 	if (reciever.IsEmpty()) {
 		reciever = (*context_)->Global();
 	}
 
+    if (prop.IsEmpty() || !prop->IsFunction()) {
+        v = engine_->StringFromV8(String::New("isn't a function"), false);
+        v.type = JSVALUE_TYPE_STRING_ERROR;   
+    }
     else {
         std::vector<Local<Value> > argv(args.length);
         engine_->ArrayToV8Args(args, id_, &argv[0]);
@@ -281,52 +663,227 @@ jsvalue JsContext::InvokeFunction(Persistent<Function>* func, Persistent<Object>
         Local<Function> func = Local<Function>::Cast(prop);
 		Local<Value> value = func->Call(reciever, args.length, &argv[0]);
         if (!value.IsEmpty()) {
-            v = engine_->AnyFromV8(value);        
+            v = engine_->ResultFromV8(value, mode);        
         }
         else {
             v = engine_->ErrorFromV8(trycatch);
         }         
     }
     
-    (*context_)->Exit();
-    
-    return v;
+    return arena.Close(v);
 
 }
 
-jsvalue JsContext::InvokeProperty(Persistent<Object>* obj, const uint16_t* name, jsvalue args)
+jsvalue JsContext::InvokeBatch(Persistent<Function>* func, Persistent<Object>* thisArg, jsvalue argsets)
 {
     jsvalue v;
 
-    Locker locker(isolate_);
-    Isolate::Scope isolate_scope(isolate_);
-    (*context_)->Enter();
+    JsContextScope context_scope(this);
         
     HandleScope scope;    
     TryCatch trycatch;
-        
-    Local<Value> prop = (*obj)->Get(String::New(name));
+    JsPolicyScope policy_scope(engine_, policy_);
+    JsArenaScope arena(engine_);
+
+    Local<Value> prop = *(*func);
+
+    Local<Object> reciever;
+    if (thisArg != NULL) {
+        reciever = *(*thisArg);
+    }
+    if (reciever.IsEmpty()) {
+        reciever = (*context_)->Global();
+    }
+
     if (prop.IsEmpty() || !prop->IsFunction()) {
-        v = engine_->StringFromV8(String::New("property not found or isn't a function"));
+        v = engine_->StringFromV8(String::New("isn't a function"), false);
+        v.type = JSVALUE_TYPE_STRING_ERROR;   
+    }
+    else if (argsets.type != JSVALUE_TYPE_ARRAY) {
+        v = engine_->StringFromV8(String::New("argument sets must be an array"), false);
         v.type = JSVALUE_TYPE_STRING_ERROR;   
     }
     else {
-        std::vector<Local<Value> > argv(args.length);
-        engine_->ArrayToV8Args(args, id_, &argv[0]);
-        // TODO: Check ArrayToV8Args return value (but right now can't fail, right?)                   
-        Local<Function> func = Local<Function>::Cast(prop);
-        Local<Value> value = func->Call(*obj, args.length, &argv[0]);
+        Local<Function> function = Local<Function>::Cast(prop);
+
+        v.type = JSVALUE_TYPE_ARRAY;
+        v.length = argsets.length;
+        v.value.arr = engine_->AllocArray(argsets.length);
+
+        // One argv for all the calls, as large as the longest argument set.
+        int32_t max_argc = 1;
+        for (int32_t i = 0; i < argsets.length; i++) {
+            if (argsets.value.arr[i].type == JSVALUE_TYPE_ARRAY && argsets.value.arr[i].length > max_argc)
+                max_argc = argsets.value.arr[i].length;
+        }
+        std::vector<Handle<Value> > argv(max_argc);
+
+        for (int32_t i = 0; i < argsets.length; i++) {
+            // Let the handles of each call go, or a large batch would keep
+            // all of them alive until the end.
+            HandleScope call_scope;
+
+            int32_t argc = engine_->ArrayToV8Args(argsets.value.arr[i], id_, &argv[0]);
+            if (argc < 0)
+                argc = 0;
+
+            Local<Value> value = function->Call(reciever, argc, &argv[0]);
+            if (!value.IsEmpty()) {
+                v.value.arr[i] = engine_->AnyFromV8(value);
+                continue;
+            }
+
+            v.value.arr[i] = engine_->ErrorFromV8(trycatch);
+            if (!trycatch.CanContinue()) {
+                // Terminated (e.g. timed out): don't run the rest, they all
+                // get the same error.
+                for (int32_t j = i + 1; j < argsets.length; j++)
+                    v.value.arr[j] = engine_->ErrorFromV8(trycatch);
+                break;
+            }
+            trycatch.Reset();
+        }
+    }
+
+    return arena.Close(v);
+}
+
+jsvalue JsContext::GetVariableJson(const uint16_t* name)
+{
+    jsvalue v;
+
+    JsContextScope context_scope(this);
+
+    HandleScope scope;
+    TryCatch trycatch;
+    JsPolicyScope policy_scope(engine_, policy_);
+    JsArenaScope arena(engine_);
+
+    Local<Value> value = (*context_)->Global()->Get(String::New(name));
+    if (!value.IsEmpty()) {
+        v = engine_->JsonFromV8(value, trycatch);
+    }
+    else {
+        v = engine_->ErrorFromV8(trycatch);
+    }
+
+    return arena.Close(v);
+}
+
+jsvalue JsContext::SetVariableJson(const uint16_t* name, const char* json, int32_t length)
+{
+    jsvalue v;
+
+    JsContextScope context_scope(this);
+
+    HandleScope scope;
+    TryCatch trycatch;
+    JsPolicyScope policy_scope(engine_, policy_);
+    JsArenaScope arena(engine_);
+
+    Handle<Value> value = engine_->JsonToV8(json, length);
+    if (!value.IsEmpty() && (*context_)->Global()->Set(String::New(name), value)) {
+        v = engine_->AnyFromV8(Null());
+    }
+    else {
+        v = engine_->ErrorFromV8(trycatch);
+    }
+
+    return arena.Close(v);
+}
+
+jsvalue JsContext::InvokeFunctionJson(Persistent<Function>* func, Persistent<Object>* thisArg, const char* args, int32_t length)
+{
+    jsvalue v;
+
+    JsContextScope context_scope(this);
+
+    HandleScope scope;
+    TryCatch trycatch;
+    JsPolicyScope policy_scope(engine_, policy_);
+    JsArenaScope arena(engine_);
+
+    Local<Value> prop = *(*func);
+
+    Local<Object> reciever;
+    if (thisArg != NULL) {
+        reciever = *(*thisArg);
+    }
+    if (reciever.IsEmpty()) {
+        reciever = (*context_)->Global();
+    }
+
+    Handle<Value> parsed;
+    if (args != NULL)
+        parsed = engine_->JsonToV8(args, length);
+
+    if (prop.IsEmpty() || !prop->IsFunction()) {
+        v = engine_->StringFromV8(String::New("isn't a function"), false);
+        v.type = JSVALUE_TYPE_STRING_ERROR;
+    }
+    else if (args != NULL && parsed.IsEmpty()) {
+        v = engine_->ErrorFromV8(trycatch);
+    }
+    else if (args != NULL && !parsed->IsArray()) {
+        v = engine_->StringFromV8(String::New("arguments aren't a JSON array"), false);
+        v.type = JSVALUE_TYPE_STRING_ERROR;
+    }
+    else {
+        int32_t argc = 0;
+        std::vector<Local<Value> > argv;
+        if (args != NULL) {
+            Local<Array> arr = Local<Array>::Cast(parsed);
+            argc = arr->Length();
+            argv.resize(argc);
+            for (int32_t i = 0; i < argc; i++)
+                argv[i] = arr->Get(i);
+        }
+        Local<Value> value = Local<Function>::Cast(prop)->Call(reciever, argc, argc > 0 ? &argv[0] : NULL);
         if (!value.IsEmpty()) {
-            v = engine_->AnyFromV8(value);        
+            v = engine_->JsonFromV8(value, trycatch);
         }
         else {
             v = engine_->ErrorFromV8(trycatch);
-        }         
+        }
+    }
+
+    return arena.Close(v);
+}
+
+jsvalue JsContext::InvokeProperty(Persistent<Object>* obj, const uint16_t* name, int32_t atom, jsvalue args)
+{
+    jsvalue v;
+
+    JsContextScope context_scope(this);
+        
+    HandleScope scope;    
+    TryCatch trycatch;
+    JsPolicyScope policy_scope(engine_, policy_);
+    JsArenaScope arena(engine_);
+        
+    Handle<String> key = NameOf(arena, name, atom, &v);
+    if (!key.IsEmpty()) {
+        Local<Value> prop = (*obj)->Get(key);
+        if (prop.IsEmpty() || !prop->IsFunction()) {
+            v = engine_->StringFromV8(String::New("property not found or isn't a function"), false);
+            v.type = JSVALUE_TYPE_STRING_ERROR;   
+        }
+        else {
+            std::vector<Local<Value> > argv(args.length);
+            engine_->ArrayToV8Args(args, id_, &argv[0]);
+            // TODO: Check ArrayToV8Args return value (but right now can't fail, right?)                   
+            Local<Function> func = Local<Function>::Cast(prop);
+            Local<Value> value = func->Call(*obj, args.length, &argv[0]);
+            if (!value.IsEmpty()) {
+                v = engine_->AnyFromV8(value);        
+            }
+            else {
+                v = engine_->ErrorFromV8(trycatch);
+            }         
+        }
     }
     
-    (*context_)->Exit();
-    
-    return v;
+    return arena.Close(v);
 }
 
 
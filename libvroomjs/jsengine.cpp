@@ -5,8 +5,6 @@
 
 long js_mem_debug_engine_count;
 
-extern "C" jsvalue CALLINGCONVENTION jsvalue_alloc_array(const int32_t length);
-
 static const int Mega = 1024 * 1024;
 
 
@@ -79,6 +77,92 @@ static Handle<Value> managed_call(const Arguments& args)
     return scope.Close(ref->Invoke(args));
 }
 
+static Handle<Value> managed_index_get(uint32_t index, const AccessorInfo& info)
+{
+#ifdef DEBUG_TRACE_API
+		std::cout << "managed_index_get" << std::endl;
+#endif
+    HandleScope scope;
+    
+    Local<Object> self = info.Holder();
+    Local<External> wrap = Local<External>::Cast(self->GetInternalField(0));
+    ManagedRef* ref = (ManagedRef*)wrap->Value();
+    return scope.Close(ref->GetElement(index));
+}
+
+static Handle<Value> managed_index_set(uint32_t index, Local<Value> value, const AccessorInfo& info)
+{
+#ifdef DEBUG_TRACE_API
+		std::cout << "managed_index_set" << std::endl;
+#endif
+    HandleScope scope;
+    
+    Local<Object> self = info.Holder();
+    Local<External> wrap = Local<External>::Cast(self->GetInternalField(0));
+    ManagedRef* ref = (ManagedRef*)wrap->Value();
+	if (ref == NULL) {
+		Local<Value> result;
+		return scope.Close(result);
+	}
+    return scope.Close(ref->SetElement(index, value));
+}
+
+static Handle<Array> managed_index_enumerate(const AccessorInfo& info) 
+{
+#ifdef DEBUG_TRACE_API
+		std::cout << "managed_index_enumerate" << std::endl;
+#endif
+    HandleScope scope;
+    
+    Local<Object> self = info.Holder();
+    Local<External> wrap = Local<External>::Cast(self->GetInternalField(0));
+    ManagedRef* ref = (ManagedRef*)wrap->Value();
+    return scope.Close(ref->EnumerateElements());
+}
+
+// Accessors and methods of registered types: the callback data is the
+// member index.
+static Handle<Value> managed_member_get(Local<String>, const AccessorInfo& info)
+{
+#ifdef DEBUG_TRACE_API
+		std::cout << "managed_member_get" << std::endl;
+#endif
+    HandleScope scope;
+    
+    Local<Object> self = info.Holder();
+    Local<External> wrap = Local<External>::Cast(self->GetInternalField(0));
+    ManagedRef* ref = (ManagedRef*)wrap->Value();
+    return scope.Close(ref->GetMember(info.Data()->Int32Value()));
+}
+
+static void managed_member_set(Local<String>, Local<Value> value, const AccessorInfo& info)
+{
+#ifdef DEBUG_TRACE_API
+		std::cout << "managed_member_set" << std::endl;
+#endif
+    HandleScope scope;
+    
+    Local<Object> self = info.Holder();
+    Local<External> wrap = Local<External>::Cast(self->GetInternalField(0));
+    ManagedRef* ref = (ManagedRef*)wrap->Value();
+	if (ref != NULL)
+		ref->SetMember(info.Data()->Int32Value(), value);
+}
+
+static Handle<Value> managed_member_call(const Arguments& args)
+{
+#ifdef DEBUG_TRACE_API
+		std::cout << "managed_member_call" << std::endl;
+#endif
+    HandleScope scope;
+    
+    // The signature makes sure Holder() is one of our objects.
+    Local<Object> self = args.Holder();
+    Local<External> wrap = Local<External>::Cast(self->GetInternalField(0));
+    ManagedRef* ref = (ManagedRef*)wrap->Value();
+    return scope.Close(ref->InvokeMember(args.Data()->Int32Value(), args));
+}
+
 Handle<Value> managed_valueof(const Arguments& args) {
 #ifdef DEBUG_TRACE_API
 		std::cout << "managed_valueof" << std::endl;
@@ -91,6 +175,84 @@ Handle<Value> managed_valueof(const Arguments& args) {
 	return scope.Close(ref->GetValueOf());
 }
 
+// Run once in a fresh context, before any user code. Records every object
+// reachable from the global (prototypes, constructors, Math, JSON...) and the
+// builtin methods with their own property descriptors, without changing any
+// of them: scripts see the same builtins as in a new context. The returned
+// function checks nothing moved since, using only the builtins it captured
+// here, and returns the names added to the global (null if anything else changed). It also
+// clears the RegExp statics, the only builtin state not held in properties.
+static const char *reset_script_source =
+	"(function (global) {\n"
+	"  var gopn = Object.getOwnPropertyNames, gopd = Object.getOwnPropertyDescriptor,\n"
+	"      getProto = Object.getPrototypeOf, isExtensible = Object.isExtensible, create = Object.create,\n"
+	"      getTime = Date.prototype.getTime, exec = RegExp.prototype.exec,\n"
+	"      multiline = gopd(RegExp, 'multiline'), empty = /(?:)/;\n"
+	"  var objects = [], protos = [], extensible = [], names = [], descs = [];\n"
+	"  var i, k, n, d, v;\n"
+	"  function same(a, b) { return a === b || (a !== a && b !== b); }\n"
+	"  function timeOf(o) { try { return getTime.call(o); } catch (e) { return undefined; } }\n"
+	"  var globalNames = create(null), dateTime = timeOf(Date.prototype);\n"
+	"  function isObject(v) { return (typeof v === 'object' && v !== null) || typeof v === 'function'; }\n"
+	"  function tracked(o) {\n"
+	"    for (var j = 0; j < objects.length; j++) if (objects[j] === o) return true;\n"
+	"    return false;\n"
+	"  }\n"
+	"  function track(o) { if (isObject(o) && !tracked(o)) objects.push(o); }\n"
+	"  // Object.prototype first: once it is verified, reading a field missing\n"
+	"  // from a descriptor can't end up in a getter added by the user.\n"
+	"  track(Object.prototype); track(Function.prototype); track(Array.prototype); track(global);\n"
+	"  n = gopn(global);\n"
+	"  for (i = 0; i < n.length; i++) {\n"
+	"    globalNames[n[i]] = true;\n"
+	"    d = gopd(global, n[i]);\n"
+	"    if ('value' in d && isObject(d.value)) {\n"
+	"      track(d.value);\n"
+	"      if (typeof d.value === 'function') { v = gopd(d.value, 'prototype'); if (v && 'value' in v) track(v.value); }\n"
+	"    }\n"
+	"  }\n"
+	"  for (k = 0; k < objects.length; k++) {\n"
+	"    var o = objects[k], od = [];\n"
+	"    track(getProto(o));\n"
+	"    n = gopn(o);\n"
+	"    for (i = 0; i < n.length; i++) {\n"
+	"      d = gopd(o, n[i]);\n"
+	"      od.push(d);\n"
+	"      if (o === global) continue;\n"
+	"      var values = 'value' in d ? [d.value] : [d.get, d.set];\n"
+	"      for (var j = 0; j < values.length; j++) {\n"
+	"        v = values[j];\n"
+	"        track(v);\n"
+	"      }\n"
+	"    }\n"
+	"    protos.push(getProto(o)); extensible.push(isExtensible(o)); names.push(n); descs.push(od);\n"
+	"  }\n"
+	"  function changed(d, b) {\n"
+	"    return d === undefined || !same(d.value, b.value) || d.get !== b.get || d.set !== b.set ||\n"
+	"      d.writable !== b.writable || d.enumerable !== b.enumerable || d.configurable !== b.configurable;\n"
+	"  }\n"
+	"  return function () {\n"
+	"    var i, k, o, n, bn, added;\n"
+	"    for (k = 0; k < objects.length; k++) {\n"
+	"      o = objects[k]; bn = names[k];\n"
+	"      if (getProto(o) !== protos[k] || isExtensible(o) !== extensible[k]) return null;\n"
+	"      if (o !== global) {\n"
+	"        n = gopn(o);\n"
+	"        if (n.length !== bn.length) return null;\n"
+	"        for (i = 0; i < n.length; i++) if (n[i] !== bn[i]) return null;\n"
+	"      }\n"
+	"      for (i = 0; i < bn.length; i++) if (changed(gopd(o, bn[i]), descs[k][i])) return null;\n"
+	"    }\n"
+	"    if (!same(timeOf(Date.prototype), dateTime)) return null;\n"
+	"    exec.call(empty, '');\n"
+	"    if (multiline && multiline.set) multiline.set.call(RegExp, false);\n"
+	"    added = [];\n"
+	"    n = gopn(global);\n"
+	"    for (i = 0; i < n.length; i++) if (globalNames[n[i]] !== true) added.push(n[i]);\n"
+	"    return added;\n"
+	"  };\n"
+	"})(this)";
+
 JsEngine* JsEngine::New(int32_t max_young_space = -1, int32_t max_old_space = -1)
 {
 	JsEngine* engine = new JsEngine();
@@ -123,12 +285,20 @@ JsEngine* JsEngine::New(int32_t max_young_space = -1, int32_t max_old_space = -1
 			NULL, 
 			managed_prop_delete, 
 			managed_prop_enumerate);
+        obj_template->SetIndexedPropertyHandler(
+			managed_index_get,
+			managed_index_set,
+			NULL,
+			NULL,
+			managed_index_enumerate);
         obj_template->SetCallAsFunctionHandler(managed_call);
         engine->managed_template_ = new Persistent<FunctionTemplate>(Persistent<FunctionTemplate>::New(fo));
 
 		Persistent<FunctionTemplate> fp = Persistent<FunctionTemplate>::New(FunctionTemplate::New(managed_valueof));
 		engine->valueof_function_template_ = new Persistent<FunctionTemplate>(fp);
 		
+		engine->script_cache_ = JsScriptCache::New(JS_SCRIPT_CACHE_DEFAULT_BUDGET);
+
 		engine->global_context_ = new Persistent<Context>(Context::New());
 		(*engine->global_context_)->Enter();
 
@@ -139,6 +309,89 @@ JsEngine* JsEngine::New(int32_t max_young_space = -1, int32_t max_old_space = -1
 	return engine;
 }
 
+int32_t JsEngine::RegisterType(const uint16_t **names, const int32_t *kinds, int32_t count)
+{
+	Locker locker(isolate_);
+	Isolate::Scope isolate_scope(isolate_);
+	HandleScope scope;
+
+	Handle<FunctionTemplate> fo = FunctionTemplate::New(NULL);
+	Handle<ObjectTemplate> obj_template = fo->InstanceTemplate();
+	obj_template->SetInternalFieldCount(1);
+	obj_template->SetIndexedPropertyHandler(managed_index_get, managed_index_set, NULL, NULL, managed_index_enumerate);
+	obj_template->SetCallAsFunctionHandler(managed_call);
+
+	Handle<ObjectTemplate> proto = fo->PrototypeTemplate();
+	proto->Set(String::NewSymbol("valueOf"), *valueof_function_template_);
+	Handle<Signature> signature = Signature::New(fo);
+
+	// Accessors on the instance template end up in the map of every object,
+	// so all the objects of a type share a hidden class and the inline
+	// caches see a plain property instead of an interceptor.
+	for (int32_t i = 0; i < count; i++) {
+		Handle<String> name = String::New(names[i]);
+		Handle<Integer> member = Integer::New(i);
+		if (kinds[i] & JSMEMBER_KIND_METHOD) {
+			proto->Set(name, FunctionTemplate::New(managed_member_call, member, signature));
+		}
+		else {
+			obj_template->SetAccessor(name,
+				managed_member_get,
+				(kinds[i] & JSMEMBER_KIND_SET) ? managed_member_set : NULL,
+				member,
+				DEFAULT,
+				DontDelete);
+		}
+	}
+
+	type_templates_.push_back(Persistent<FunctionTemplate>::New(fo));
+	return (int32_t)type_templates_.size();
+}
+
+int32_t JsEngine::LookupMember(int32_t type_key, const uint16_t *name, int32_t length)
+{
+	uint64_t hash = js_hash_units(name, length, (uint64_t)type_key);
+	std::pair<std::unordered_multimap<uint64_t, MemberCacheEntry>::iterator,
+		std::unordered_multimap<uint64_t, MemberCacheEntry>::iterator> range = member_cache_.equal_range(hash);
+	for (std::unordered_multimap<uint64_t, MemberCacheEntry>::iterator it = range.first; it != range.second; ++it) {
+		const MemberCacheEntry &entry = it->second;
+		if (entry.type_key == type_key && entry.name.size() == (size_t)length &&
+			(length == 0 || memcmp(&entry.name[0], name, length * sizeof(uint16_t)) == 0)) {
+			member_cache_hits_++;
+			return entry.result;
+		}
+	}
+	member_cache_misses_++;
+	return -1;
+}
+
+void JsEngine::StoreMember(int32_t type_key, const uint16_t *name, int32_t length, int32_t result)
+{
+	if (member_cache_.size() >= JS_MEMBER_CACHE_MAX_ENTRIES)
+		return;
+
+	MemberCacheEntry entry;
+	entry.type_key = type_key;
+	entry.result = result;
+	entry.name.assign(name, name + length);
+	member_cache_.insert(std::make_pair(js_hash_units(name, length, (uint64_t)type_key), entry));
+}
+
+void JsEngine::GetMemberCacheStats(jsmembercache_stats *stats)
+{
+	Locker locker(isolate_);
+	stats->hits = member_cache_hits_;
+	stats->misses = member_cache_misses_;
+	stats->entries = (int64_t)member_cache_.size();
+}
+
+void JsEngine::DisposeTypes()
+{
+	for (size_t i = 0; i < type_templates_.size(); i++)
+		type_templates_[i].Dispose();
+	type_templates_.clear();
+}
+
 Persistent<Script> *JsEngine::CompileScript(const uint16_t* str, const uint16_t *resourceName, jsvalue *error) {
 	Locker locker(isolate_);
 	Isolate::Scope isolate_scope(isolate_);
@@ -151,15 +404,22 @@ Persistent<Script> *JsEngine::CompileScript(const uint16_t* str, const uint16_t
 	Handle<String> source = String::New(str);
 	Handle<Script> script;
 
+	JsPrecompiledData *pre = NULL;
+	if (precompile_cache_ != NULL)
+		pre = precompile_cache_->Get(source, str, source->Length());
+	ScriptData *pre_data = pre != NULL ? pre->GetData() : NULL;
+
 	if (resourceName != NULL) {
-		Handle<String> name = String::New(resourceName);
-		script = Script::New(source, name);  
+		ScriptOrigin origin(String::New(resourceName));
+		script = Script::New(source, &origin, pre_data);  
 	} else {
-		script = Script::New(source);  
+		script = Script::New(source, NULL, pre_data);  
 	}
+	delete pre;
 
 	if (script.IsEmpty()) {
-		*error = ErrorFromV8(trycatch);
+		JsArenaScope arena(this);
+		*error = arena.Close(ErrorFromV8(trycatch));
 	}
 	
 	(*global_context_)->Exit();
@@ -169,6 +429,61 @@ Persistent<Script> *JsEngine::CompileScript(const uint16_t* str, const uint16_t
 	return pScript;
 }
 
+void JsEngine::SetPrecompileCache(const uint16_t *directory)
+{
+	// Not while a script is being compiled.
+	Locker locker(isolate_);
+	delete precompile_cache_;
+	precompile_cache_ = directory != NULL ? JsPrecompileCache::New(directory) : NULL;
+}
+
+int32_t JsEngine::InternName(const uint16_t *name)
+{
+	Locker locker(isolate_);
+	Isolate::Scope isolate_scope(isolate_);
+	HandleScope scope;
+
+	size_t length = 0;
+	while (name[length] != 0)
+		length++;
+	uint64_t hash = js_hash_units(name, length, 0);
+
+	Local<String> str = String::New(name, (int)length);
+	std::pair<std::unordered_multimap<uint64_t, int32_t>::iterator,
+		std::unordered_multimap<uint64_t, int32_t>::iterator> range = name_index_.equal_range(hash);
+	for (std::unordered_multimap<uint64_t, int32_t>::iterator it = range.first; it != range.second; ++it) {
+		if (names_[it->second]->StrictEquals(str))
+			return it->second;
+	}
+
+	// Symbols are what V8 keys its property maps with, so lookups with them
+	// skip both the hashing and the symbol table probe. NewSymbol() only
+	// takes UTF-8; a name that doesn't survive the trip (lone surrogates)
+	// is kept as a plain string.
+	int utf8_length = str->Utf8Length();
+	std::vector<char> utf8(utf8_length + 1);
+	str->WriteUtf8(&utf8[0], utf8_length + 1);
+	Local<String> symbol = String::NewSymbol(&utf8[0], utf8_length);
+	if (!symbol->StrictEquals(str))
+		symbol = str;
+
+	int32_t atom = (int32_t)names_.size();
+	names_.push_back(Persistent<String>::New(symbol));
+	name_index_.insert(std::make_pair(hash, atom));
+	return atom;
+}
+
+Handle<Script> JsEngine::GetResetScript()
+{
+	// Compiled once per engine, context independent like CompileScript().
+	if (reset_script_ == NULL) {
+		Handle<Script> script = Script::New(String::New(reset_script_source));
+		if (script.IsEmpty())
+			return script;
+		reset_script_ = new Persistent<Script>(Persistent<Script>::New(script));
+	}
+	return *reset_script_;
+}
 
 void JsEngine::TerminateExecution() 
 {
@@ -205,6 +520,24 @@ void JsEngine::Dispose()
 		delete valueof_function_template_;
 		valueof_function_template_ = NULL;
 
+		delete script_cache_;
+		script_cache_ = NULL;
+		delete precompile_cache_;
+		precompile_cache_ = NULL;
+
+		DisposeTypes();
+
+		for (size_t i = 0; i < names_.size(); i++)
+			names_[i].Dispose();
+		names_.clear();
+		name_index_.clear();
+
+		if (reset_script_ != NULL) {
+			reset_script_->Dispose();
+			delete reset_script_;
+			reset_script_ = NULL;
+		}
+
 		global_context_->Dispose();            
     	delete global_context_;
 		global_context_ = NULL;
@@ -219,7 +552,59 @@ void JsEngine::Dispose()
 		keepalive_invoke_ = NULL;
 		keepalive_delete_property_ = NULL;
 		keepalive_enumerate_properties_ = NULL;
+		keepalive_get_member_ = NULL;
+		keepalive_set_member_ = NULL;
+		keepalive_invoke_member_ = NULL;
+		keepalive_indexed_ = NULL;
+		keepalive_release_buffer_ = NULL;
+		keepalive_missing_property_ = NULL;
+	}
+}
+
+bool JsEngine::Reset()
+{
+	// From now on ManagedRef destructors don't call into the previous owner.
+	keepalive_remove_ = NULL;
+	keepalive_get_property_value_ = NULL;
+	keepalive_set_property_value_ = NULL;
+	keepalive_valueof_ = NULL;
+	keepalive_invoke_ = NULL;
+	keepalive_delete_property_ = NULL;
+	keepalive_enumerate_properties_ = NULL;
+	keepalive_get_member_ = NULL;
+	keepalive_set_member_ = NULL;
+	keepalive_invoke_member_ = NULL;
+	keepalive_indexed_ = NULL;
+	keepalive_release_buffer_ = NULL;
+	keepalive_missing_property_ = NULL;
+
+	Locker locker(isolate_);
+	Isolate::Scope isolate_scope(isolate_);
+
+	// Full GC: the weak callbacks delete the ManagedRefs no longer reachable.
+	while(!V8::IdleNotification()) {};
+
+	// A TerminateExecution() that arrived after the last script completed is
+	// still pending: let it hit a throwaway script instead of the next owner.
+	{
+		HandleScope scope;
+		TryCatch trycatch;
+		(*global_context_)->Enter();
+		Handle<Script> script = Script::Compile(String::New("void 0"));
+		if (!script.IsEmpty())
+			script->Run();
+		(*global_context_)->Exit();
 	}
+
+	if (context_count_ != 0 || managed_ref_count_ != 0)
+		return false;
+
+	// Type ids and keys only mean something to the owner that handed them out.
+	DisposeTypes();
+	member_cache_.clear();
+	member_cache_hits_ = 0;
+	member_cache_misses_ = 0;
+	return true;
 }
 
 void JsEngine::DisposeObject(Persistent<Object>* obj)
@@ -230,6 +615,54 @@ void JsEngine::DisposeObject(Persistent<Object>* obj)
 	obj->Dispose(isolate_);
 }
 
+jsvalue *JsEngine::AllocArray(int32_t length)
+{
+	if (arena_scope_ != NULL)
+		return (jsvalue*)arena_scope_->Alloc(length * sizeof(jsvalue));
+	return (jsvalue*)JsArena::HeapAlloc(length * sizeof(jsvalue));
+}
+
+uint16_t *JsEngine::AllocString(int32_t length)
+{
+	if (arena_scope_ != NULL)
+		return (uint16_t*)arena_scope_->Alloc((length + 1) * sizeof(uint16_t));
+	return (uint16_t*)JsArena::HeapAlloc((length + 1) * sizeof(uint16_t));
+}
+
+uint8_t *JsEngine::AllocAsciiString(int32_t length)
+{
+	if (arena_scope_ != NULL)
+		return (uint8_t*)arena_scope_->Alloc(length + 1);
+	return (uint8_t*)JsArena::HeapAlloc(length + 1);
+}
+
+void *JsEngine::AllocPacked(int32_t length, size_t element_size)
+{
+	size_t size = length * element_size;
+	if (arena_scope_ != NULL)
+		return arena_scope_->Alloc(size);
+	return JsArena::HeapAlloc(size);
+}
+
+void JsEngine::FreePacked(void *elements)
+{
+	// Arena allocations go away with the arena.
+	if (arena_scope_ == NULL)
+		JsArena::HeapFree(elements);
+}
+
+jserror *JsEngine::AllocError()
+{
+	jserror *error;
+	if (arena_scope_ != NULL)
+		error = (jserror*)arena_scope_->Alloc(sizeof(jserror));
+	else
+		error = (jserror*)JsArena::HeapAlloc(sizeof(jserror));
+	if (error != NULL)
+		memset(error, 0, sizeof(jserror));
+	return error;
+}
+
 jsvalue JsEngine::ErrorFromV8(TryCatch& trycatch)
 {
     jsvalue v;
@@ -257,8 +690,7 @@ jsvalue JsEngine::ErrorFromV8(TryCatch& trycatch)
 		}
 	}
 
-	jserror *error = new jserror();
-	memset(error, 0, sizeof(jserror));
+	jserror *error = AllocError();
 	
 	Local<Message> message = trycatch.Message();
 
@@ -280,26 +712,130 @@ jsvalue JsEngine::ErrorFromV8(TryCatch& trycatch)
 	return v;
 }
     
-jsvalue JsEngine::StringFromV8(Handle<Value> value)
+jsvalue JsEngine::StringFromV8(Handle<Value> value, bool compact, int32_t start, int32_t count)
 {
     jsvalue v;
     
     Local<String> s = value->ToString();
-    v.length = s->Length();
-    v.value.str = new uint16_t[v.length+1];
+    int32_t length = s->Length();
+    if (start < 0)
+        start = 0;
+    if (start > length)
+        start = length;
+    if (count < 0 || count > length - start)
+        count = length - start;
+
+    // What the caller gets if the allocation below fails.
+    v.type = JSVALUE_TYPE_UNKNOWN_ERROR;
+    v.value.str = 0;
+    v.length = count;
+    compact = compact && (policy_->flags & JSPOLICY_COMPACT_STRINGS) != 0;
+
+    // Strings V8 knows to be ASCII are written out directly as bytes. Write
+    // only terminates them when it can fit the whole string.
+    if (compact && !s->MayContainNonAscii()) {
+        uint8_t *str = AllocAsciiString(v.length);
+        if (str != NULL) {
+            s->WriteAscii((char*)str, start, count, String::PRESERVE_ASCII_NULL);
+            str[v.length] = '\0';
+            v.type = JSVALUE_TYPE_ASCII_STRING;
+            v.value.ptr = str;
+        }
+        return v;
+    }
+
+    v.value.str = AllocString(v.length);
     if (v.value.str != NULL) {
-        s->Write(v.value.str);
+        s->Write(v.value.str, start, count);
+        v.value.str[v.length] = 0;
         v.type = JSVALUE_TYPE_STRING;
+
+        // The V8 flag is only a hint (e.g., for cons strings) so look at the
+        // characters too and narrow them in place if possible.
+        if (compact && js_is_ascii(v.value.str, v.length)) {
+            uint8_t *str = (uint8_t*)v.value.str;
+            js_narrow_ascii(v.value.str, v.length, str);
+            str[v.length] = '\0';
+            v.type = JSVALUE_TYPE_ASCII_STRING;
+        }
     }
 
     return v;
 }   
 
+// Looked up every time: scripts can replace them and Reset() can give us a
+// new global. Empty if there is no such function.
+static Handle<Function> json_function(Handle<Object> *json, const char *name)
+{
+    Local<Value> value = Context::GetCurrent()->Global()->Get(String::NewSymbol("JSON"));
+    if (value.IsEmpty() || !value->IsObject())
+        return Handle<Function>();
+    *json = value->ToObject();
+    Local<Value> func = (*json)->Get(String::NewSymbol(name));
+    if (func.IsEmpty() || !func->IsFunction())
+        return Handle<Function>();
+    return Handle<Function>::Cast(func);
+}
+
+jsvalue JsEngine::JsonFromV8(Handle<Value> value, TryCatch& trycatch)
+{
+    jsvalue v;
+
+    Handle<Object> json;
+    Handle<Function> stringify = json_function(&json, "stringify");
+    if (stringify.IsEmpty()) {
+        v = StringFromV8(String::New("JSON.stringify isn't a function"), false);
+        v.type = JSVALUE_TYPE_STRING_ERROR;
+        return v;
+    }
+
+    Handle<Value> argv[] = { value };
+    Local<Value> text = stringify->Call(json, 1, argv);
+    if (text.IsEmpty())
+        return ErrorFromV8(trycatch);
+    if (!text->IsString())
+        return AnyFromV8(Null());
+
+    Local<String> s = text->ToString();
+    v.length = s->Utf8Length();
+    // Same layout as an ASCII string: the bytes and a terminator.
+    v.value.ptr = AllocAsciiString(v.length);
+    if (v.value.ptr == NULL) {
+        v.type = JSVALUE_TYPE_UNKNOWN_ERROR;
+        return v;
+    }
+    s->WriteUtf8((char*)v.value.ptr, v.length + 1);
+    v.type = JSVALUE_TYPE_JSON;
+    return v;
+}
+
+Handle<Value> JsEngine::JsonToV8(const char* json, int32_t length)
+{
+    Handle<Object> obj;
+    Handle<Function> parse = json_function(&obj, "parse");
+    if (parse.IsEmpty()) {
+        ThrowException(Exception::TypeError(String::New("JSON.parse isn't a function")));
+        return Handle<Value>();
+    }
+
+    Handle<Value> argv[] = { String::New(json, length) };
+    return parse->Call(obj, 1, argv);
+}
+
+static jsvalue reference_to(void *ptr)
+{
+    jsvalue v;
+    v.type = JSVALUE_TYPE_REFERENCE;
+    v.length = 0;
+    v.value.ptr = ptr;
+    return v;
+}
+
 jsvalue JsEngine::WrappedFromV8(Handle<Object> obj)
 {
     jsvalue v;
        
-	if (js_object_marshal_type == JSOBJECT_MARSHAL_TYPE_DYNAMIC) {
+	if (policy_->object_marshal_type == JSOBJECT_MARSHAL_TYPE_DYNAMIC) {
 		v.type = JSVALUE_TYPE_WRAPPED;
 		v.length = 0;
         // A Persistent<Object> is exactly the size of an IntPtr, right?
@@ -308,17 +844,25 @@ jsvalue JsEngine::WrappedFromV8(Handle<Object> obj)
 		// it in a union: going scary and scarier here.    
 		v.value.ptr = new Persistent<Object>(Persistent<Object>::New(obj));
 	} else {
+		void *seen = graph_->Find(obj);
+		if (seen != NULL)
+			return reference_to(seen);
 		v.type = JSVALUE_TYPE_DICT;
 		Local<Array> names = obj->GetOwnPropertyNames();
 		v.length = names->Length();
-		jsvalue* values = new jsvalue[v.length * 2];
+		jsvalue* values = AllocArray(v.length * 2);
 		if (values != NULL) {
+			// Empty ones can't be part of a cycle and aren't worth sharing.
+			if (v.length > 0 && !graph_->Enter(obj, values))
+				v.length = 0;
 			for(int i = 0; i < v.length; i++) {
 				int indx = (i * 2);
 				Local<Value> key = names->Get(i);
-				values[indx] = AnyFromV8(key);
-				values[indx+1] = AnyFromV8(obj->Get(key));
+				values[indx] = ValueFromV8(key);
+				values[indx+1] = ValueFromV8(obj->Get(key));
 			}
+			if (v.length > 0)
+				graph_->Leave();
 			v.value.arr = values;
 		}
 	}
@@ -339,7 +883,261 @@ jsvalue JsEngine::ManagedFromV8(Handle<Object> obj)
     return v;
 }
     
+// Hidden value marking the objects made by BufferToV8, whose memory is a
+// pinned CLR array.
+static const char *BufferMarker = "vroomjs::buffer";
+
+template <typename T, typename U>
+static void widen(const T *src, U *dst, int32_t length)
+{
+	for (int32_t i = 0; i < length; i++)
+		dst[i] = (U)src[i];
+}
+
+// Buffer jsvalue types and the external arrays V8 knows them as.
+static bool buffer_kind(int32_t type, ExternalArrayType *kind, int32_t *element_size)
+{
+	switch (type) {
+		case JSVALUE_TYPE_INT8_BUFFER: *kind = kExternalByteArray; *element_size = 1; return true;
+		case JSVALUE_TYPE_UINT8_BUFFER: *kind = kExternalUnsignedByteArray; *element_size = 1; return true;
+		case JSVALUE_TYPE_INT16_BUFFER: *kind = kExternalShortArray; *element_size = 2; return true;
+		case JSVALUE_TYPE_UINT16_BUFFER: *kind = kExternalUnsignedShortArray; *element_size = 2; return true;
+		case JSVALUE_TYPE_INT32_BUFFER: *kind = kExternalIntArray; *element_size = 4; return true;
+		case JSVALUE_TYPE_UINT32_BUFFER: *kind = kExternalUnsignedIntArray; *element_size = 4; return true;
+		case JSVALUE_TYPE_FLOAT_BUFFER: *kind = kExternalFloatArray; *element_size = 4; return true;
+		case JSVALUE_TYPE_DOUBLE_BUFFER: *kind = kExternalDoubleArray; *element_size = 8; return true;
+	}
+	return false;
+}
+
+jsvalue JsEngine::BufferFromV8(Handle<Object> obj)
+{
+    jsvalue v;
+
+    ExternalArrayType kind = obj->GetIndexedPropertiesExternalArrayDataType();
+    int32_t length = obj->GetIndexedPropertiesExternalArrayDataLength();
+    void *data = obj->GetIndexedPropertiesExternalArrayData();
+
+    // Memory owned by V8 can go away with the object: copied as a packed
+    // array, integers up to 32 bits as int32_t and the rest as doubles.
+    if (obj->GetHiddenValue(String::NewSymbol(BufferMarker)).IsEmpty()) {
+        bool ints = kind != kExternalUnsignedIntArray && kind != kExternalFloatArray && kind != kExternalDoubleArray;
+        v.type = ints ? JSVALUE_TYPE_INT32_ARRAY : JSVALUE_TYPE_DOUBLE_ARRAY;
+        v.length = length;
+        v.value.ptr = AllocPacked(length, ints ? sizeof(int32_t) : sizeof(double));
+        if (v.value.ptr == NULL) {
+            v.type = JSVALUE_TYPE_UNKNOWN_ERROR;
+            return v;
+        }
+        switch (kind) {
+            case kExternalByteArray: widen((int8_t*)data, (int32_t*)v.value.ptr, length); break;
+            case kExternalShortArray: widen((int16_t*)data, (int32_t*)v.value.ptr, length); break;
+            case kExternalUnsignedShortArray: widen((uint16_t*)data, (int32_t*)v.value.ptr, length); break;
+            case kExternalIntArray: memcpy(v.value.ptr, data, length * sizeof(int32_t)); break;
+            case kExternalUnsignedIntArray: widen((uint32_t*)data, (double*)v.value.ptr, length); break;
+            case kExternalFloatArray: widen((float*)data, (double*)v.value.ptr, length); break;
+            case kExternalDoubleArray: memcpy(v.value.ptr, data, length * sizeof(double)); break;
+            default: widen((uint8_t*)data, (int32_t*)v.value.ptr, length); break;
+        }
+        return v;
+    }
+
+    // One of ours: the CLR maps it back to its array.
+    switch (kind) {
+        case kExternalByteArray: v.type = JSVALUE_TYPE_INT8_BUFFER; break;
+        case kExternalShortArray: v.type = JSVALUE_TYPE_INT16_BUFFER; break;
+        case kExternalUnsignedShortArray: v.type = JSVALUE_TYPE_UINT16_BUFFER; break;
+        case kExternalIntArray: v.type = JSVALUE_TYPE_INT32_BUFFER; break;
+        case kExternalUnsignedIntArray: v.type = JSVALUE_TYPE_UINT32_BUFFER; break;
+        case kExternalFloatArray: v.type = JSVALUE_TYPE_FLOAT_BUFFER; break;
+        case kExternalDoubleArray: v.type = JSVALUE_TYPE_DOUBLE_BUFFER; break;
+        default: v.type = JSVALUE_TYPE_UINT8_BUFFER; break;
+    }
+    v.length = length;
+    v.value.ptr = data;
+
+    return v;
+}
+
+// Arrays of numbers only, as int32_t elements as long as they all fit and as
+// doubles from the first that doesn't. False, and nothing allocated, for any
+// other array.
+bool JsEngine::PackedFromV8(Handle<Array> array, jsvalue &v, uint32_t start)
+{
+    int32_t length = v.length;
+    if (length == 0 || !array->Get(start)->IsNumber())
+        return false;
+
+    int32_t *ints = (int32_t*)AllocPacked(length, sizeof(int32_t));
+    double *doubles = NULL;
+    if (ints == NULL)
+        return false;
+
+    for (int32_t i = 0; i < length; i++) {
+        Local<Value> element = array->Get(start + i);
+        if (doubles == NULL && element->IsInt32()) {
+            ints[i] = element->Int32Value();
+            continue;
+        }
+        if (!element->IsNumber()) {
+            FreePacked(doubles != NULL ? (void*)doubles : (void*)ints);
+            return false;
+        }
+        if (doubles == NULL) {
+            doubles = (double*)AllocPacked(length, sizeof(double));
+            if (doubles == NULL) {
+                FreePacked(ints);
+                return false;
+            }
+            widen(ints, doubles, i);
+            FreePacked(ints);
+        }
+        doubles[i] = element->NumberValue();
+    }
+
+    if (doubles != NULL) {
+        v.type = JSVALUE_TYPE_DOUBLE_ARRAY;
+        v.value.ptr = doubles;
+    } else {
+        v.type = JSVALUE_TYPE_INT32_ARRAY;
+        v.value.ptr = ints;
+    }
+    return true;
+}
+
+jsvalue JsEngine::ArrayFromV8(Handle<Array> array, bool packed, uint32_t start, int32_t count)
+{
+    jsvalue v;
+
+    uint32_t length = array->Length();
+    if (start > length)
+        start = length;
+    if (count < 0 || (uint32_t)count > length - start)
+        count = length - start;
+    v.type = JSVALUE_TYPE_UNKNOWN_ERROR;
+    v.length = count;
+    v.value.ptr = NULL;
+
+    if (packed && PackedFromV8(array, v, start))
+        return v;
+
+    jsvalue* elements = AllocArray(v.length);
+    if (elements != NULL) {
+        if (v.length > 0 && !graph_->Enter(array, elements))
+            v.length = 0;
+        for(int i = 0; i < v.length; i++) {
+            elements[i] = ValueFromV8(array->Get(start + i));
+        }
+        if (v.length > 0)
+            graph_->Leave();
+        v.type = JSVALUE_TYPE_ARRAY;
+        v.value.arr = elements;
+    }
+    return v;
+}
+
+// Objects that would be converted by WrappedFromV8.
+static bool is_record(Handle<Value> value)
+{
+    if (!value->IsObject() || value->IsArray() || value->IsFunction() || value->IsDate())
+        return false;
+    Handle<Object> obj = Handle<Object>::Cast(value);
+    return obj->InternalFieldCount() == 0 && !obj->HasIndexedPropertiesInExternalArrayData();
+}
+
+static bool same_names(Handle<Array> a, Handle<Array> b)
+{
+    uint32_t length = a->Length();
+    if (b->Length() != length)
+        return false;
+    for (uint32_t i = 0; i < length; i++) {
+        if (!a->Get(i)->StrictEquals(b->Get(i)))
+            return false;
+    }
+    return true;
+}
+
+bool JsEngine::ColumnsFromV8(Handle<Array> rows, Handle<Array> names, jsvalue &v)
+{
+    int32_t count = rows->Length();
+    bool declared = !names.IsEmpty();
+    // A single row has nothing to share.
+    if (!declared && count < 2)
+        return false;
+
+    std::vector<Local<Object> > objects(count);
+    for (int32_t i = 0; i < count; i++) {
+        Local<Value> row = rows->Get(i);
+        if (!is_record(row))
+            return false;
+        objects[i] = Local<Object>::Cast(row);
+        if (declared)
+            continue;
+        if (i == 0) {
+            names = objects[0]->GetOwnPropertyNames();
+            if (names->Length() == 0)
+                return false;
+        }
+        else if (!same_names(names, objects[i]->GetOwnPropertyNames())) {
+            return false;
+        }
+    }
+
+    int32_t fields = names->Length();
+    jsvalue *keys = AllocArray(fields);
+    if (keys == NULL)
+        return false;
+    jsvalue *columns = AllocArray(fields + 1);
+    if (columns == NULL || !graph_->Enter(rows, columns)) {
+        if (arena_scope_ == NULL) {
+            JsArena::HeapFree(keys);
+            JsArena::HeapFree(columns);
+        }
+        return false;
+    }
+
+    // The keys as strings, whatever GetOwnPropertyNames gave us. Nodes of
+    // the graph like any other string, within the same limits.
+    for (int32_t f = 0; f < fields; f++)
+        keys[f] = ValueFromV8(names->Get(f)->ToString());
+    columns[0].type = JSVALUE_TYPE_ARRAY;
+    columns[0].length = fields;
+    columns[0].value.arr = keys;
+
+    // No HandleScope per column: the graph holds on to the objects met.
+    for (int32_t f = 0; f < fields; f++) {
+        Local<Value> key = names->Get(f);
+        Local<Array> column = Array::New(count);
+        for (int32_t i = 0; i < count; i++)
+            column->Set(i, objects[i]->Get(key));
+        columns[f + 1] = ArrayFromV8(column, true);
+    }
+    graph_->Leave();
+
+    v.type = JSVALUE_TYPE_COLUMNS;
+    v.length = count;
+    v.value.arr = columns;
+    return true;
+}
+
+JsPolicyScope::JsPolicyScope(JsEngine *engine, const jspolicy *policy) : engine_(engine)
+{
+	previous_ = engine->GetPolicy();
+	engine->SetPolicy(policy);
+}
+
+JsPolicyScope::~JsPolicyScope()
+{
+	engine_->SetPolicy(previous_);
+}
+
 jsvalue JsEngine::AnyFromV8(Handle<Value> value, Handle<Object> thisArg)
+{
+    JsGraph graph(this);
+    return graph.Close(ValueFromV8(value, thisArg));
+}
+
+jsvalue JsEngine::ValueFromV8(Handle<Value> value, Handle<Object> thisArg)
 {
     jsvalue v;
     
@@ -348,6 +1146,12 @@ jsvalue JsEngine::AnyFromV8(Handle<Value> value, Handle<Object> thisArg)
     v.length = 0;
     v.value.str = 0;
     
+    // Past a limit: the whole result is dropped, see JsGraph::Close().
+    if (!graph_->Count()) {
+        v.type = JSVALUE_TYPE_NULL;
+        return v;
+    }
+
     if (value->IsNull() || value->IsUndefined()) {
         v.type = JSVALUE_TYPE_NULL;
     }                
@@ -368,7 +1172,10 @@ jsvalue JsEngine::AnyFromV8(Handle<Value> value, Handle<Object> thisArg)
         v.value.num = value->NumberValue();
     }
     else if (value->IsString()) {
-        v = StringFromV8(value);
+        if (graph_->Fits(Handle<String>::Cast(value)->Length()))
+            v = StringFromV8(value);
+        else
+            v.type = JSVALUE_TYPE_NULL;
     }
     else if (value->IsDate()) {
         v.type = JSVALUE_TYPE_DATE;
@@ -376,19 +1183,17 @@ jsvalue JsEngine::AnyFromV8(Handle<Value> value, Handle<Object> thisArg)
     }
     else if (value->IsArray()) {
         Handle<Array> object = Handle<Array>::Cast(value->ToObject());
-        v.length = object->Length();
-        jsvalue* array = new jsvalue[v.length];
-        if (array != NULL) {
-            for(int i = 0; i < v.length; i++) {
-                array[i] = AnyFromV8(object->Get(i));
-            }
-            v.type = JSVALUE_TYPE_ARRAY;
-            v.value.arr = array;
-        }
+        // Columns only make sense if the rows would have been dictionaries.
+        bool columns = (policy_->flags & JSPOLICY_COLUMNAR_RESULTS) && policy_->object_marshal_type == JSOBJECT_MARSHAL_TYPE_DICTIONARY;
+        void *seen = graph_->Find(object);
+        if (seen != NULL)
+            v = reference_to(seen);
+        else if (!columns || !ColumnsFromV8(object, Handle<Array>(), v))
+            v = ArrayFromV8(object, (policy_->flags & JSPOLICY_PACKED_ARRAYS) != 0);
     }
     else if (value->IsFunction()) {
 		Handle<Function> function = Handle<Function>::Cast(value);
-		jsvalue* array = new jsvalue[2];
+		jsvalue* array = AllocArray(2);
         if (array != NULL) { 
 			array[0].value.ptr = new Persistent<Object>(Persistent<Function>::New(function));
 			array[0].length = 0;
@@ -408,7 +1213,9 @@ jsvalue JsEngine::AnyFromV8(Handle<Value> value, Handle<Object> thisArg)
     }
     else if (value->IsObject()) {
         Handle<Object> obj = Handle<Object>::Cast(value);
-        if (obj->InternalFieldCount() == 1)
+        if (obj->HasIndexedPropertiesInExternalArrayData())
+            v = BufferFromV8(obj);
+        else if (obj->InternalFieldCount() == 1)
             v = ManagedFromV8(obj);
         else
             v = WrappedFromV8(obj);
@@ -417,9 +1224,47 @@ jsvalue JsEngine::AnyFromV8(Handle<Value> value, Handle<Object> thisArg)
     return v;
 }
 
+jsvalue JsEngine::ResultFromV8(Handle<Value> value, int32_t mode)
+{
+    jsvalue v;
+
+    // Dates aren't objects on the CLR side.
+    bool object = value->IsObject() && !value->IsDate();
+    switch (mode) {
+        case JSRESULT_MODE_DISCARD:
+            return AnyFromV8(Null());
+        case JSRESULT_MODE_PRIMITIVES:
+            return AnyFromV8(object ? Handle<Value>(Null()) : value);
+        case JSRESULT_MODE_HANDLE:
+            if (!object)
+                break;
+            v.type = JSVALUE_TYPE_HANDLE;
+            v.length = value->IsArray() ? Handle<Array>::Cast(value)->Length() : 0;
+            v.value.ptr = new Persistent<Object>(Persistent<Object>::New(value->ToObject()));
+            return v;
+        case JSRESULT_MODE_LAZY:
+            // Strings become String objects, see JsContext::ReadString().
+            if (value->IsArray())
+                v.length = Handle<Array>::Cast(value)->Length();
+            else if (value->IsString())
+                v.length = Handle<String>::Cast(value)->Length();
+            else
+                break;
+            if (v.length < JS_LAZY_MIN_LENGTH)
+                break;
+            v.type = JSVALUE_TYPE_HANDLE;
+            v.value.ptr = new Persistent<Object>(Persistent<Object>::New(value->ToObject()));
+            return v;
+    }
+    return AnyFromV8(value);
+}
+
 jsvalue JsEngine::ArrayFromArguments(const Arguments& args)
 {
-    jsvalue v = jsvalue_alloc_array(args.Length());
+    jsvalue v;
+    v.length = args.Length();
+    v.value.arr = AllocArray(v.length);
+    v.type = JSVALUE_TYPE_ARRAY;
     Local<Object> thisArg = args.Holder();
 
     for (int i=0 ; i < v.length ; i++) {
@@ -443,6 +1288,55 @@ static void managed_destroy(Persistent<Value> object, void* parameter)
     object.Dispose();
 }
 
+// What the weak callback of a buffer needs to give it back to the CLR.
+struct BufferRef
+{
+	JsEngine *engine;
+	int32_t contextId;
+	void *data;
+	int32_t size;
+};
+
+static void buffer_destroy(Persistent<Value> object, void* parameter)
+{
+#ifdef DEBUG_TRACE_API
+		std::cout << "buffer_destroy" << std::endl;
+#endif
+	BufferRef* ref = (BufferRef*)parameter;
+	V8::AdjustAmountOfExternalAllocatedMemory(-ref->size);
+	ref->engine->CallReleaseBuffer(ref->contextId, ref->data);
+	delete ref;
+	object.Dispose();
+}
+
+Handle<Value> JsEngine::BufferToV8(jsvalue v, int32_t contextId)
+{
+	ExternalArrayType kind;
+	int32_t element_size;
+	if (!buffer_kind(v.type, &kind, &element_size))
+		return Null();
+
+	// No copy: JS reads and writes the pinned CLR array in place. The length
+	// is there for loops, V8 doesn't give one to plain objects.
+	Local<Object> object = Object::New();
+	object->SetIndexedPropertiesToExternalArrayData(v.value.ptr, kind, v.length);
+	object->Set(String::NewSymbol("length"), Int32::New(v.length), (PropertyAttribute)(ReadOnly | DontEnum));
+	object->SetHiddenValue(String::NewSymbol(BufferMarker), True());
+
+	BufferRef* ref = new BufferRef();
+	ref->engine = this;
+	ref->contextId = contextId;
+	ref->data = v.value.ptr;
+	ref->size = v.length * element_size;
+	// Pinned memory the GC should know about, or it won't hurry to collect
+	// the (tiny) objects keeping it pinned.
+	V8::AdjustAmountOfExternalAllocatedMemory(ref->size);
+
+	Persistent<Object> persistent = Persistent<Object>::New(object);
+	persistent.MakeWeak(ref, buffer_destroy);
+	return persistent;
+}
+
 Handle<Value> JsEngine::AnyToV8(jsvalue v, int32_t contextId)
 {
 	if (v.type == JSVALUE_TYPE_EMPTY) {
@@ -463,6 +1357,14 @@ Handle<Value> JsEngine::AnyToV8(jsvalue v, int32_t contextId)
     if (v.type == JSVALUE_TYPE_STRING) {
         return String::New(v.value.str);
     }
+    if (v.type == JSVALUE_TYPE_ASCII_STRING) {
+        return String::New((const char*)v.value.ptr, v.length);
+    }
+    if (v.type == JSVALUE_TYPE_EXTERNAL_STRING) {
+        // No copy: V8 takes a reference to the buffer and the jsvalue can be
+        // disposed right away as usual.
+        return String::NewExternal(new JsExternalString(v.value.str, v.length));
+    }
     if (v.type == JSVALUE_TYPE_DATE) {
         return Date::New(v.value.num);
     }
@@ -482,8 +1384,12 @@ Handle<Value> JsEngine::AnyToV8(jsvalue v, int32_t contextId)
     // managed error is still a CLR object so it is wrapped exactly as a normal
     // managed object.
     if (v.type == JSVALUE_TYPE_MANAGED || v.type == JSVALUE_TYPE_MANAGED_ERROR) {
-		ManagedRef* ref = new ManagedRef(this, contextId, v.length);
-		Local<Object> object = (*(managed_template_))->InstanceTemplate()->NewInstance();
+		ManagedRef* ref = new ManagedRef(this, contextId, v.length, v.value.managed.type_key);
+		Handle<FunctionTemplate> templ = *managed_template_;
+		int32_t type_id = v.value.managed.type_id;
+		if (type_id > 0 && type_id <= (int32_t)type_templates_.size())
+			templ = type_templates_[type_id - 1];
+		Local<Object> object = templ->InstanceTemplate()->NewInstance();
 		if (object.IsEmpty()) {
 			return Null();
 		}
@@ -494,6 +1400,10 @@ Handle<Value> JsEngine::AnyToV8(jsvalue v, int32_t contextId)
         return persistent;
     }
 
+    if (v.type >= JSVALUE_TYPE_INT8_BUFFER && v.type <= JSVALUE_TYPE_DOUBLE_BUFFER) {
+        return BufferToV8(v, contextId);
+    }
+
     return Null();
 }
 
@@ -0,0 +1,154 @@
+// This file is part of the VroomJs library.
+//
+// Author:
+//     Federico Di Gregorio <fog@initd.org>
+//
+// Copyright © 2013 Federico Di Gregorio <fog@initd.org>
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+
+#include <chrono>
+#include <cstring>
+#include "vroomjs.h"
+
+JsEnginePool *JsEnginePool::New(int32_t min_size, int32_t max_size, int32_t max_young_space, int32_t max_old_space)
+{
+	JsEnginePool *pool = new JsEnginePool();
+	if (pool != NULL) {
+		if (min_size < 0)
+			min_size = 0;
+		if (max_size < min_size)
+			max_size = min_size;
+
+		pool->min_size_ = min_size;
+		pool->max_size_ = max_size;
+		pool->max_young_space_ = max_young_space;
+		pool->max_old_space_ = max_old_space;
+		pool->disposing_ = false;
+		memset(&pool->stats_, 0, sizeof(pool->stats_));
+
+		pool->refill_thread_ = std::thread(&JsEnginePool::Refill, pool);
+	}
+	return pool;
+}
+
+JsEngine *JsEnginePool::CreateEngine()
+{
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	JsEngine *engine = JsEngine::New(max_young_space_, max_old_space_);
+	int64_t elapsed = std::chrono::duration_cast<std::chrono::microseconds>(
+		std::chrono::steady_clock::now() - start).count();
+
+	std::lock_guard<std::mutex> lock(mutex_);
+	stats_.created++;
+	stats_.creation_time_total += elapsed;
+	if (elapsed > stats_.creation_time_max)
+		stats_.creation_time_max = elapsed;
+	return engine;
+}
+
+void JsEnginePool::Refill()
+{
+	std::unique_lock<std::mutex> lock(mutex_);
+	while (!disposing_) {
+		if ((int32_t)idle_.size() >= min_size_) {
+			refill_needed_.wait(lock);
+			continue;
+		}
+
+		// Creating an engine takes milliseconds: don't hold up Acquire().
+		lock.unlock();
+		JsEngine *engine = CreateEngine();
+		lock.lock();
+
+		if (engine == NULL)
+			break;
+		if (disposing_) {
+			engine->Dispose();
+			delete engine;
+			break;
+		}
+		idle_.push_back(engine);
+	}
+}
+
+JsEngine *JsEnginePool::Acquire()
+{
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+		stats_.leased++;
+		if (!idle_.empty()) {
+			JsEngine *engine = idle_.back();
+			idle_.pop_back();
+			stats_.hits++;
+			if ((int32_t)idle_.size() < min_size_)
+				refill_needed_.notify_one();
+			return engine;
+		}
+		stats_.misses++;
+		refill_needed_.notify_one();
+	}
+
+	// Pool is dry: pay for the engine here rather than wait for the refill
+	// thread, which might be busy with one already.
+	return CreateEngine();
+}
+
+void JsEnginePool::Release(JsEngine *engine)
+{
+	bool keep = engine->Reset();
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+		stats_.leased--;
+		if (keep && !disposing_ && (int32_t)idle_.size() < max_size_) {
+			idle_.push_back(engine);
+			stats_.recycled++;
+			return;
+		}
+		stats_.discarded++;
+	}
+	engine->Dispose();
+	delete engine;
+}
+
+void JsEnginePool::GetStats(jsenginepool_stats *stats)
+{
+	std::lock_guard<std::mutex> lock(mutex_);
+	*stats = stats_;
+	stats->idle = (int32_t)idle_.size();
+}
+
+void JsEnginePool::Dispose()
+{
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+		disposing_ = true;
+		refill_needed_.notify_one();
+	}
+	refill_thread_.join();
+
+	// Leased engines are not ours anymore: their owners must release them
+	// before disposing the pool.
+	for (size_t i = 0; i < idle_.size(); i++) {
+		idle_[i]->Dispose();
+		delete idle_[i];
+	}
+	idle_.clear();
+}
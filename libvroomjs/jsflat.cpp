@@ -0,0 +1,182 @@
+// This file is part of the VroomJs library.
+//
+// Author:
+//     Federico Di Gregorio <fog@initd.org>
+//
+// Copyright © 2013 Federico Di Gregorio <fog@initd.org>
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+
+#include <cstring>
+#include <new>
+#include <unordered_map>
+#include "vroomjs.h"
+
+// Everything in the block is kept 8-byte aligned, like the jsvalues of a tree.
+static inline size_t align8(size_t size)
+{
+	return (size + 7) & ~(size_t)7;
+}
+
+// Trees holding jserrors (e.g., the results of a batch) aren't flattened.
+static const size_t Unflattenable = (size_t)-1;
+
+// Bytes of whatever v points to, not counting v itself: characters (with the
+// terminator), packed elements or child jsvalues with their own payloads.
+static size_t payload_size(const jsvalue &v, bool &references);
+
+static size_t nodes_size(const jsvalue *nodes, int32_t count, bool &references)
+{
+	size_t size = count * sizeof(jsvalue);
+	for (int32_t i = 0; i < count; i++) {
+		size_t payload = payload_size(nodes[i], references);
+		if (payload == Unflattenable)
+			return Unflattenable;
+		size += payload;
+	}
+	return size;
+}
+
+static size_t payload_size(const jsvalue &v, bool &references)
+{
+	if (v.value.ptr == NULL)
+		return 0;
+
+	switch (v.type) {
+		case JSVALUE_TYPE_STRING:
+		case JSVALUE_TYPE_STRING_ERROR:
+			return align8((v.length + 1) * sizeof(uint16_t));
+		case JSVALUE_TYPE_ASCII_STRING:
+			return align8(v.length + 1);
+		case JSVALUE_TYPE_INT32_ARRAY:
+			return align8(v.length * sizeof(int32_t));
+		case JSVALUE_TYPE_DOUBLE_ARRAY:
+			return v.length * sizeof(double);
+		case JSVALUE_TYPE_ARRAY:
+			return nodes_size(v.value.arr, v.length, references);
+		case JSVALUE_TYPE_DICT:
+			return nodes_size(v.value.arr, v.length * 2, references);
+		case JSVALUE_TYPE_COLUMNS:
+			// The keys and then a column per key.
+			return nodes_size(v.value.arr, v.value.arr[0].length + 1, references);
+		case JSVALUE_TYPE_FUNCTION:
+			// The function and its this, both WRAPPED.
+			return nodes_size(v.value.arr, 2, references);
+		case JSVALUE_TYPE_ERROR:
+			return Unflattenable;
+		case JSVALUE_TYPE_REFERENCE:
+			references = true;
+			return 0;
+	}
+	return 0;
+}
+
+// Offsets of the containers already written, by their address in the tree,
+// for the JSVALUE_TYPE_REFERENCEs to them (only kept if there are any). They
+// always come after their target: both the conversion and the copy go depth
+// first in the same order.
+typedef std::unordered_map<const void*, size_t> Offsets;
+
+// Copies src to dst and its payload at the cursor, replacing the pointer in
+// dst with the offset of the payload from the start of the block.
+static void write_value(char *block, size_t &cursor, Offsets *offsets, const jsvalue &src, jsvalue &dst)
+{
+	dst = src;
+	if (src.value.ptr == NULL)
+		return;
+
+	if (src.type == JSVALUE_TYPE_REFERENCE) {
+		Offsets::const_iterator it = offsets->find(src.value.ptr);
+		dst.value.i64 = it != offsets->end() ? it->second : 0;
+		return;
+	}
+
+	size_t at = cursor;
+	int32_t count = 0;
+	switch (src.type) {
+		case JSVALUE_TYPE_STRING:
+		case JSVALUE_TYPE_STRING_ERROR:
+			memcpy(block + at, src.value.ptr, (src.length + 1) * sizeof(uint16_t));
+			cursor += align8((src.length + 1) * sizeof(uint16_t));
+			break;
+		case JSVALUE_TYPE_ASCII_STRING:
+			memcpy(block + at, src.value.ptr, src.length + 1);
+			cursor += align8(src.length + 1);
+			break;
+		case JSVALUE_TYPE_INT32_ARRAY:
+			memcpy(block + at, src.value.ptr, src.length * sizeof(int32_t));
+			cursor += align8(src.length * sizeof(int32_t));
+			break;
+		case JSVALUE_TYPE_DOUBLE_ARRAY:
+			memcpy(block + at, src.value.ptr, src.length * sizeof(double));
+			cursor += src.length * sizeof(double);
+			break;
+		case JSVALUE_TYPE_ARRAY:
+			count = src.length;
+			break;
+		case JSVALUE_TYPE_DICT:
+			count = src.length * 2;
+			break;
+		case JSVALUE_TYPE_COLUMNS:
+			count = src.value.arr[0].length + 1;
+			break;
+		case JSVALUE_TYPE_FUNCTION:
+			count = 2;
+			break;
+		default:
+			// Not a pointer into the tree (e.g., a Persistent of a WRAPPED).
+			return;
+	}
+
+	if (count > 0) {
+		if (offsets != NULL && src.type != JSVALUE_TYPE_FUNCTION)
+			(*offsets)[src.value.ptr] = at;
+		// Children first, then their payloads after them.
+		jsvalue *nodes = (jsvalue*)(block + at);
+		cursor += count * sizeof(jsvalue);
+		for (int32_t i = 0; i < count; i++)
+			write_value(block, cursor, offsets, src.value.arr[i], nodes[i]);
+	}
+
+	dst.value.i64 = at;
+}
+
+jsvalue js_flatten(const jsvalue &root)
+{
+	bool references = false;
+	size_t payload = payload_size(root, references);
+	if (payload == Unflattenable || payload > INT32_MAX - sizeof(jsvalue))
+		return root;
+	size_t size = sizeof(jsvalue) + payload;
+
+	uint64_t *block = new (std::nothrow) uint64_t[size / sizeof(uint64_t)];
+	if (block == NULL)
+		return root;
+
+	size_t cursor = sizeof(jsvalue);
+	Offsets offsets;
+	write_value((char*)block, cursor, references ? &offsets : NULL, root, *(jsvalue*)block);
+
+	jsvalue v;
+	v.type = JSVALUE_TYPE_FLAT;
+	v.length = (int32_t)size;
+	v.value.ptr = block;
+	return v;
+}
@@ -0,0 +1,122 @@
+// This file is part of the VroomJs library.
+//
+// Author:
+//     Federico Di Gregorio <fog@initd.org>
+//
+// Copyright © 2013 Federico Di Gregorio <fog@initd.org>
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#include "vroomjs.h"
+
+JsGraph::JsGraph(JsEngine *engine) : engine_(engine), nodes_(0), error_(NULL)
+{
+	// Read once: the default policy is global and may change under our feet.
+	const jspolicy *policy = engine->GetPolicy();
+	shared_ = (policy->flags & JSPOLICY_SHARED_OBJECTS) != 0;
+	max_depth_ = policy->max_depth;
+	max_nodes_ = policy->max_nodes;
+	max_string_length_ = policy->max_string_length;
+
+	previous_ = engine->GetGraph();
+	engine->SetGraph(this);
+}
+
+JsGraph::~JsGraph()
+{
+	engine_->SetGraph(previous_);
+}
+
+jsvalue JsGraph::Close(jsvalue value)
+{
+	if (error_ == NULL)
+		return value;
+
+	// A partial tree: everything in it was set, if only to NULL. Arena
+	// allocations go away with the arena.
+	if (engine_->GetArenaScope() == NULL)
+		jsvalue_dispose(value);
+
+	jsvalue v = engine_->StringFromV8(String::New(error_), false);
+	v.type = JSVALUE_TYPE_STRING_ERROR;
+	return v;
+}
+
+bool JsGraph::Count()
+{
+	if (error_ != NULL)
+		return false;
+	if (max_nodes_ > 0 && ++nodes_ > max_nodes_) {
+		error_ = "result has more values than the conversion limit";
+		return false;
+	}
+	return true;
+}
+
+bool JsGraph::Fits(int32_t length)
+{
+	if (max_string_length_ > 0 && length > max_string_length_) {
+		error_ = "result has a string longer than the conversion limit";
+		return false;
+	}
+	return true;
+}
+
+bool JsGraph::Enter(Handle<Object> obj, void *ptr)
+{
+	if (error_ != NULL)
+		return false;
+	if (max_depth_ > 0 && (int32_t)path_.size() >= max_depth_) {
+		error_ = "result is nested deeper than the conversion limit";
+		return false;
+	}
+
+	Entry entry;
+	entry.obj = obj;
+	entry.ptr = ptr;
+	path_.push_back(entry);
+	if (shared_)
+		seen_.insert(std::make_pair(obj->GetIdentityHash(), entry));
+	return true;
+}
+
+void JsGraph::Leave()
+{
+	path_.pop_back();
+}
+
+void *JsGraph::Find(Handle<Object> obj)
+{
+	if (shared_) {
+		std::pair<std::unordered_multimap<int, Entry>::iterator, std::unordered_multimap<int, Entry>::iterator> range =
+			seen_.equal_range(obj->GetIdentityHash());
+		for (std::unordered_multimap<int, Entry>::iterator it = range.first; it != range.second; ++it) {
+			if (it->second.obj == obj)
+				return it->second.ptr;
+		}
+		return NULL;
+	}
+
+	// Only cycles: the objects being converted, usually a handful.
+	for (size_t i = path_.size(); i-- > 0; ) {
+		if (path_[i].obj == obj)
+			return path_[i].ptr;
+	}
+	return NULL;
+}
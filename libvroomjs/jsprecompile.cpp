@@ -0,0 +1,257 @@
+// This file is part of the VroomJs library.
+//
+// Author:
+//     Federico Di Gregorio <fog@initd.org>
+//
+// Copyright © 2013 Federico Di Gregorio <fog@initd.org>
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+
+#include <cstddef>
+#include <cstdio>
+#include <cstring>
+#include <functional>
+#include <thread>
+#include "vroomjs.h"
+
+#ifndef _WIN32
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+// Layout of a cache file: this header, then the ScriptData bytes. The header
+// is a multiple of 8 bytes so the data stays aligned in the mapping and
+// ScriptData::New can use it without a copy.
+struct PrecompileHeader
+{
+	char magic[8];
+	char version[32];
+	uint64_t hash[2];
+	int32_t source_length;
+	int32_t data_length;
+};
+
+static const char PrecompileMagic[8] = { 'V', 'J', 'S', 'P', 'R', 'E', '1', 0 };
+
+static void fill_header(PrecompileHeader *header, const uint16_t *str, int32_t length)
+{
+	memset(header, 0, sizeof(*header));
+	memcpy(header->magic, PrecompileMagic, sizeof(header->magic));
+	strncpy(header->version, V8::GetVersion(), sizeof(header->version) - 1);
+	// Two seeds: 128 bits, a collision would feed V8 the wrong function
+	// boundaries.
+	header->hash[0] = js_hash_units(str, length, 0);
+	header->hash[1] = js_hash_units(str, length, 0x5bd1e995);
+	header->source_length = length;
+}
+
+JsPrecompileCache *JsPrecompileCache::New(const uint16_t *directory)
+{
+	JsPrecompileCache *cache = new JsPrecompileCache();
+	if (cache != NULL) {
+#ifdef _WIN32
+		cache->directory_ = (const wchar_t*)directory;
+		CreateDirectoryW(cache->directory_.c_str(), NULL);
+#else
+		// UTF-16 to UTF-8, the file system doesn't care about anything else.
+		for (const uint16_t *p = directory; *p != 0; p++) {
+			uint32_t c = *p;
+			if (c >= 0xd800 && c < 0xdc00 && p[1] >= 0xdc00 && p[1] < 0xe000) {
+				c = 0x10000 + ((c - 0xd800) << 10) + (*++p - 0xdc00);
+			}
+			if (c < 0x80) {
+				cache->directory_ += (char)c;
+			} else if (c < 0x800) {
+				cache->directory_ += (char)(0xc0 | (c >> 6));
+				cache->directory_ += (char)(0x80 | (c & 0x3f));
+			} else if (c < 0x10000) {
+				cache->directory_ += (char)(0xe0 | (c >> 12));
+				cache->directory_ += (char)(0x80 | ((c >> 6) & 0x3f));
+				cache->directory_ += (char)(0x80 | (c & 0x3f));
+			} else {
+				cache->directory_ += (char)(0xf0 | (c >> 18));
+				cache->directory_ += (char)(0x80 | ((c >> 12) & 0x3f));
+				cache->directory_ += (char)(0x80 | ((c >> 6) & 0x3f));
+				cache->directory_ += (char)(0x80 | (c & 0x3f));
+			}
+		}
+		mkdir(cache->directory_.c_str(), 0777);
+#endif
+	}
+	return cache;
+}
+
+JsPrecompileCache::path JsPrecompileCache::PathOf(const PrecompileHeader *header, const char *suffix)
+{
+	char name[48];
+	snprintf(name, sizeof(name), "/%016llx%016llx%s",
+		(unsigned long long)header->hash[0], (unsigned long long)header->hash[1], suffix);
+	path p = directory_;
+	for (const char *c = name; *c != 0; c++)
+		p += *c;
+	return p;
+}
+
+JsPrecompiledData *JsPrecompileCache::Load(const PrecompileHeader *expected)
+{
+	path p = PathOf(expected, ".pre");
+	JsPrecompiledData *data = new JsPrecompiledData();
+
+#ifdef _WIN32
+	HANDLE file = CreateFileW(p.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_DELETE, NULL,
+		OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+	if (file != INVALID_HANDLE_VALUE) {
+		LARGE_INTEGER size;
+		if (GetFileSizeEx(file, &size) && size.QuadPart >= (LONGLONG)sizeof(PrecompileHeader)) {
+			data->mapping_ = CreateFileMappingW(file, NULL, PAGE_READONLY, 0, 0, NULL);
+			if (data->mapping_ != NULL) {
+				data->view_ = MapViewOfFile(data->mapping_, FILE_MAP_READ, 0, 0, 0);
+				data->size_ = (size_t)size.QuadPart;
+			}
+		}
+		CloseHandle(file);
+	}
+#else
+	int fd = open(p.c_str(), O_RDONLY);
+	if (fd >= 0) {
+		struct stat st;
+		if (fstat(fd, &st) == 0 && st.st_size >= (off_t)sizeof(PrecompileHeader)) {
+			void *view = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+			if (view != MAP_FAILED) {
+				data->view_ = view;
+				data->size_ = st.st_size;
+			}
+		}
+		close(fd);
+	}
+#endif
+
+	if (data->view_ == NULL) {
+		delete data;
+		return NULL;
+	}
+
+	// Anything unexpected (other V8, other source, truncated write) is a
+	// miss: the entry gets overwritten with fresh data.
+	const PrecompileHeader *header = (const PrecompileHeader*)data->view_;
+	if (memcmp(header, expected, offsetof(PrecompileHeader, data_length)) != 0 ||
+		header->data_length <= 0 || header->data_length % sizeof(unsigned) != 0 ||
+		sizeof(PrecompileHeader) + header->data_length != data->size_) {
+		delete data;
+		return NULL;
+	}
+
+	data->data_ = ScriptData::New((const char*)(header + 1), header->data_length);
+	if (data->data_->HasError()) {
+		delete data;
+		return NULL;
+	}
+	return data;
+}
+
+void JsPrecompileCache::Store(const PrecompileHeader *header, ScriptData *data)
+{
+	// Written aside and renamed, so that readers never see half a file. The
+	// name is unique to this process and thread, and created exclusively in
+	// case another process sharing the directory came up with it anyway:
+	// that one writes the file, we don't.
+#ifdef _WIN32
+	unsigned long pid = GetCurrentProcessId();
+#else
+	unsigned long pid = (unsigned long)getpid();
+#endif
+	char suffix[48];
+	snprintf(suffix, sizeof(suffix), ".%lx.%llx.tmp", pid,
+		(unsigned long long)std::hash<std::thread::id>()(std::this_thread::get_id()));
+	path tmp = PathOf(header, suffix);
+	path p = PathOf(header, ".pre");
+
+#ifdef _WIN32
+	FILE *f = _wfopen(tmp.c_str(), L"wbx");
+#else
+	FILE *f = NULL;
+	int fd = open(tmp.c_str(), O_WRONLY | O_CREAT | O_EXCL, 0644);
+	if (fd >= 0) {
+		f = fdopen(fd, "wb");
+		if (f == NULL) {
+			close(fd);
+			unlink(tmp.c_str());
+		}
+	}
+#endif
+	if (f == NULL)
+		return;
+
+	PrecompileHeader h = *header;
+	h.data_length = data->Length();
+	bool ok = fwrite(&h, sizeof(h), 1, f) == 1 &&
+		fwrite(data->Data(), h.data_length, 1, f) == 1;
+	ok = fclose(f) == 0 && ok;
+
+#ifdef _WIN32
+	if (!ok || !MoveFileExW(tmp.c_str(), p.c_str(), MOVEFILE_REPLACE_EXISTING))
+		DeleteFileW(tmp.c_str());
+#else
+	if (!ok || rename(tmp.c_str(), p.c_str()) != 0)
+		unlink(tmp.c_str());
+#endif
+}
+
+JsPrecompiledData *JsPrecompileCache::Get(Handle<String> source, const uint16_t *str, int32_t length)
+{
+	PrecompileHeader header;
+	fill_header(&header, str, length);
+
+	JsPrecompiledData *data = Load(&header);
+	if (data != NULL)
+		return data;
+
+	// Cold: pay for a preparse now so the next process doesn't have to.
+	ScriptData *fresh = ScriptData::PreCompile(source);
+	if (fresh == NULL)
+		return NULL;
+	if (fresh->HasError() || fresh->Length() <= 0) {
+		delete fresh;
+		return NULL;
+	}
+	Store(&header, fresh);
+
+	data = new JsPrecompiledData();
+	data->data_ = fresh;
+	return data;
+}
+
+JsPrecompiledData::~JsPrecompiledData()
+{
+	// The ScriptData may point into the view: drop it first.
+	delete data_;
+#ifdef _WIN32
+	if (view_ != NULL)
+		UnmapViewOfFile(view_);
+	if (mapping_ != NULL)
+		CloseHandle(mapping_);
+#else
+	if (view_ != NULL)
+		munmap(view_, size_);
+#endif
+}
@@ -0,0 +1,152 @@
+// This file is part of the VroomJs library.
+//
+// Author:
+//     Federico Di Gregorio <fog@initd.org>
+//
+// Copyright © 2013 Federico Di Gregorio <fog@initd.org>
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+
+#include <cstring>
+#include "vroomjs.h"
+
+static size_t ustrlen(const uint16_t *str)
+{
+	const uint16_t *p = str;
+	while (*p != 0)
+		p++;
+	return p - str;
+}
+
+JsScriptCache *JsScriptCache::New(int64_t budget)
+{
+	JsScriptCache *cache = new JsScriptCache();
+	if (cache != NULL) {
+		memset(&cache->stats_, 0, sizeof(cache->stats_));
+		cache->stats_.budget = budget;
+	}
+	return cache;
+}
+
+Handle<Script> JsScriptCache::Compile(const uint16_t* str, const uint16_t *resourceName)
+{
+	size_t length = ustrlen(str);
+	size_t name_length = resourceName != NULL ? ustrlen(resourceName) : 0;
+
+	// Hits are confirmed by comparing the source, collisions only cost time.
+	uint64_t hash = js_hash_units(str, length, length);
+	if (resourceName != NULL)
+		hash = js_hash_units(resourceName, name_length, hash + 1);
+
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+		std::pair<std::unordered_multimap<uint64_t, std::list<Entry>::iterator>::iterator,
+			std::unordered_multimap<uint64_t, std::list<Entry>::iterator>::iterator> range = index_.equal_range(hash);
+		for (; range.first != range.second; ++range.first) {
+			std::list<Entry>::iterator it = range.first->second;
+			if (it->has_name != (resourceName != NULL) ||
+				it->source.compare(0, ustring::npos, str, length) != 0 ||
+				(resourceName != NULL && it->name.compare(0, ustring::npos, resourceName, name_length) != 0))
+				continue;
+			entries_.splice(entries_.begin(), entries_, it);
+			stats_.hits++;
+			return Local<Script>::New(it->script);
+		}
+		stats_.misses++;
+	}
+
+	Handle<String> source = String::New(str, (int)length);
+	Handle<Script> script;
+	if (resourceName != NULL)
+		script = Script::New(source, String::New(resourceName, (int)name_length));
+	else
+		script = Script::New(source);
+	if (script.IsEmpty())
+		return script;
+
+	int64_t size = (int64_t)((length + name_length) * sizeof(uint16_t) + sizeof(Entry));
+
+	std::lock_guard<std::mutex> lock(mutex_);
+	if (size <= stats_.budget) {
+		entries_.push_front(Entry());
+		Entry &entry = entries_.front();
+		entry.hash = hash;
+		entry.source.assign(str, length);
+		entry.has_name = resourceName != NULL;
+		if (resourceName != NULL)
+			entry.name.assign(resourceName, name_length);
+		entry.size = size;
+		entry.script = Persistent<Script>::New(script);
+		index_.insert(std::make_pair(hash, entries_.begin()));
+		stats_.size += size;
+		stats_.entries++;
+	}
+	Trim();
+	return script;
+}
+
+// Called with mutex_ held.
+void JsScriptCache::Trim()
+{
+	while (stats_.size > stats_.budget && !entries_.empty()) {
+		std::list<Entry>::iterator last = --entries_.end();
+
+		std::pair<std::unordered_multimap<uint64_t, std::list<Entry>::iterator>::iterator,
+			std::unordered_multimap<uint64_t, std::list<Entry>::iterator>::iterator> range = index_.equal_range(last->hash);
+		for (; range.first != range.second; ++range.first) {
+			if (range.first->second == last) {
+				index_.erase(range.first);
+				break;
+			}
+		}
+
+		last->script.Dispose();
+		stats_.size -= last->size;
+		stats_.entries--;
+		stats_.evictions++;
+		entries_.erase(last);
+	}
+}
+
+void JsScriptCache::SetBudget(int64_t budget)
+{
+	// Evicting disposes handles: that needs the isolate, which the caller
+	// doesn't hold. The next Compile() trims the cache down to the new budget.
+	std::lock_guard<std::mutex> lock(mutex_);
+	stats_.budget = budget < 0 ? 0 : budget;
+}
+
+void JsScriptCache::GetStats(jsscriptcache_stats *stats)
+{
+	std::lock_guard<std::mutex> lock(mutex_);
+	*stats = stats_;
+}
+
+// Called with the isolate entered.
+void JsScriptCache::Dispose()
+{
+	std::lock_guard<std::mutex> lock(mutex_);
+	for (std::list<Entry>::iterator it = entries_.begin(); it != entries_.end(); ++it)
+		it->script.Dispose();
+	entries_.clear();
+	index_.clear();
+	stats_.size = 0;
+	stats_.entries = 0;
+}
@@ -0,0 +1,131 @@
+// This file is part of the VroomJs library.
+//
+// Author:
+//     Federico Di Gregorio <fog@initd.org>
+//
+// Copyright © 2013 Federico Di Gregorio <fog@initd.org>
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#include <cstring>
+#include "vroomjs.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define VROOMJS_SSE2
+#endif
+
+bool js_is_ascii(const uint16_t *str, int32_t length)
+{
+	int32_t i = 0;
+#ifdef VROOMJS_SSE2
+	// Or together 16 characters at a time and look for any bit above 0x7f,
+	// bailing out early on the first wide block.
+	const __m128i mask = _mm_set1_epi16((short)0xff80);
+	const __m128i zero = _mm_setzero_si128();
+	for (; i + 16 <= length; i += 16) {
+		__m128i a = _mm_loadu_si128((const __m128i*)(str + i));
+		__m128i b = _mm_loadu_si128((const __m128i*)(str + i + 8));
+		__m128i high = _mm_and_si128(_mm_or_si128(a, b), mask);
+		if (_mm_movemask_epi8(_mm_cmpeq_epi16(high, zero)) != 0xffff)
+			return false;
+	}
+#endif
+	uint16_t rest = 0;
+	for (; i < length; i++)
+		rest |= str[i];
+	return rest < 0x80;
+}
+
+void js_narrow_ascii(const uint16_t *src, int32_t length, uint8_t *dst)
+{
+	int32_t i = 0;
+#ifdef VROOMJS_SSE2
+	// Both loads happen before the store and the store never goes past bytes
+	// already consumed, so this is safe in place too.
+	for (; i + 16 <= length; i += 16) {
+		__m128i a = _mm_loadu_si128((const __m128i*)(src + i));
+		__m128i b = _mm_loadu_si128((const __m128i*)(src + i + 8));
+		_mm_storeu_si128((__m128i*)(dst + i), _mm_packus_epi16(a, b));
+	}
+#endif
+	for (; i < length; i++)
+		dst[i] = (uint8_t)src[i];
+}
+
+// Four characters per multiply.
+uint64_t js_hash_units(const uint16_t *str, size_t length, uint64_t h)
+{
+	const uint64_t k = 0x9E3779B97F4A7C15ULL;
+	for (; length >= 4; str += 4, length -= 4) {
+		uint64_t w;
+		memcpy(&w, str, sizeof(w));
+		h = (h ^ w) * k;
+		h ^= h >> 29;
+	}
+	uint64_t w = (uint64_t)length << 56;
+	memcpy(&w, str, length * sizeof(uint16_t));
+	h = (h ^ w) * k;
+	return h ^ (h >> 32);
+}
+
+// The reference count lives right before the characters so that the jsvalue
+// can keep pointing at the string itself, as the CLR side expects.
+struct ExternalStringHeader
+{
+	long refs;
+	int32_t length;
+	int32_t padding;
+};
+
+static inline ExternalStringHeader *HeaderOf(uint16_t *str)
+{
+	return (ExternalStringHeader*)str - 1;
+}
+
+uint16_t *JsExternalString::Alloc(int32_t length)
+{
+	ExternalStringHeader *header = (ExternalStringHeader*)malloc(
+		sizeof(ExternalStringHeader) + (length + 1) * sizeof(uint16_t));
+	if (header == NULL)
+		return NULL;
+	header->refs = 1;
+	header->length = length;
+	return (uint16_t*)(header + 1);
+}
+
+void JsExternalString::Release(uint16_t *str)
+{
+	ExternalStringHeader *header = HeaderOf(str);
+	if (RELEASE(header->refs) == 0)
+		free(header);
+}
+
+JsExternalString::JsExternalString(uint16_t *str, int32_t length) : str_(str), length_(length)
+{
+	ADDREF(HeaderOf(str)->refs);
+	V8::AdjustAmountOfExternalAllocatedMemory(length * sizeof(uint16_t));
+}
+
+JsExternalString::~JsExternalString()
+{
+	// Called by V8 when the string is collected.
+	V8::AdjustAmountOfExternalAllocatedMemory(-(int)(length_ * sizeof(uint16_t)));
+	Release(str_);
+}
@@ -40,8 +40,22 @@ Handle<Value> ManagedRef::GetPropertyValue(Local<String> name)
 #ifdef DEBUG_TRACE_API
 		std::cout << "GetPropertyValue" << std::endl;
 #endif
+    // Names the type is known not to have don't need the CLR.
+    if (typeKey_ != 0) {
+        int32_t cached = engine_->LookupMember(typeKey_, *s, s.length());
+        if (cached == JSVALUE_TYPE_EMPTY)
+            return res;
+        if (cached == JSVALUE_TYPE_NOT_FOUND)
+            return ThrowNotFound(name, *s);
+    }
+
     jsvalue r = engine_->CallGetPropertyValue(contextId_, id_, *s);
-	if (r.type == JSVALUE_TYPE_MANAGED_ERROR)
+    if (typeKey_ != 0 && (r.type == JSVALUE_TYPE_EMPTY || r.type == JSVALUE_TYPE_NOT_FOUND))
+        engine_->StoreMember(typeKey_, *s, s.length(), r.type);
+
+    if (r.type == JSVALUE_TYPE_NOT_FOUND)
+        res = ThrowNotFound(name, *s);
+	else if (r.type == JSVALUE_TYPE_MANAGED_ERROR)
         res = ThrowException(engine_->AnyToV8(r, contextId_));
     else
         res = engine_->AnyToV8(r, contextId_);
@@ -54,6 +68,19 @@ Handle<Value> ManagedRef::GetPropertyValue(Local<String> name)
 	return res;
 }
 
+// The CLR builds the error, with the type in it, without looking for the
+// name again.
+Handle<Value> ManagedRef::ThrowNotFound(Local<String> name, uint16_t* s)
+{
+    jsvalue r = engine_->CallMissingProperty(contextId_, id_, s);
+    if (r.type != JSVALUE_TYPE_MANAGED_ERROR)
+        return ThrowException(Exception::Error(String::Concat(String::New("property not found: "), name)));
+
+    Handle<Value> res = ThrowException(engine_->AnyToV8(r, contextId_));
+    jsvalue_dispose(r);
+    return res;
+}
+
 Handle<Boolean> ManagedRef::DeleteProperty(Local<String> name)
 {
     Handle<Value> res;
@@ -88,6 +115,9 @@ Handle<Value> ManagedRef::SetPropertyValue(Local<String> name, Local<Value> valu
 		std::cout << "SetPropertyValue" << std::endl;
 #endif
     
+    // The value is only needed during the call, so it can live in an arena
+    // that is released when we return.
+    JsArenaScope arena(engine_);
     jsvalue v = engine_->AnyFromV8(value);
     jsvalue r = engine_->CallSetPropertyValue(contextId_, id_, *s, v);
     if (r.type == JSVALUE_TYPE_MANAGED_ERROR)
@@ -99,7 +129,6 @@ Handle<Value> ManagedRef::SetPropertyValue(Local<String> name, Local<Value> valu
 		std::cout << "cleaning up result from setproperty value" << std::endl;
 #endif
     // We don't need the jsvalues anymore and the CLR side never reuse them.
-    jsvalue_dispose(v);
     jsvalue_dispose(r);
     
     return res;
@@ -132,6 +161,7 @@ Handle<Value> ManagedRef::Invoke(const Arguments& args)
 	std::wcout << "INVOKING..........." << std::endl;
 #endif
 	Handle<Value> res;
+    JsArenaScope arena(engine_);
     jsvalue a = engine_->ArrayFromArguments(args);
     jsvalue r = engine_->CallInvoke(contextId_, id_, a);
     if (r.type == JSVALUE_TYPE_MANAGED_ERROR)
@@ -143,7 +173,7 @@ Handle<Value> ManagedRef::Invoke(const Arguments& args)
 		std::wcout << "cleaning up result from invoke" << std::endl;
 #endif
     // We don't need the jsvalue anymore and the CLR side never reuse them.
-	jsvalue_dispose(a);
+    // The arguments go away with the arena.
     jsvalue_dispose(r);
     
     return res;
@@ -169,4 +199,117 @@ Handle<Array> ManagedRef::EnumerateProperties()
     jsvalue_dispose(r);
 
 	return Handle<Array>::Cast(res);
-}
\ No newline at end of file
+}
+
+Handle<Value> ManagedRef::GetMember(int32_t member)
+{
+#ifdef DEBUG_TRACE_API
+		std::cout << "GetMember" << std::endl;
+#endif
+    Handle<Value> res;
+    jsvalue r = engine_->CallGetMember(contextId_, id_, member);
+    if (r.type == JSVALUE_TYPE_MANAGED_ERROR)
+        res = ThrowException(engine_->AnyToV8(r, contextId_));
+    else
+        res = engine_->AnyToV8(r, contextId_);
+    
+    jsvalue_dispose(r);
+    return res;
+}
+
+Handle<Value> ManagedRef::SetMember(int32_t member, Local<Value> value)
+{
+#ifdef DEBUG_TRACE_API
+		std::cout << "SetMember" << std::endl;
+#endif
+    Handle<Value> res;
+    JsArenaScope arena(engine_);
+    jsvalue v = engine_->AnyFromV8(value);
+    jsvalue r = engine_->CallSetMember(contextId_, id_, member, v);
+    if (r.type == JSVALUE_TYPE_MANAGED_ERROR)
+        res = ThrowException(engine_->AnyToV8(r, contextId_));
+    else
+        res = engine_->AnyToV8(r, contextId_);
+    
+    jsvalue_dispose(r);
+    return res;
+}
+
+Handle<Value> ManagedRef::InvokeMember(int32_t member, const Arguments& args)
+{
+#ifdef DEBUG_TRACE_API
+		std::cout << "InvokeMember" << std::endl;
+#endif
+    Handle<Value> res;
+    JsArenaScope arena(engine_);
+    jsvalue a = engine_->ArrayFromArguments(args);
+    jsvalue r = engine_->CallInvokeMember(contextId_, id_, member, a);
+    if (r.type == JSVALUE_TYPE_MANAGED_ERROR)
+        res = ThrowException(engine_->AnyToV8(r, contextId_));
+    else
+        res = engine_->AnyToV8(r, contextId_);
+    
+    jsvalue_dispose(r);
+    return res;
+}
+
+Handle<Value> ManagedRef::GetElement(uint32_t index)
+{
+#ifdef DEBUG_TRACE_API
+		std::cout << "GetElement" << std::endl;
+#endif
+    Handle<Value> res;
+    jsvalue v;
+    v.type = JSVALUE_TYPE_EMPTY;
+    jsvalue r = engine_->CallIndexed(contextId_, id_, JSINDEXED_GET, index, v);
+    // Objects that aren't lists look the index up as a name.
+    if (r.type == JSVALUE_TYPE_NOT_FOUND) {
+        Local<String> name = Integer::NewFromUnsigned(index)->ToString();
+        String::Value s(name);
+        res = ThrowNotFound(name, *s);
+    }
+    else if (r.type == JSVALUE_TYPE_MANAGED_ERROR)
+        res = ThrowException(engine_->AnyToV8(r, contextId_));
+    else
+        res = engine_->AnyToV8(r, contextId_);
+    
+    jsvalue_dispose(r);
+    return res;
+}
+
+Handle<Value> ManagedRef::SetElement(uint32_t index, Local<Value> value)
+{
+#ifdef DEBUG_TRACE_API
+		std::cout << "SetElement" << std::endl;
+#endif
+    Handle<Value> res;
+    JsArenaScope arena(engine_);
+    jsvalue v = engine_->AnyFromV8(value);
+    jsvalue r = engine_->CallIndexed(contextId_, id_, JSINDEXED_SET, index, v);
+    if (r.type == JSVALUE_TYPE_MANAGED_ERROR)
+        res = ThrowException(engine_->AnyToV8(r, contextId_));
+    else
+        res = engine_->AnyToV8(r, contextId_);
+    
+    jsvalue_dispose(r);
+    return res;
+}
+
+Handle<Array> ManagedRef::EnumerateElements()
+{
+#ifdef DEBUG_TRACE_API
+		std::cout << "EnumerateElements" << std::endl;
+#endif
+    jsvalue v;
+    v.type = JSVALUE_TYPE_EMPTY;
+    jsvalue r = engine_->CallIndexed(contextId_, id_, JSINDEXED_LENGTH, 0, v);
+    if (r.type != JSVALUE_TYPE_INTEGER) {
+        jsvalue_dispose(r);
+        return Handle<Array>();
+    }
+
+    Handle<Array> indices = Array::New(r.value.i32);
+    for (int32_t i = 0; i < r.value.i32; i++)
+        indices->Set(i, Integer::New(i));
+    return indices;
+}
@@ -30,12 +30,49 @@
 #include <stdlib.h>
 #include <stdint.h>
 #include <iostream>
+#include <condition_variable>
+#include <list>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
 
 using namespace v8;
 
 #define JSOBJECT_MARSHAL_TYPE_DYNAMIC       1
 #define JSOBJECT_MARSHAL_TYPE_DICTIONARY    2
 
+// How much of the result of a script or call to convert: all of it, nothing
+// (errors still come back), only primitives (objects come back as NULL) or
+// objects as JSVALUE_TYPE_HANDLE, to be converted later if at all.
+#define JSRESULT_MODE_FULL          0
+#define JSRESULT_MODE_DISCARD       1
+#define JSRESULT_MODE_PRIMITIVES    2
+#define JSRESULT_MODE_HANDLE        3
+// Arrays and strings of at least JS_LAZY_MIN_LENGTH elements or characters
+// as JSVALUE_TYPE_HANDLE, to be read a range at a time; everything else in
+// full.
+#define JSRESULT_MODE_LAZY          4
+
+// Switches of a jspolicy.
+#define JSPOLICY_COMPACT_STRINGS    1
+#define JSPOLICY_PACKED_ARRAYS      2
+#define JSPOLICY_FLAT_RESULTS       4
+#define JSPOLICY_COLUMNAR_RESULTS   8
+#define JSPOLICY_SHARED_OBJECTS     16
+
+// Kinds of the members of a type registered with jsengine_register_type; a
+// property or field can be both GET and SET.
+#define JSMEMBER_KIND_GET       1
+#define JSMEMBER_KIND_SET       2
+#define JSMEMBER_KIND_METHOD    4
+
+// Operations of the indexed property delegate, for managed collections.
+#define JSINDEXED_GET       0
+#define JSINDEXED_SET       1
+#define JSINDEXED_LENGTH    2
+
 // jsvalue (JsValue on the CLR side) is a struct that can be easily marshaled
 // by simply blitting its value (being only 16 bytes should be quite fast too).
 
@@ -56,6 +93,60 @@ using namespace v8;
 #define JSVALUE_TYPE_DICT           15
 #define JSVALUE_TYPE_ERROR          16
 #define JSVALUE_TYPE_FUNCTION       17
+#define JSVALUE_TYPE_EXTERNAL_STRING 18
+#define JSVALUE_TYPE_ASCII_STRING   19
+// Answer of the CLR to a property read of a member its type doesn't have.
+#define JSVALUE_TYPE_NOT_FOUND      20
+// Pinned CLR arrays of numbers: value.ptr is the first element and length
+// the number of elements. AnyToV8 exposes them as external array data.
+#define JSVALUE_TYPE_INT8_BUFFER    21
+#define JSVALUE_TYPE_UINT8_BUFFER   22
+#define JSVALUE_TYPE_INT16_BUFFER   23
+#define JSVALUE_TYPE_UINT16_BUFFER  24
+#define JSVALUE_TYPE_INT32_BUFFER   25
+#define JSVALUE_TYPE_UINT32_BUFFER  26
+#define JSVALUE_TYPE_FLOAT_BUFFER   27
+#define JSVALUE_TYPE_DOUBLE_BUFFER  28
+// Arrays of numbers from JS, packed: value.ptr points to length int32_t or
+// double elements, owned by the jsvalue like the jsvalues of an ARRAY.
+#define JSVALUE_TYPE_INT32_ARRAY    29
+#define JSVALUE_TYPE_DOUBLE_ARRAY   30
+// A whole result tree in one block of length bytes at value.ptr, see
+// js_flatten.
+#define JSVALUE_TYPE_FLAT           31
+// UTF-8 JSON text at value.ptr (NUL terminated), length is in bytes. Freed
+// like JSVALUE_TYPE_ASCII_STRING.
+#define JSVALUE_TYPE_JSON           32
+// Objects with the same keys by column: value.arr holds an ARRAY of the key
+// strings and then a column per key (INT32_ARRAY or DOUBLE_ARRAY when all
+// numbers, ARRAY otherwise); length is the number of rows.
+#define JSVALUE_TYPE_COLUMNS        33
+// An object met again in the same result (see JsGraph): value.ptr is the
+// value.arr of the non-empty ARRAY, DICT or COLUMNS it was converted to
+// first. Owns nothing.
+#define JSVALUE_TYPE_REFERENCE      34
+// Any object kept in V8, see JSRESULT_MODE_HANDLE: value.ptr is a
+// Persistent<Object>* like for JSVALUE_TYPE_WRAPPED. For arrays, and strings
+// (as String objects) from JSRESULT_MODE_LAZY, length is their length.
+#define JSVALUE_TYPE_HANDLE         35
+
+// Strings at least this long are allocated by jsvalue_alloc_string as
+// JSVALUE_TYPE_EXTERNAL_STRING: AnyToV8 hands their buffer over to V8
+// instead of copying it.
+#define JS_EXTERNAL_STRING_MIN_LENGTH 1024
+
+// Arrays and strings shorter than this are converted at once even with
+// JSRESULT_MODE_LAZY.
+#define JS_LAZY_MIN_LENGTH (64 * 1024)
+
+// Default memory budget of the per-engine compiled script cache, in bytes of
+// cached source (see JsScriptCache).
+#define JS_SCRIPT_CACHE_DEFAULT_BUDGET (8 * 1024 * 1024)
+
+// Upper bound on the entries of the per-engine cache of names missing from
+// CLR types (see JsEngine::LookupMember), against scripts probing endless
+// distinct names.
+#define JS_MEMBER_CACHE_MAX_ENTRIES 16384
 
 #ifdef _WIN32 
 #define EXPORT __declspec(dllexport)
@@ -63,19 +154,23 @@ using namespace v8;
 #define EXPORT
 #endif
 
+// ADDREF and RELEASE return the new value on all platforms, INCREMENT and
+// DECREMENT don't.
 #ifdef _WIN32
 #include "Windows.h"
 #define CALLINGCONVENTION __stdcall
 #define INCREMENT(x) InterlockedIncrement(&x)
 #define DECREMENT(x) InterlockedDecrement(&x)
+#define ADDREF(x) InterlockedIncrement(&x)
+#define RELEASE(x) InterlockedDecrement(&x)
 #else 
 #define CALLINGCONVENTION
 #define INCREMENT(x) __sync_fetch_and_add(&x, 1)
 #define DECREMENT(x) __sync_fetch_and_add(&x, -1)
+#define ADDREF(x) __sync_add_and_fetch(&x, 1)
+#define RELEASE(x) __sync_sub_and_fetch(&x, 1)
 #endif
 
-extern int32_t js_object_marshal_type;
-
 extern long js_mem_debug_engine_count;
 extern long js_mem_debug_context_count;
 extern long js_mem_debug_managedref_count;
@@ -97,6 +192,13 @@ extern "C"
             void       *ptr;
             uint16_t   *str;
             jsvalue    *arr;
+            // JSVALUE_TYPE_MANAGED: the id of its registered type (0 if none)
+            // and a key for its CLR type in the member cache (0 if its members
+            // can change, e.g. dictionaries).
+            struct {
+                int32_t type_id;
+                int32_t type_key;
+            } managed;
         } value;
         
         int32_t         type;
@@ -114,10 +216,80 @@ extern "C"
 	};
 	
 	EXPORT void CALLINGCONVENTION jsvalue_dispose(jsvalue value);
+
+	// Counters of a JsEnginePool, times are in microseconds.
+	struct jsenginepool_stats
+	{
+		int64_t hits;
+		int64_t misses;
+		int64_t created;
+		int64_t recycled;
+		int64_t discarded;
+		int64_t creation_time_total;
+		int64_t creation_time_max;
+		int32_t idle;
+		int32_t leased;
+	};
+
+	// Counters of the per-engine script cache, sizes are in bytes.
+	struct jsscriptcache_stats
+	{
+		int64_t hits;
+		int64_t misses;
+		int64_t evictions;
+		int64_t size;
+		int64_t budget;
+		int32_t entries;
+		int32_t padding;
+	};
+
+	// Counters of the per-engine cache of names missing from CLR types.
+	struct jsmembercache_stats
+	{
+		int64_t hits;
+		int64_t misses;
+		int64_t entries;
+	};
+
+	// How results are converted from V8: object_marshal_type is one of the
+	// JSOBJECT_MARSHAL_TYPE_*, flags are JSPOLICY_* and the limits are 0 for
+	// none. Going past max_depth nested objects, max_nodes values or a string
+	// value of max_string_length characters fails the whole conversion.
+	struct jspolicy
+	{
+		int32_t object_marshal_type;
+		int32_t flags;
+		int32_t max_depth;
+		int32_t max_nodes;
+		int32_t max_string_length;
+	};
 }
 
+// The policy of contexts without one of their own, set by the js_set_*
+// functions.
+extern jspolicy js_default_policy;
+
+// Width check and conversion used to send pure ASCII strings as one byte per
+// character (JSVALUE_TYPE_ASCII_STRING). Vectorized when SSE2 is available;
+// js_narrow_ascii can work in place (dst == src).
+bool js_is_ascii(const uint16_t *str, int32_t length);
+void js_narrow_ascii(const uint16_t *src, int32_t length, uint8_t *dst);
+
+// Quick 64-bit hash of a UTF-16 buffer, seeded with h; not cryptographic.
+uint64_t js_hash_units(const uint16_t *str, size_t length, uint64_t h);
+
+// Copies a result tree into a single JSVALUE_TYPE_FLAT block, freed by
+// jsvalue_dispose with one call. The block starts with the root jsvalue and
+// holds every string, packed array and child jsvalue of the tree; where the
+// tree has pointers (value.ptr of those types) the block has byte offsets
+// from its start, 0 for NULL. Returns root itself for trees holding jserrors
+// or if the block can't be allocated.
+jsvalue js_flatten(const jsvalue &root);
+
 class JsEngine;
 class JsContext;
+class JsArenaScope;
+class JsGraph;
 
 // The only way for the C++/V8 side to call into the CLR is to use the function
 // pointers (CLR, delegates) defined below.
@@ -134,8 +306,161 @@ extern "C"
 	typedef jsvalue (CALLINGCONVENTION *keepalive_invoke_f) (int context, int id, jsvalue args);
 	typedef jsvalue (CALLINGCONVENTION *keepalive_delete_property_f) (int context, int id, uint16_t* name);
 	typedef jsvalue (CALLINGCONVENTION *keepalive_enumerate_properties_f) (int context, int id);
+
+	// Members of registered types, by their index in the registration.
+	typedef jsvalue (CALLINGCONVENTION *keepalive_get_member_f) (int context, int id, int32_t member);
+	typedef jsvalue (CALLINGCONVENTION *keepalive_set_member_f) (int context, int id, int32_t member, jsvalue value);
+	typedef jsvalue (CALLINGCONVENTION *keepalive_invoke_member_f) (int context, int id, int32_t member, jsvalue args);
+
+	// Element access on managed collections, see JSINDEXED_*. An EMPTY result
+	// means the object has no such element (or isn't a collection at all).
+	typedef jsvalue (CALLINGCONVENTION *keepalive_indexed_f) (int context, int id, int32_t op, uint32_t index, jsvalue value);
+
+	// V8 collected the last object backed by a buffer: the CLR can unpin it.
+	typedef void (CALLINGCONVENTION *keepalive_release_buffer_f) (int context, void* data);
+
+	// The error to throw for a property the object doesn't have, once the
+	// CLR (or the member cache) said so.
+	typedef jsvalue (CALLINGCONVENTION *keepalive_missing_property_f) (int context, int id, uint16_t* name);
 }
 
+// JsArena is a bump allocator for the jsvalue trees built by the conversion
+// functions: strings, arrays, dictionary pairs and jserrors of a single result
+// all come from a few large chunks that are freed together. The root of the
+// tree points to the arena from a small header right before it, so that
+// jsvalue_dispose can release the whole result with one call instead of
+// walking it. Blocks allocated one at a time (by the CLR, or outside of any
+// JsArenaScope) carry the same header, pointing nowhere, and are walked.
+class JsArena {
+public:
+	static JsArena *New();
+
+	void *Alloc(size_t size);
+	void Dispose();
+
+	// Makes the arena owned by the result whose root is one of its blocks.
+	void Adopt(void *root);
+	// Frees the arena owning the result at root, false if it has none.
+	static bool Release(void *root);
+
+	// A block of its own with the header, for the trees that are walked.
+	static void *HeapAlloc(size_t size);
+	static void HeapFree(void *block);
+
+	inline ~JsArena() {
+		Dispose();
+	}
+
+private:
+	struct Chunk {
+		Chunk *next;
+		size_t size;
+		size_t used;
+	};
+
+	inline JsArena() : chunks_(NULL) {}
+
+	Chunk *chunks_;
+};
+
+// Sets up an arena for all the conversions made while it is on the stack, much
+// like a HandleScope. Scopes nest: managed callbacks running while a scope is
+// active open their own. Close() hands the arena over to the returned value,
+// everything else is freed when the scope goes away.
+class JsArenaScope {
+public:
+	explicit JsArenaScope(JsEngine *engine);
+	~JsArenaScope();
+
+	jsvalue Close(jsvalue value);
+	void *Alloc(size_t size);
+
+private:
+	JsEngine *engine_;
+	JsArenaScope *previous_;
+	JsArena *arena_;
+};
+
+// The objects met by one conversion from V8. Those met again while their own
+// properties or elements are being converted (cycles) and, with
+// JSPOLICY_SHARED_OBJECTS, anywhere else in the same result come back as a
+// JSVALUE_TYPE_REFERENCE to their first conversion. Also enforces the limits
+// of the current jspolicy, past which Close() frees what was built and
+// returns an error. Nested like JsArenaScope: managed callbacks running in
+// the middle of a conversion get their own.
+class JsGraph {
+public:
+	explicit JsGraph(JsEngine *engine);
+	~JsGraph();
+
+	jsvalue Close(jsvalue value);
+
+	// Counts a value, false once over the limit.
+	bool Count();
+	// False if a string value of this length is over the limit.
+	bool Fits(int32_t length);
+	// Around the conversion of the properties or elements of obj into the
+	// jsvalues at ptr. False, with nothing to Leave(), over the depth limit.
+	bool Enter(Handle<Object> obj, void *ptr);
+	void Leave();
+	// The ptr obj was entered with, NULL if it wasn't.
+	void *Find(Handle<Object> obj);
+
+	inline bool Failed() { return error_ != NULL; }
+
+private:
+	struct Entry {
+		Handle<Object> obj;
+		void *ptr;
+	};
+
+	JsEngine *engine_;
+	JsGraph *previous_;
+	std::vector<Entry> path_;
+	// By identity hash, only with JSPOLICY_SHARED_OBJECTS: computing it is far
+	// from free (V8 stores it in a hidden property).
+	std::unordered_multimap<int, Entry> seen_;
+	bool shared_;
+	int32_t max_depth_;
+	int32_t max_nodes_;
+	int32_t max_string_length_;
+	int32_t nodes_;
+	const char *error_;
+};
+
+// Makes policy the one of all the conversions made while it is on the stack.
+// Nested like JsArenaScope, so that managed callbacks converting their
+// arguments do it as the call they come from asked.
+class JsPolicyScope {
+public:
+	JsPolicyScope(JsEngine *engine, const jspolicy *policy);
+	~JsPolicyScope();
+
+private:
+	JsEngine *engine_;
+	const jspolicy *previous_;
+};
+
+// A reference counted UTF-16 buffer that V8 can use as the backing store of an
+// external string. The jsvalue that carries it holds one reference (dropped by
+// jsvalue_dispose) and every V8 string made from it holds another (dropped
+// when V8 collects the string), so whoever finishes last frees the buffer.
+class JsExternalString : public String::ExternalStringResource {
+public:
+	static uint16_t *Alloc(int32_t length);
+	static void Release(uint16_t *str);
+
+	explicit JsExternalString(uint16_t *str, int32_t length);
+	~JsExternalString();
+
+	const uint16_t *data() const { return str_; }
+	size_t length() const { return length_; }
+
+private:
+	uint16_t *str_;
+	size_t length_;
+};
+
 class JsScript {
 public:
 	static JsScript *New(JsEngine *engine);
@@ -156,6 +481,102 @@ private:
 	Persistent<Script> *script_;
 };
 
+// Bounded LRU cache of compiled, context independent scripts, keyed by a
+// hash of source and resource name, so that executing the same source again
+// skips the parser. The budget is in bytes of source kept (the compiled code
+// grows with it); the least recently used scripts are dropped to stay under
+// it. Lookups happen with the engine's isolate locked, the mutex is there for
+// the stats and budget.
+class JsScriptCache {
+public:
+	static JsScriptCache *New(int64_t budget);
+
+	// Returns an empty handle (and leaves the exception to the caller's
+	// TryCatch) if the source doesn't compile; failures are not cached.
+	Handle<Script> Compile(const uint16_t* str, const uint16_t *resourceName);
+
+	void SetBudget(int64_t budget);
+	void GetStats(jsscriptcache_stats *stats);
+	void Dispose();
+
+	inline ~JsScriptCache() {
+		Dispose();
+	}
+
+private:
+	inline JsScriptCache() {}
+
+	typedef std::basic_string<uint16_t> ustring;
+
+	struct Entry {
+		uint64_t hash;
+		ustring source;
+		ustring name;
+		bool has_name;
+		int64_t size;
+		Persistent<Script> script;
+	};
+
+	void Trim();
+
+	std::mutex mutex_;
+	std::list<Entry> entries_;	// Most recently used first.
+	std::unordered_multimap<uint64_t, std::list<Entry>::iterator> index_;
+	jsscriptcache_stats stats_;
+};
+
+// Precompile data (ScriptData) for one compilation, either mapped from a
+// cache file or freshly produced. Delete it once the script is compiled.
+class JsPrecompiledData {
+public:
+	ScriptData *GetData() { return data_; }
+	~JsPrecompiledData();
+
+private:
+	friend class JsPrecompileCache;
+	inline JsPrecompiledData() : data_(NULL), view_(NULL), size_(0) {
+#ifdef _WIN32
+		mapping_ = NULL;
+#endif
+	}
+
+	ScriptData *data_;
+	void *view_;
+	size_t size_;
+#ifdef _WIN32
+	HANDLE mapping_;
+#endif
+};
+
+struct PrecompileHeader;
+
+// On-disk cache of precompile data, one file per source in a directory,
+// used by JsEngine::CompileScript so that a new process can skip most of the
+// preparsing of big scripts. Files are memory mapped and validated against
+// a 128-bit hash of the source and the V8 version before being used.
+class JsPrecompileCache {
+public:
+	static JsPrecompileCache *New(const uint16_t *directory);
+
+	// NULL if the source can't be precompiled (it has syntax errors).
+	JsPrecompiledData *Get(Handle<String> source, const uint16_t *str, int32_t length);
+
+private:
+	inline JsPrecompileCache() {}
+
+#ifdef _WIN32
+	typedef std::wstring path;
+#else
+	typedef std::string path;
+#endif
+
+	path PathOf(const PrecompileHeader *header, const char *suffix);
+	JsPrecompiledData *Load(const PrecompileHeader *expected);
+	void Store(const PrecompileHeader *header, ScriptData *data);
+
+	path directory_;
+};
+
 // JsEngine is a single isolated v8 interpreter and is the referenced as an IntPtr
 // by the JsEngine on the CLR side.
 class JsEngine {
@@ -170,6 +591,14 @@ public:
 	inline void SetInvokeDelegate(keepalive_invoke_f delegate) { keepalive_invoke_ = delegate; }
 	inline void SetDeletePropertyDelegate(keepalive_delete_property_f delegate) { keepalive_delete_property_ = delegate; }
 	inline void SetEnumeratePropertiesDelegate(keepalive_enumerate_properties_f delegate) { keepalive_enumerate_properties_ = delegate; }
+	inline void SetMemberDelegates(keepalive_get_member_f get, keepalive_set_member_f set, keepalive_invoke_member_f invoke) {
+		keepalive_get_member_ = get;
+		keepalive_set_member_ = set;
+		keepalive_invoke_member_ = invoke;
+	}
+	inline void SetIndexedDelegate(keepalive_indexed_f delegate) { keepalive_indexed_ = delegate; }
+	inline void SetReleaseBufferDelegate(keepalive_release_buffer_f delegate) { keepalive_release_buffer_ = delegate; }
+	inline void SetMissingPropertyDelegate(keepalive_missing_property_f delegate) { keepalive_missing_property_ = delegate; }
 
 	// Call delegates into managed code.
     inline void CallRemove(int32_t context, int id) {
@@ -229,21 +658,138 @@ public:
 		jsvalue value = keepalive_enumerate_properties_(context, id);
 		return value;
 	}
+	inline jsvalue CallGetMember(int32_t context, int32_t id, int32_t member) {
+		if (keepalive_get_member_ == NULL) {
+			jsvalue v;
+			v.type = JSVALUE_TYPE_NULL;
+			return v;
+		}
+		return keepalive_get_member_(context, id, member);
+	}
+	inline jsvalue CallSetMember(int32_t context, int32_t id, int32_t member, jsvalue value) {
+		if (keepalive_set_member_ == NULL) {
+			jsvalue v;
+			v.type = JSVALUE_TYPE_NULL;
+			return v;
+		}
+		return keepalive_set_member_(context, id, member, value);
+	}
+	inline jsvalue CallInvokeMember(int32_t context, int32_t id, int32_t member, jsvalue args) {
+		if (keepalive_invoke_member_ == NULL) {
+			jsvalue v;
+			v.type = JSVALUE_TYPE_NULL;
+			return v;
+		}
+		return keepalive_invoke_member_(context, id, member, args);
+	}
+	inline jsvalue CallIndexed(int32_t context, int32_t id, int32_t op, uint32_t index, jsvalue value) {
+		if (keepalive_indexed_ == NULL) {
+			jsvalue v;
+			v.type = JSVALUE_TYPE_EMPTY;
+			return v;
+		}
+		return keepalive_indexed_(context, id, op, index, value);
+	}
+	inline void CallReleaseBuffer(int32_t context, void* data) {
+		if (keepalive_release_buffer_ != NULL)
+			keepalive_release_buffer_(context, data);
+	}
+	inline jsvalue CallMissingProperty(int32_t context, int32_t id, uint16_t* name) {
+		if (keepalive_missing_property_ == NULL) {
+			jsvalue v;
+			v.type = JSVALUE_TYPE_EMPTY;
+			return v;
+		}
+		return keepalive_missing_property_(context, id, name);
+	}
 	
 	// Conversions. Note that all the conversion functions should be called
     // with an HandleScope already on the stack or sill misarabily fail.
     jsvalue ErrorFromV8(TryCatch& trycatch);
-    jsvalue StringFromV8(Handle<Value> value);
+    // The count characters (or elements) from start, all of them from start
+    // if count is negative.
+    jsvalue StringFromV8(Handle<Value> value, bool compact = true, int32_t start = 0, int32_t count = -1);
     jsvalue WrappedFromV8(Handle<Object> obj);
     jsvalue ManagedFromV8(Handle<Object> obj);
+    jsvalue BufferFromV8(Handle<Object> obj);
+    bool PackedFromV8(Handle<Array> array, jsvalue &v, uint32_t start = 0);
+    jsvalue ArrayFromV8(Handle<Array> array, bool packed, uint32_t start = 0, int32_t count = -1);
+    // Arrays of plain objects as JSVALUE_TYPE_COLUMNS, with the given keys
+    // or, if names is empty, the keys shared by all the rows. False, and
+    // nothing allocated, if the rows don't fit.
+    bool ColumnsFromV8(Handle<Array> rows, Handle<Array> names, jsvalue &v);
+    // A conversion of its own (see JsGraph); the functions above are its
+    // steps and want one in progress.
     jsvalue AnyFromV8(Handle<Value> value, Handle<Object> thisArg = Handle<Object>());
+    jsvalue ValueFromV8(Handle<Value> value, Handle<Object> thisArg = Handle<Object>());
+    // AnyFromV8 as much as mode (a JSRESULT_MODE_*) asks for.
+    jsvalue ResultFromV8(Handle<Value> value, int32_t mode);
+    // Through the current context's JSON.stringify and JSON.parse, for the
+    // callers that want plain data without building jsvalue trees. Undefined
+    // (and functions) serialize to NULL; JsonToV8 is empty if parse threw.
+    jsvalue JsonFromV8(Handle<Value> value, TryCatch& trycatch);
+    Handle<Value> JsonToV8(const char* json, int32_t length);
+
+	// Allocations for the jsvalue trees built by the conversions above. They
+	// come from the current JsArenaScope if any, else from the heap.
+	jsvalue *AllocArray(int32_t length);
+	uint16_t *AllocString(int32_t length);
+	uint8_t *AllocAsciiString(int32_t length);
+	jserror *AllocError();
+	void *AllocPacked(int32_t length, size_t element_size);
+	void FreePacked(void *elements);
+	inline JsArenaScope *GetArenaScope() { return arena_scope_; }
+	inline void SetArenaScope(JsArenaScope *scope) { arena_scope_ = scope; }
+	inline JsGraph *GetGraph() { return graph_; }
+	inline void SetGraph(JsGraph *graph) { graph_ = graph; }
+	inline const jspolicy *GetPolicy() { return policy_; }
+	inline void SetPolicy(const jspolicy *policy) { policy_ = policy; }
+	// The context the thread holding the lock last entered through a
+	// JsContextScope or a session; only meaningful to that thread.
+	inline JsContext *GetEnteredContext() { return entered_context_; }
+	inline void SetEnteredContext(JsContext *context) { entered_context_ = context; }
    
 	Persistent<Script> *CompileScript(const uint16_t* str, const uint16_t *resourceName, jsvalue *error);
 
+	// Script that captures the baseline of a fresh context, see JsContext::Reset().
+	Handle<Script> GetResetScript();
+
+	JsScriptCache *GetScriptCache() { return script_cache_; }
+
+	// Directory for the precompile data of CompileScript(), NULL to stop
+	// using it.
+	void SetPrecompileCache(const uint16_t *directory);
+
+	// Registers a property name once and returns the atom that stands for it
+	// from then on; the same name always gets the same atom. GetName() wants
+	// the locker held and gives an empty handle for unknown atoms.
+	int32_t InternName(const uint16_t *name);
+	inline Handle<String> GetName(int32_t atom) {
+		if (atom < 0 || atom >= (int32_t)names_.size())
+			return Handle<String>();
+		return names_[atom];
+	}
+
+	// Registers the shape of a CLR type: objects created with the returned
+	// type id (in the value of their JSVALUE_TYPE_MANAGED jsvalue) get a
+	// template of their own with an accessor or a prototype method per
+	// member, calling back with the member index. Type id 0 is the generic
+	// template with the named interceptor.
+	int32_t RegisterType(const uint16_t **names, const int32_t *kinds, int32_t count);
+
+	// What the CLR answered last time a property of this name was read on an
+	// object of the given type key, when that answer was "not found"
+	// (JSVALUE_TYPE_NOT_FOUND) or "not mine, ask the prototype"
+	// (JSVALUE_TYPE_EMPTY); -1 if unknown. Wants the locker held.
+	int32_t LookupMember(int32_t type_key, const uint16_t *name, int32_t length);
+	void StoreMember(int32_t type_key, const uint16_t *name, int32_t length, int32_t result);
+	void GetMemberCacheStats(jsmembercache_stats *stats);
+
 	// Converts JS function Arguments to an array of jsvalue to call managed code.
     jsvalue ArrayFromArguments(const Arguments& args);
 
 	Handle<Value> AnyToV8(jsvalue value, int32_t contextId); 
+	Handle<Value> BufferToV8(jsvalue value, int32_t contextId);
     // Needed to create an array of args on the stack for calling functions.
     int32_t ArrayToV8Args(jsvalue value, int32_t contextId, Handle<Value> preallocatedArgs[]);     
 
@@ -251,6 +797,17 @@ public:
     void DisposeObject(Persistent<Object>* obj);
 
 	void Dispose();
+
+	// Gets the engine ready for another owner: drops the delegates and
+	// collects whatever the previous owner left behind. Returns false if
+	// contexts or managed objects are still alive and the engine can't be
+	// reused.
+	bool Reset();
+
+	inline void ContextCreated() { INCREMENT(context_count_); }
+	inline void ContextDisposed() { DECREMENT(context_count_); }
+	inline void ManagedRefCreated() { INCREMENT(managed_ref_count_); }
+	inline void ManagedRefDeleted() { DECREMENT(managed_ref_count_); }
 	
 	void DumpHeapStats();
 	Isolate *GetIsolate() { return isolate_; }
@@ -261,11 +818,35 @@ public:
 	Persistent<Context> *global_context_;
 
 private:
-	inline JsEngine() {
+	inline JsEngine() : arena_scope_(NULL), graph_(NULL), policy_(&js_default_policy), entered_context_(NULL), context_count_(0), managed_ref_count_(0), reset_script_(NULL), script_cache_(NULL), precompile_cache_(NULL),
+		member_cache_hits_(0), member_cache_misses_(0), keepalive_get_member_(NULL), keepalive_set_member_(NULL), keepalive_invoke_member_(NULL), keepalive_indexed_(NULL),
+		keepalive_release_buffer_(NULL), keepalive_missing_property_(NULL) {
 		INCREMENT(js_mem_debug_engine_count);
 	}
 
+	void DisposeTypes();
+
 	Isolate *isolate_;
+	JsArenaScope *arena_scope_;
+	JsGraph *graph_;
+	const jspolicy *policy_;
+	JsContext *entered_context_;
+	long context_count_;
+	long managed_ref_count_;
+	Persistent<Script> *reset_script_;
+	JsScriptCache *script_cache_;
+	JsPrecompileCache *precompile_cache_;
+	std::vector<Persistent<String> > names_;
+	std::unordered_multimap<uint64_t, int32_t> name_index_;
+	std::vector<Persistent<FunctionTemplate> > type_templates_;
+	struct MemberCacheEntry {
+		int32_t type_key;
+		int32_t result;
+		std::vector<uint16_t> name;
+	};
+	std::unordered_multimap<uint64_t, MemberCacheEntry> member_cache_;
+	int64_t member_cache_hits_;
+	int64_t member_cache_misses_;
     
 	
 	Persistent<FunctionTemplate> *managed_template_;
@@ -278,25 +859,118 @@ private:
     keepalive_invoke_f keepalive_invoke_;
 	keepalive_delete_property_f keepalive_delete_property_;
 	keepalive_enumerate_properties_f keepalive_enumerate_properties_;
+	keepalive_get_member_f keepalive_get_member_;
+	keepalive_set_member_f keepalive_set_member_;
+	keepalive_invoke_member_f keepalive_invoke_member_;
+	keepalive_indexed_f keepalive_indexed_;
+	keepalive_release_buffer_f keepalive_release_buffer_;
+	keepalive_missing_property_f keepalive_missing_property_;
 };
 
 
+// A pool of ready to use engines, all with the same resource constraints. A
+// background thread keeps at least min_size idle engines around so that
+// acquiring one doesn't pay for Isolate::New and the templates; engines
+// given back are reset and kept, up to max_size idle ones.
+class JsEnginePool {
+public:
+	static JsEnginePool *New(int32_t min_size, int32_t max_size, int32_t max_young_space, int32_t max_old_space);
+
+	JsEngine *Acquire();
+	void Release(JsEngine *engine);
+	void GetStats(jsenginepool_stats *stats);
+	void Dispose();
+
+private:
+	inline JsEnginePool() {}
+
+	JsEngine *CreateEngine();
+	void Refill();
+
+	int32_t min_size_;
+	int32_t max_size_;
+	int32_t max_young_space_;
+	int32_t max_old_space_;
+
+	std::mutex mutex_;
+	std::condition_variable refill_needed_;
+	std::thread refill_thread_;
+	bool disposing_;
+	std::vector<JsEngine*> idle_;
+	jsenginepool_stats stats_;
+};
+
 class JsContext {
  public:
     static JsContext* New(int32_t id, JsEngine *engine);
      
     // Called by bridge to execute JS from managed code.
-    jsvalue Execute(const uint16_t* str, const uint16_t *resourceName);  
-	jsvalue Execute(JsScript *script);  
+    // A policy given here is used for this call only, instead of the
+    // context's own.
+    jsvalue Execute(const uint16_t* str, const uint16_t *resourceName, int32_t mode = JSRESULT_MODE_FULL, const jspolicy *policy = NULL);  
+	jsvalue Execute(JsScript *script, int32_t mode = JSRESULT_MODE_FULL, const jspolicy *policy = NULL);  
+	// Execute for a script returning records: the result is converted with
+	// the given keys as JSVALUE_TYPE_COLUMNS when it's an array of objects.
+	// Modes other than JSRESULT_MODE_FULL convert it as Execute() would.
+	jsvalue ExecuteColumns(const uint16_t* str, const uint16_t *resourceName, const uint16_t** names, int32_t count, int32_t mode = JSRESULT_MODE_FULL, const jspolicy *policy = NULL);
 
 	jsvalue GetGlobal();
-    jsvalue GetVariable(const uint16_t* name);
-    jsvalue SetVariable(const uint16_t* name, jsvalue value);
+    // Names are given either as strings or as atoms from JsEngine::InternName().
+    inline jsvalue GetVariable(const uint16_t* name) { return GetVariable(name, -1); }
+    inline jsvalue GetVariable(int32_t atom) { return GetVariable(NULL, atom); }
+    inline jsvalue SetVariable(const uint16_t* name, jsvalue value) { return SetVariable(name, -1, value); }
+    inline jsvalue SetVariable(int32_t atom, jsvalue value) { return SetVariable(NULL, atom, value); }
 	jsvalue GetPropertyNames(Persistent<Object>* obj);
-    jsvalue GetPropertyValue(Persistent<Object>* obj, const uint16_t* name);
-    jsvalue SetPropertyValue(Persistent<Object>* obj, const uint16_t* name, jsvalue value);
-    jsvalue InvokeProperty(Persistent<Object>* obj, const uint16_t* name, jsvalue args);
-    jsvalue InvokeFunction(Persistent<Function>* func, Persistent<Object>* thisArg, jsvalue args);
+    inline jsvalue GetPropertyValue(Persistent<Object>* obj, const uint16_t* name) { return GetPropertyValue(obj, name, -1); }
+    inline jsvalue GetPropertyValue(Persistent<Object>* obj, int32_t atom) { return GetPropertyValue(obj, NULL, atom); }
+    inline jsvalue SetPropertyValue(Persistent<Object>* obj, const uint16_t* name, jsvalue value) { return SetPropertyValue(obj, name, -1, value); }
+    inline jsvalue SetPropertyValue(Persistent<Object>* obj, int32_t atom, jsvalue value) { return SetPropertyValue(obj, NULL, atom, value); }
+    // Many properties under a single lock and context entry; the result is an
+    // array with a value (or an error) per name.
+    inline jsvalue GetPropertyValues(Persistent<Object>* obj, const uint16_t** names, int32_t count) { return GetPropertyValues(obj, names, NULL, count); }
+    inline jsvalue GetPropertyValues(Persistent<Object>* obj, const int32_t* atoms, int32_t count) { return GetPropertyValues(obj, NULL, atoms, count); }
+    inline jsvalue SetPropertyValues(Persistent<Object>* obj, const uint16_t** names, int32_t count, jsvalue values) { return SetPropertyValues(obj, names, NULL, count, values); }
+    inline jsvalue SetPropertyValues(Persistent<Object>* obj, const int32_t* atoms, int32_t count, jsvalue values) { return SetPropertyValues(obj, NULL, atoms, count, values); }
+    inline jsvalue InvokeProperty(Persistent<Object>* obj, const uint16_t* name, jsvalue args) { return InvokeProperty(obj, name, -1, args); }
+    inline jsvalue InvokeProperty(Persistent<Object>* obj, int32_t atom, jsvalue args) { return InvokeProperty(obj, NULL, atom, args); }
+    jsvalue InvokeFunction(Persistent<Function>* func, Persistent<Object>* thisArg, jsvalue args, int32_t mode = JSRESULT_MODE_FULL, const jspolicy *policy = NULL);
+    // The full conversion of a JSVALUE_TYPE_HANDLE (or WRAPPED) object.
+    jsvalue Convert(Persistent<Object>* obj);
+    // Paged access to the JSVALUE_TYPE_HANDLE arrays and strings left by
+    // JSRESULT_MODE_LAZY: only the elements or characters asked for are
+    // converted. Ranges past the end are cut short.
+    jsvalue GetArrayLength(Persistent<Object>* obj);
+    jsvalue GetArrayRange(Persistent<Object>* obj, int32_t start, int32_t count);
+    jsvalue ReadString(Persistent<Object>* obj, int32_t offset, int32_t count);
+    // Calls func once per argument set (an array of arrays) under a single
+    // lock; returns an array of results, with the error in place of the
+    // result for the calls that threw.
+    jsvalue InvokeBatch(Persistent<Function>* func, Persistent<Object>* thisArg, jsvalue argsets);
+    // The same with UTF-8 JSON in and out (see JsEngine::JsonFromV8); args is
+    // a JSON array of the arguments, or NULL for none.
+    jsvalue GetVariableJson(const uint16_t* name);
+    jsvalue SetVariableJson(const uint16_t* name, const char* json, int32_t length);
+    jsvalue InvokeFunctionJson(Persistent<Function>* func, Persistent<Object>* thisArg, const char* args, int32_t length);
+
+	// Brings the context back to a clean global for its next user. Returns
+	// true if that was done in place and false if a new V8 context had to be
+	// created because the previous user changed something we can't undo.
+	bool Reset();
+
+	// Keeps the isolate locked and the context entered on the calling thread
+	// until the matching EndSession(), so that the calls made in between
+	// skip that work; other threads wait for the session to end. Sessions
+	// nest, and must end on the thread (and in the managed callback, if any)
+	// they began in. EndSession() is false if there is no session to end
+	// there. Reset() and Dispose() end a session of the calling thread; with
+	// one open on another thread they wait for it to end.
+	void BeginSession();
+	bool EndSession();
+
+	// Copies policy in as the one of all the calls on this context (NULL for
+	// js_default_policy again); not while one is running. Reset() goes back
+	// to the default too.
+	void SetPolicy(const jspolicy *policy);
      
 	void Dispose();
      
@@ -309,21 +983,63 @@ class JsContext {
 	}
 
  private:             
-    inline JsContext() {
+    inline JsContext() : reset_check_(NULL), policy_(&js_default_policy), session_locker_(NULL), session_depth_(0) {
 		INCREMENT(js_mem_debug_context_count);
 	}
 
+	void CaptureBaseline();
+
+	// The name string if there is one, else the atom. Empty (and an error in
+	// *error) for an unknown atom.
+	Handle<String> NameOf(JsArenaScope &arena, const uint16_t* name, int32_t atom, jsvalue *error);
+	jsvalue GetVariable(const uint16_t* name, int32_t atom);
+	jsvalue SetVariable(const uint16_t* name, int32_t atom, jsvalue value);
+	jsvalue GetPropertyValue(Persistent<Object>* obj, const uint16_t* name, int32_t atom);
+	jsvalue SetPropertyValue(Persistent<Object>* obj, const uint16_t* name, int32_t atom, jsvalue value);
+	jsvalue GetPropertyValues(Persistent<Object>* obj, const uint16_t** names, const int32_t* atoms, int32_t count);
+	jsvalue SetPropertyValues(Persistent<Object>* obj, const uint16_t** names, const int32_t* atoms, int32_t count, jsvalue values);
+	jsvalue InvokeProperty(Persistent<Object>* obj, const uint16_t* name, int32_t atom, jsvalue args);
+
 	int32_t id_;
     Isolate *isolate_;
 	JsEngine *engine_;
 	Persistent<Context> *context_;
+	Persistent<Function> *reset_check_;
+	const jspolicy *policy_;
+	jspolicy own_policy_;
+	Locker *session_locker_;
+	JsContext *session_previous_;
+	int32_t session_depth_;
+
+	friend class JsContextScope;
+};
+
+// Locks the isolate and enters the context for one call, like a Locker, an
+// Isolate::Scope and Context::Enter() would, unless the thread already did
+// that for this context: in a session or when called back from managed code
+// in the middle of a call on the same context.
+class JsContextScope {
+public:
+	explicit JsContextScope(JsContext *context);
+	~JsContextScope();
+
+private:
+	JsContext *context_;
+	JsContext *previous_;
+	bool entered_;
+	// A Locker, constructed only when we need one.
+	union {
+		void *align_;
+		char locker_[sizeof(Locker)];
+	};
 };
 
 
 class ManagedRef {
  public:
-    inline explicit ManagedRef(JsEngine *engine, int32_t contextId, int id) : engine_(engine), contextId_(contextId), id_(id) {
+    inline explicit ManagedRef(JsEngine *engine, int32_t contextId, int id, int32_t typeKey = 0) : engine_(engine), contextId_(contextId), id_(id), typeKey_(typeKey) {
 		INCREMENT(js_mem_debug_managedref_count);
+		engine_->ManagedRefCreated();
 	}
     
     inline int32_t Id() { return id_; }
@@ -334,9 +1050,16 @@ class ManagedRef {
     Handle<Value> Invoke(const Arguments& args);
     Handle<Boolean> DeleteProperty(Local<String> name);
 	Handle<Array> EnumerateProperties();
+    Handle<Value> GetMember(int32_t member);
+    Handle<Value> SetMember(int32_t member, Local<Value> value);
+    Handle<Value> InvokeMember(int32_t member, const Arguments& args);
+    Handle<Value> GetElement(uint32_t index);
+    Handle<Value> SetElement(uint32_t index, Local<Value> value);
+    Handle<Array> EnumerateElements();
 
     ~ManagedRef() { 
 		engine_->CallRemove(contextId_, id_); 
+		engine_->ManagedRefDeleted();
 		DECREMENT(js_mem_debug_managedref_count);
 	}
     
@@ -344,9 +1067,11 @@ class ManagedRef {
     ManagedRef() {
 		INCREMENT(js_mem_debug_managedref_count);
 	}
+	Handle<Value> ThrowNotFound(Local<String> name, uint16_t* s);
 	int32_t contextId_;
 	JsEngine *engine_;
 	int32_t id_;
+	int32_t typeKey_;
 };
 
 #endif